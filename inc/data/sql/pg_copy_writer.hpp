@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace blitz_query_cpp::sql
+{
+    // encoding of column in binary COPY
+    enum class copy_type
+    {
+        Text, // any type which accepts text input, value is sent as is
+        Integer,
+        Bigint,
+        Double,
+        Boolean,
+        Uuid
+    };
+
+    // binary encoding of SQL type, Text for types which are not encoded
+    copy_type copy_type_of(std::string_view sql_type);
+
+    //////////////////////////////////////////////////////////////////////////
+    // copy_binary_writer builds data of COPY ... FROM STDIN (FORMAT binary).
+    // Values are encoded from their text straight to the buffer, so rows do
+    // not need intermediate strings and server does not parse text.
+    //////////////////////////////////////////////////////////////////////////
+    class copy_binary_writer
+    {
+        std::string buffer;
+
+        void write_int16(int16_t value);
+        void write_int32(int32_t value);
+        void write_int64(int64_t value);
+
+    public:
+        copy_binary_writer();
+
+        void begin_row(int16_t columns_count);
+        void write_null();
+        // returns false if text is not a valid value of type
+        bool write_value(copy_type type, std::string_view text);
+        // appends trailer, no rows can be written after it
+        std::string_view finish();
+    };
+}
@@ -1,24 +1,73 @@
 #pragma once
+#include <span>
 #include <string>
+#include <vector>
 #include "data/sql/sql_expr.hpp"
-#include "data/sql/expr_node.hpp"
 
 namespace blitz_query_cpp::sql
 {
+    enum class parameter_type
+    {
+        Text,
+        Integer,
+        Numeric,
+        Variable
+    };
+
+    // array value of parameter, {"a","b"}, elements are quoted so any text is valid
+    std::string pg_array_literal(std::span<const std::string_view> values);
+
+    enum class like_match
+    {
+        Prefix,
+        Suffix,
+        Contains
+    };
 
+    // LIKE pattern which matches value literally, prefix of "a%" is "a\\%%"
+    std::string pg_like_pattern(std::string_view value, like_match match);
+
+    // literal value moved out of query text or name of named parameter,
+    // refers to value of expression node
+    struct query_parameter
+    {
+        parameter_type type;
+        std::string_view value;
+    };
+
+    // Renders expression tree to PostgreSQL text. Output buffer is reused
+    // between render calls, rendering does not allocate per node.
+    // With parameterize_literals literals, LIMIT, OFFSET and named parameters
+    // are rendered as $n placeholders, so queries of the same shape have the
+    // same text.
     class postgresql_renderer
     {
-        std::vector<expr_node> node_stack;
         std::string buffer;
-        bool handle_binary_op(expr_node &current, std::string_view op);
-        bool handle_join(expr_node &current, std::string_view join_type);
-        void visit_children(expr_node &node, std::string_view separator = {}, std::string_view end = {});
-        void write_quoted_value(expr_node &node);
-        void push_value(std::string_view value);
-        void push_node(const sql_expr_t &node);
+        std::vector<query_parameter> parameters;
+        bool parameterize_literals;
+        int first_parameter;
+        bool render_node(const sql_node *node);
+        bool render_children(const sql_node *node, std::string_view separator = {});
+        bool render_clauses(const sql_node *node);
+        bool render_operand(sql_expr_type op, const sql_node *operand, bool first);
+        bool render_operands(const sql_node *node, std::string_view op);
+        bool render_binary_op(const sql_node *node, std::string_view op);
+        bool render_join(const sql_node *node, std::string_view join_type);
+        bool render_ordering(const sql_node *node, std::string_view direction);
+        void write_quoted_value(std::string_view value);
+        void write_string_literal(std::string_view value);
+        void write_literal(parameter_type type, std::string_view value);
 
     public:
+        // first_parameter_ is the number of the first literal placeholder,
+        // lower numbers are left for explicit parameters
+        explicit postgresql_renderer(bool parameterize_literals_ = false, int first_parameter_ = 1)
+            : parameterize_literals{parameterize_literals_}, first_parameter{first_parameter_}
+        {
+        }
+
         bool render(const sql::sql_expr_t &expr);
         const std::string &get_string() const { return buffer; }
+        const std::vector<query_parameter> &get_parameters() const { return parameters; }
     };
-}
\ No newline at end of file
+}
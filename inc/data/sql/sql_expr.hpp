@@ -6,19 +6,101 @@
 #include <vector>
 #include <initializer_list>
 #include <data/sql/sql_expr_type.hpp>
+#include <util/arena.hpp>
 
 namespace blitz_query_cpp::sql
 {
+    //////////////////////////////////////////////////////////////////////////
+    // SQL expression nodes live in arena. Builder functions below allocate
+    // nodes in the arena of the innermost arena_scope of current thread, or
+    // in thread default arena which grows until reset_default_arena.
+    // Requests build their trees in a scope of the request arena, default
+    // arena is for code outside of requests like tests and tools.
+    // sql_expr_t is a handle to a node, copying it does not copy the tree.
+    //////////////////////////////////////////////////////////////////////////
+
+    class arena_scope
+    {
+        arena_t *previous;
+
+    public:
+        explicit arena_scope(arena_t &arena);
+        ~arena_scope();
+
+        arena_scope(const arena_scope &) = delete;
+        arena_scope &operator=(const arena_scope &) = delete;
+    };
+
+    arena_t &current_arena();
+    // releases nodes built outside of any arena_scope on current thread,
+    // their expressions should not be used after it
+    void reset_default_arena();
+
+    // string which outlives the query, e.g. owned by schema. Stored in nodes without copying.
+    struct static_str
+    {
+        std::string_view value;
+    };
+
+    struct sql_str
+    {
+        std::string_view value;
+        bool is_static = false;
+
+        sql_str() = default;
+        sql_str(std::string_view value_) : value{value_} {}
+        sql_str(const char *value_) : value{value_} {}
+        sql_str(const std::string &value_) : value{value_} {}
+        sql_str(static_str value_) : value{value_.value}, is_static{true} {}
+    };
+
+    // clauses of SELECT in order of rendering
+    enum class select_clause
+    {
+        Columns,
+        From,
+        Joins,
+        Where,
+        Group,
+        Having,
+        Order,
+        Offset,
+        Limit,
+        Count
+    };
+
+    struct sql_node
+    {
+        sql_expr_type type = sql_expr_type::None;
+        std::string_view value;
+        sql_node **children = nullptr;
+        uint32_t children_count = 0;
+        uint32_t children_capacity = 0;
+        sql_node **clauses = nullptr; // select_clause::Count slots, allocated on first clause
+        bool to_one = false;          // join by unique key, joins at most one row
+
+        std::span<sql_node *const> get_children() const { return {children, children_count}; }
+        sql_node *clause(select_clause c) const { return clauses ? clauses[int(c)] : nullptr; }
+        void add_child(sql_node *child, arena_t &arena);
+    };
+
     struct sql_expr_t
     {
-        sql_expr_t() {}
-        sql_expr_t(sql_expr_type t, std::string_view val = {}) : type{t}, value{val} {}
-        sql_expr_t(sql_expr_type t, std::string_view val, sql_expr_t &&child) : type{t}, value{val}, children{std::move(child)} {}
+        sql_node *node = nullptr;
 
-        sql_expr_type type;
-        std::string value;
-        std::vector<sql_expr_t> children;
-        sql_expr_t &add_child(sql_expr_type t, std::string_view val = {});
+        sql_expr_t() {}
+        explicit sql_expr_t(sql_node *node_) : node{node_} {}
+        sql_expr_t(sql_expr_type t, sql_str val = {});
+        sql_expr_t(sql_expr_type t, sql_str val, sql_expr_t child);
+
+        sql_expr_type type() const { return node ? node->type : sql_expr_type::None; }
+        std::string_view value() const { return node ? node->value : std::string_view{}; }
+        std::span<sql_node *const> children() const { return node ? node->get_children() : std::span<sql_node *const>{}; }
+
+        sql_expr_t add_child(sql_expr_type t, sql_str val = {});
+        void add_child(sql_expr_t child);
+        // returns clause node of SELECT, creates it if missing
+        sql_expr_t clause(select_clause c);
     };
 
     //-----------------------------------
@@ -43,8 +125,7 @@ namespace blitz_query_cpp::sql
         sql_expr_t expr;
     };
 
-    inline from_expr_t from(const sql_expr_t &expr) { return from_expr_t{expr}; }       // copy expression
-    inline from_expr_t from(sql_expr_t &&expr) { return from_expr_t{std::move(expr)}; } // move from temporary
+    inline from_expr_t from(sql_expr_t expr) { return from_expr_t{expr}; }
 
     sql_expr_t &operator|(sql_expr_t &, from_expr_t &&);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, from_expr_t &&table) { return std::move(expr | std::move(table)); }
@@ -59,8 +140,7 @@ namespace blitz_query_cpp::sql
         sql_expr_t expr;
     };
 
-    inline where_expr_t where(const sql_expr_t &expr) { return where_expr_t{expr}; }       // copy expression
-    inline where_expr_t where(sql_expr_t &&expr) { return where_expr_t{std::move(expr)}; } // move from temporary
+    inline where_expr_t where(sql_expr_t expr) { return where_expr_t{expr}; }
 
     sql_expr_t &operator|(sql_expr_t &, where_expr_t &&);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, where_expr_t &&cond) { return std::move(expr | std::move(cond)); }
@@ -74,8 +154,7 @@ namespace blitz_query_cpp::sql
         sql_expr_t expr;
     };
 
-    inline or_expr_t or_else(const sql_expr_t &expr) { return or_expr_t{expr}; }       // copy expression
-    inline or_expr_t or_else(sql_expr_t &&expr) { return or_expr_t{std::move(expr)}; } // move from temporary
+    inline or_expr_t or_else(sql_expr_t expr) { return or_expr_t{expr}; }
 
     sql_expr_t &operator|(sql_expr_t &, or_expr_t &&);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, or_expr_t &&cond) { return std::move(expr | std::move(cond)); }
@@ -84,8 +163,7 @@ namespace blitz_query_cpp::sql
     // operations
     //-----------------------------------
 
-    sql_expr_t binary_operation(sql_expr_t &&a, binary_op op, sql_expr_t &&b);
-    sql_expr_t binary_operation(const sql_expr_t &a, binary_op op, const sql_expr_t &b);
+    sql_expr_t binary_operation(sql_expr_t a, binary_op op, sql_expr_t b);
 
     template <class T>
     sql_expr_t binary_operation(std::string_view column, binary_op op, T &&value)
@@ -114,16 +192,55 @@ namespace blitz_query_cpp::sql
     // table
     //-----------------------------------
 
-    inline sql_expr_t table(std::string_view name)
+    inline sql_expr_t table(sql_str name)
     {
         return {sql_expr_type::TableName, name};
     }
 
-    inline sql_expr_t table(std::string_view schema, std::string_view table)
+    inline sql_expr_t table(sql_str schema, sql_str table)
     {
         return {sql_expr_type::SchemaName, schema, {sql_expr_type::TableName, table}};
     }
 
+    //-----------------------------------
+    // functions and JSON
+    //-----------------------------------
+
+    sql_expr_t function(sql_str name, std::initializer_list<sql_expr_t> args);
+    sql_expr_t json_object(std::initializer_list<sql_expr_t> fields);
+
+    // count(*)
+    inline sql_expr_t count_all()
+    {
+        return {sql_expr_type::Function, static_str{"count"}, {sql_expr_type::Star}};
+    }
+
+    // window function over all rows of result, before LIMIT and OFFSET
+    inline sql_expr_t window(sql_expr_t function)
+    {
+        return {sql_expr_type::Window, {}, function};
+    }
+
+    inline sql_expr_t cast(sql_expr_t expr, sql_str type_name)
+    {
+        return {sql_expr_type::Cast, type_name, expr};
+    }
+
+    inline sql_expr_t json_field(sql_str key, sql_expr_t value)
+    {
+        return {sql_expr_type::JsonField, key, value};
+    }
+
+    inline sql_expr_t json_literal(sql_str value)
+    {
+        return {sql_expr_type::JsonLiteral, value};
+    }
+
+    inline sql_expr_t json_element(sql_expr_t array, int index)
+    {
+        return {sql_expr_type::JsonArrayElement, std::to_string(index), array};
+    }
+
     //-----------------------------------
     // column
     //-----------------------------------
@@ -134,29 +251,24 @@ namespace blitz_query_cpp::sql
         operator sql_expr_t &() { return expr; }
     };
 
-    inline column_t column(std::string_view table, std::string_view column)
+    inline column_t column(sql_str table, sql_str column)
     {
         return {{sql_expr_type::TableName, table, {sql_expr_type::Column, column}}};
     }
 
-    inline column_t column(std::string_view schema, std::string_view table, std::string_view column)
+    inline column_t column(sql_str schema, sql_str table, sql_str column)
     {
         return {{sql_expr_type::SchemaName, schema, {sql_expr_type::TableName, table, {sql_expr_type::Column, column}}}};
     }
 
-    inline sql_expr_t alias(sql_expr_t &&expr, std::string_view name)
-    {
-        return {sql_expr_type::Asias, name, std::move(expr)};
-    }
-
-    inline sql_expr_t alias(const sql_expr_t &expr, std::string_view name)
+    inline sql_expr_t alias(sql_expr_t expr, sql_str name)
     {
-        return {sql_expr_type::Asias, name, sql_expr_t{expr}};
+        return {sql_expr_type::Asias, name, expr};
     }
 
-    inline column_t alias(column_t &&expr, std::string_view name)
+    inline column_t alias(column_t &&expr, sql_str name)
     {
-        return {{sql_expr_type::Asias, name, std::move(expr.expr)}};
+        return {{sql_expr_type::Asias, name, expr.expr}};
     }
 
     sql_expr_t &operator|(sql_expr_t &, column_t &&);
@@ -173,7 +285,7 @@ namespace blitz_query_cpp::sql
         bool ascending;
     };
 
-    inline order_by_t order_by(column_t &&column, bool ascending = true) { return order_by_t{std::move(column), ascending}; }
+    inline order_by_t order_by(column_t &&column, bool ascending = true) { return order_by_t{column.expr, ascending}; }
     sql_expr_t &operator|(sql_expr_t &, order_by_t&&);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, order_by_t &&param) { return std::move(expr | std::move(param)); }
 
@@ -190,6 +302,16 @@ namespace blitz_query_cpp::sql
     sql_expr_t &operator|(sql_expr_t &, limit_t);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, limit_t param) { return std::move(expr | param); }
 
+    // LIMIT of expression, e.g. parameter
+    struct limit_expr_t
+    {
+        sql_expr_t expr;
+    };
+
+    inline limit_expr_t limit(sql_expr_t expr) { return limit_expr_t{expr}; }
+    sql_expr_t &operator|(sql_expr_t &, limit_expr_t &&);
+    inline sql_expr_t &&operator|(sql_expr_t &&expr, limit_expr_t &&param) { return std::move(expr | std::move(param)); }
+
     struct offset_t
     {
         int value;
@@ -199,6 +321,15 @@ namespace blitz_query_cpp::sql
     sql_expr_t &operator|(sql_expr_t &, offset_t);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, offset_t param) { return std::move(expr | param); }
 
+    struct offset_expr_t
+    {
+        sql_expr_t expr;
+    };
+
+    inline offset_expr_t offset(sql_expr_t expr) { return offset_expr_t{expr}; }
+    sql_expr_t &operator|(sql_expr_t &, offset_expr_t &&);
+    inline sql_expr_t &&operator|(sql_expr_t &&expr, offset_expr_t &&param) { return std::move(expr | std::move(param)); }
+
     //-----------------------------------
     // join
     //-----------------------------------
@@ -209,18 +340,29 @@ namespace blitz_query_cpp::sql
         sql_expr_t column1;
         sql_expr_t column2;
         join_kind kind;
+        bool to_one;
     };
 
-    inline join_t join(const sql_expr_t &expr, join_kind kind, const sql_expr_t &column1, const sql_expr_t &column2)
-    {
-        return join_t{expr, column1, column2, kind};
-    }
-
-    inline join_t join(sql_expr_t &&expr, join_kind kind, sql_expr_t &&column1, sql_expr_t &&column2)
+    // to_one tells that column2 is unique, so unused LEFT JOIN may be removed
+    inline join_t join(sql_expr_t expr, join_kind kind, sql_expr_t column1, sql_expr_t column2, bool to_one = false)
     {
-        return join_t{std::move(expr), std::move(column1), std::move(column2), kind};
+        return join_t{expr, column1, column2, kind, to_one};
     }
 
     sql_expr_t &operator|(sql_expr_t &, join_t &&);
     inline sql_expr_t &&operator|(sql_expr_t &&expr, join_t &&param) { return std::move(expr | std::move(param)); }
-}
\ No newline at end of file
+
+    // LEFT JOIN LATERAL (subquery) ON TRUE, subquery refers to preceding tables itself.
+    // to_one tells that subquery returns at most one row
+    struct lateral_join_t
+    {
+        sql_expr_t expr;
+        bool to_one;
+    };
+
+    inline lateral_join_t lateral_join(sql_expr_t expr, bool to_one = false) { return lateral_join_t{expr, to_one}; }
+
+    sql_expr_t &operator|(sql_expr_t &, lateral_join_t &&);
+    inline sql_expr_t &&operator|(sql_expr_t &&expr, lateral_join_t &&param) { return std::move(expr | std::move(param)); }
+    inline sql_expr_t &operator|=(sql_expr_t &expr, lateral_join_t &&param) { return expr | std::move(param); }
+}
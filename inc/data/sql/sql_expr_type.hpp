@@ -28,12 +28,16 @@ namespace blitz_query_cpp::sql
         LeftJoin,
         RightJoin,
         OuterJoin,
+        LeftJoinLateral,
         Where,
         Group,
         Having,
         Order,
         Offset,
         Limit,
+        Using,     // USING of DELETE
+        Returning, // RETURNING of INSERT, UPDATE and DELETE
+        OnConflict, // ON CONFLICT of INSERT, DO NOTHING or DO UPDATE of conflict columns row and SET
 
         
         All,
@@ -52,8 +56,20 @@ namespace blitz_query_cpp::sql
         Function,
         StringLiteral,
         NumberLiteral,
+        BoolLiteral,
         Parameter,
         Asias,
+        Row, // (a, b), row value
+        Null,
+        Star,   // * of count(*)
+        Window, // function OVER () of the whole result
+        Cast,   // expression::type
+
+        // JSON construction
+        JsonObject,       // json_build_object of JsonField children
+        JsonField,        // key and value of JSON object
+        JsonLiteral,      // 'value'::json
+        JsonArrayElement, // (array)->index
 
         // binary operations
         Plus,
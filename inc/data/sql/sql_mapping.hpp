@@ -0,0 +1,68 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <type_system/field_mask.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    struct object_type;
+    struct field;
+}
+
+namespace blitz_query_cpp::sql
+{
+    constexpr std::string_view TableDirective = "@table";
+    constexpr std::string_view ColumnDirective = "@column";
+    constexpr std::string_view AlwaysProjectedDirective = "@always_projected";
+    constexpr std::string_view RelationDirective = "@relation";
+    // @countMode(mode: estimate) of collection segment, totalCount is taken from planner statistics
+    constexpr std::string_view CountModeDirective = "@countMode";
+    // @bulk of mutation field, rows are inserted through COPY
+    constexpr std::string_view BulkDirective = "@bulk";
+    constexpr std::string_view DefaultSchema = "public";
+
+    bool pg_need_to_quote(std::string_view identifier);
+    // returns identifier in double quotes if it is not a lower case name
+    std::string pg_quote_identifier(std::string_view identifier);
+    // SQL type of GraphQL scalar, text for strings and unknown scalars
+    std::string_view pg_type_of(std::string_view graphql_type);
+    // SQL type of built-in GraphQL scalar, empty for ID, enums and custom
+    // scalars, column type of their values is not known
+    std::string_view pg_scalar_type(std::string_view graphql_type);
+
+    struct column_mapping
+    {
+        const field *field_decl = nullptr; // nullptr for fields not mapped to columns
+        std::string name;
+        std::string identifier; // quoted name
+        bool is_primary_key = false;
+        // @relation(fields:, references:) of object field, names of fields of declaring and related types
+        std::vector<std::string> relation_fields;
+        std::vector<std::string> relation_references;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    // table_mapping is built at schema compile for object types with @table
+    // directive. Columns are indexed by field index.
+    //////////////////////////////////////////////////////////////////////////
+
+    struct table_mapping
+    {
+        std::string schema_name;
+        std::string table_name; // empty if @table has no table name
+        std::string schema_identifier;
+        std::string table_identifier;
+        std::vector<column_mapping> columns;
+        std::vector<index_t> primary_key;      // field indexes of @column(IsPK: True) fields
+        std::vector<index_t> always_projected; // field indexes of @always_projected fields
+        field_mask primary_key_mask;          // empty for types without field masks
+        field_mask always_projected_mask;
+
+        const column_mapping &column(const field &field_decl) const;
+    };
+
+    // returns false if type has no @table directive
+    bool build_table_mapping(const object_type &type, table_mapping &mapping);
+}
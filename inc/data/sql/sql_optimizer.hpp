@@ -0,0 +1,24 @@
+#pragma once
+#include <data/sql/sql_expr.hpp>
+#include <util/enum.hpp>
+
+namespace blitz_query_cpp::sql
+{
+    enum class optimizer_pass : unsigned
+    {
+        None = 0,
+        DeduplicateColumns = 1 << 0, // removes repeated columns of subqueries and aliases equal to column name
+        FlattenConditions = 1 << 1,  // merges nested AND and OR operands
+        FoldConstants = 1 << 2,      // evaluates comparisons of literals and simplifies logic with constants
+        PushDownPredicates = 1 << 3, // moves WHERE conditions into subquery in FROM
+        EliminateJoins = 1 << 4,     // removes to one LEFT JOIN not referenced by the query
+        All = DeduplicateColumns | FlattenConditions | FoldConstants | PushDownPredicates | EliminateJoins
+    };
+
+    DECLARE_ENUM_OPERATIONS(optimizer_pass)
+
+    // Rewrites SELECT and its subqueries in place, new nodes are allocated in
+    // current arena. Rewrites keep meaning of nodes, so expressions sharing
+    // them stay valid. Subquery is copied before predicates are pushed into it.
+    void optimize(sql_expr_t &expr, optimizer_pass passes = optimizer_pass::All);
+}
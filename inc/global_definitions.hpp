@@ -7,5 +7,7 @@
 namespace blitz_query_cpp
 {
     using index_t = std::size_t;
+    using symbol_t = uint32_t; // interned name, see util/name_table.hpp
+    constexpr symbol_t NoSymbol = 0;
     constexpr int MaxBuiltInChildNodes = 16;
 }
\ No newline at end of file
@@ -12,6 +12,8 @@ namespace blitz_query_cpp
         index_t pos;
         index_t size;
         token_type type;
+        symbol_t symbol = NoSymbol; // interned name for Name and Directive tokens
+        uint64_t hash = 0;          // name hash for Name, Directive and ParameterLiteral tokens
 
         token_t(std::string_view token_value, index_t pos, index_t size, token_type type)
             : value(token_value), pos(pos), size(size), type(type)
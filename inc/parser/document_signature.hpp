@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    // Hash of document tokens. Whitespace, commas, comments and operation name
+    // do not change the signature, so the same query text sent by different
+    // clients gets the same value. Returns 0 for documents with invalid tokens.
+    uint64_t document_signature(std::string_view doc);
+    // also returns hashed token stream, see below
+    uint64_t document_signature(std::string_view doc, std::string &tokens);
+    // also collects variables used in @skip and @include conditions and as cursors
+    // of 'after' arguments, names are without '$'. Tokens are the hashed token
+    // stream, documents with equal tokens are the same, unlike ones with equal
+    // signatures which may collide.
+    uint64_t document_signature(std::string_view doc, std::vector<std::string_view> &condition_variables, std::string &tokens);
+}
@@ -3,7 +3,7 @@
 #include <lexica/token.hpp>
 #include <syntax/document.hpp>
 #include <error_code.hpp>
-#include <util/crc_hash.hpp>
+#include <util/name_hash.hpp>
 #include <util/enum.hpp>
 #include <format>
 #include <stack>
@@ -28,6 +28,8 @@ namespace blitz_query_cpp
         std::string error_msg;
         error_code_t error_code = error_code_t::OK;
         index_t last_token_end = 0;
+        symbol_t last_token_symbol = NoSymbol;
+        uint64_t last_token_hash = 0;
         std::string_view current_description;
 
     public:
@@ -1,6 +1,8 @@
 #pragma once
 #include <string_view>
 #include <lexica/token.hpp>
+#include <util/name_hash.hpp>
+#include <util/name_table.hpp>
 
 namespace blitz_query_cpp
 {
@@ -10,6 +12,7 @@ namespace blitz_query_cpp
         index_t current_pos = 0;
         index_t line_number = 0;
         index_t line_start = 0;
+        std::shared_ptr<const name_table::snapshot> names = name_table::global().get_snapshot(); // taken once per document
         inline auto chars_left() { return query.size() - current_pos; }
 
     public:
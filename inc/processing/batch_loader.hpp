@@ -0,0 +1,38 @@
+#pragma once
+
+#include <global_definitions.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // batch_loader serves one batch_load of a request. It collects distinct
+    // keys of parent rows, which are passed to batch query as $1, and groups
+    // rows of batch query by key, so every parent finds its rows by hash.
+    // Keys are values of result rows, they should outlive the loader.
+    //////////////////////////////////////////////////////////////////////////
+    class batch_loader
+    {
+        std::vector<std::string_view> keys;
+        std::unordered_map<std::string_view, std::vector<index_t>> rows;
+
+    public:
+        // parents with null key have no rows and are not added
+        void add_key(std::string_view key);
+        size_t keys_count() const { return keys.size(); }
+
+        // value of $1 parameter, PostgreSQL array of keys
+        std::string get_keys_parameter() const;
+        // all parameters of batch query, keys followed by values bound for
+        // the batch, see query_context::batch_parameter_values
+        std::vector<std::string> get_parameters(std::span<const std::string_view> batch_values) const;
+
+        // row of batch query, rows with keys not asked for are ignored
+        void add_row(std::string_view key, index_t row);
+        std::span<const index_t> get_rows(std::string_view key) const;
+    };
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <struct/query_context.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace blitz_query_cpp
+{
+    // Variants of the standard introspection query, same flags as getIntrospectionQuery in graphql-js
+    struct introspection_options
+    {
+        bool descriptions = true;
+        bool specified_by_url = false;
+        bool directive_is_repeatable = false;
+        bool schema_description = false;
+        bool input_value_deprecation = false;
+
+        static constexpr unsigned VariantsCount = 32;
+
+        unsigned key() const
+        {
+            return unsigned(descriptions) | unsigned(specified_by_url) << 1 | unsigned(directive_is_repeatable) << 2 |
+                   unsigned(schema_description) << 3 | unsigned(input_value_deprecation) << 4;
+        }
+
+        static introspection_options of_key(unsigned key)
+        {
+            return {(key & 1) != 0, (key & 2) != 0, (key & 4) != 0, (key & 8) != 0, (key & 16) != 0};
+        }
+    };
+
+    // text of the standard introspection query for given options
+    std::string introspection_query(const introspection_options &options);
+    // serialized response to introspection query, schema should be compiled
+    std::string introspection_response(const schema_t &schema, const introspection_options &options);
+
+    //////////////////////////////////////////////////////////////////////////
+    // introspection_cache keeps serialized introspection responses. Response is
+    // built once per schema version and options, outside of the lock.
+    // Known introspection queries are recognized by document signature and
+    // verified by their tokens, so they are answered without parsing.
+    //////////////////////////////////////////////////////////////////////////
+    class introspection_cache
+    {
+        struct schema_responses
+        {
+            uint64_t version = 0;
+            std::unordered_map<unsigned, std::shared_ptr<const std::string>> responses;
+        };
+
+        struct known_query
+        {
+            std::string tokens; // see document_signature
+            introspection_options options;
+        };
+
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, known_query> known_queries;
+        std::unordered_map<const schema_t *, schema_responses> schemas;
+
+    public:
+        // registers standard query with every combination of options
+        introspection_cache();
+
+        void register_query(std::string_view query, const introspection_options &options);
+        std::optional<introspection_options> find_query(std::string_view query) const;
+        std::shared_ptr<const std::string> get_response(const schema_t &schema, const introspection_options &options);
+        void remove_schema(const schema_t *schema);
+    };
+
+    class introspection_resolver
+    {
+        introspection_cache &cache;
+
+    public:
+        introspection_resolver(introspection_cache &cache_)
+            : cache{cache_}
+        {
+        }
+
+        bool process(query_context &context);
+    };
+}
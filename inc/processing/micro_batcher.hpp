@@ -0,0 +1,71 @@
+#pragma once
+
+#include <struct/query_context.hpp>
+#include <struct/query_plan.hpp>
+#include <processing/statement_executor.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    // Statement which runs plan for several sets of variables. Variables are
+    // passed as arrays and unnested WITH ORDINALITY, plan SQL is a LATERAL
+    // subquery, so first column of rows is 1 based number of variables set.
+    // Returns empty string if plan has no variables or can't be merged.
+    std::string merge_plan_sql(const compiled_plan &plan);
+
+    // Plans with batched selections are not merged, their batch queries take
+    // keys of all rows. Neither are plans with parameters derived from
+    // variables, like cursor values, LIKE patterns and arrays of lists, and
+    // variables of ID or custom scalar types; arrays of them could not be
+    // cast to SQL types of compared columns.
+    bool can_merge_plan(const compiled_plan &plan);
+
+    //////////////////////////////////////////////////////////////////////////
+    // micro_batcher merges concurrent requests of the same plan. First
+    // request of a plan waits up to window for other requests and runs all
+    // of them in one statement of merge_plan_sql, rows are split back by
+    // ordinal. It trades a bit of latency for fewer database round trips,
+    // so it is worth under load only.
+    //////////////////////////////////////////////////////////////////////////
+    class micro_batcher
+    {
+        struct pending_batch
+        {
+            std::vector<const std::vector<std::string_view> *> requests; // parameter values of requests
+            std::vector<std::vector<result_row>> results;
+            bool done = false;
+            bool succeeded = false;
+            std::exception_ptr error; // thrown by executor, rethrown to every request
+            std::condition_variable done_cv;
+        };
+
+        statement_executor executor;
+        std::chrono::microseconds window;
+        size_t max_batch_size;
+        std::mutex mutex;
+        std::unordered_map<const compiled_plan *, std::shared_ptr<pending_batch>> pending;
+        size_t statements_count = 0;
+
+        bool run_batch(const compiled_plan &plan, pending_batch &batch);
+
+    public:
+        explicit micro_batcher(statement_executor executor_, std::chrono::microseconds window_ = std::chrono::microseconds{1000}, size_t max_batch_size_ = 64)
+            : executor{std::move(executor_)}, window{window_}, max_batch_size{max_batch_size_}
+        {
+        }
+
+        // runs plan of context with context.parameter_values, blocks until rows of the request are ready.
+        // Exception of executor is rethrown to all requests of the batch
+        bool execute(query_context &context, std::vector<result_row> &rows);
+
+        // statements sent to database
+        size_t get_statements_count();
+    };
+}
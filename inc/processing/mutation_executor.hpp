@@ -0,0 +1,16 @@
+#pragma once
+
+#include <struct/query_context.hpp>
+#include <processing/statement_executor.hpp>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    // Runs statements of mutation plan with context.parameter_values in one
+    // transaction, rows[i] are rows returned by plan mutations[i]. Transaction
+    // is rolled back when a statement fails. Executors should run all
+    // statements on the same connection. Rows of bulk loads are sent by copy,
+    // or by multi-row INSERT statements of executor when copy is empty.
+    bool execute_mutation(query_context &context, const statement_executor &executor, std::vector<std::vector<result_row>> &rows,
+                          const copy_executor &copy = {});
+}
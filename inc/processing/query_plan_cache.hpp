@@ -0,0 +1,77 @@
+#pragma once
+
+#include <struct/query_context.hpp>
+#include <struct/query_plan.hpp>
+#include <processing/sql_query_optimizer.hpp>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // query_plan_cache keeps rendered SQL of operations. Plans are keyed by
+    // schema version, document signature, operation name, values of
+    // @skip/@include variables and presence of cursor variables, so cached
+    // request is neither parsed nor resolved, only its variables are bound
+    // to plan parameters.
+    //////////////////////////////////////////////////////////////////////////
+    class query_plan_cache
+    {
+        struct entry
+        {
+            std::shared_ptr<const compiled_plan> plan;
+            std::list<const plan_key *>::iterator use; // position in recently used keys
+        };
+
+        mutable std::mutex mutex;
+        std::unordered_map<plan_key, entry, plan_key_hash> plans;
+        std::list<const plan_key *> recently_used; // keys of plans, the most recent first
+        size_t max_plans;
+
+    public:
+        explicit query_plan_cache(size_t max_plans_ = 10000)
+            : max_plans{max_plans_}
+        {
+        }
+
+        std::shared_ptr<const compiled_plan> find(const plan_key &key);
+        // least recently used plan is evicted when cache is full, plans of old
+        // schema versions are not used and go away this way
+        void insert(const plan_key &key, std::shared_ptr<const compiled_plan> plan);
+        size_t size() const;
+        void clear();
+    };
+
+    // computes plan key of the request and takes plan from cache, should run before parsing
+    class query_plan_resolver
+    {
+        query_plan_cache &cache;
+
+    public:
+        query_plan_resolver(query_plan_cache &cache_)
+            : cache{cache_}
+        {
+        }
+
+        bool process(query_context &context);
+    };
+
+    // renders resolved SQL expression to a plan and stores it in cache
+    class query_plan_builder
+    {
+        query_plan_cache &cache;
+        sql_query_optimizer optimizer;
+        sql::postgresql_renderer renderer{true};
+        sql::postgresql_renderer batch_renderer{true, 2};
+
+    public:
+        query_plan_builder(query_plan_cache &cache_, sql::optimizer_pass passes = sql::optimizer_pass::All)
+            : cache{cache_}, optimizer{passes}
+        {
+        }
+
+        bool process(query_context &context);
+    };
+}
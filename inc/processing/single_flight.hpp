@@ -0,0 +1,73 @@
+#pragma once
+
+#include <struct/query_context.hpp>
+#include <struct/query_plan.hpp>
+#include <processing/statement_executor.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    // rows of one execution, shared by all requests which waited for it
+    using shared_rows = std::shared_ptr<const std::vector<result_row>>;
+
+    //////////////////////////////////////////////////////////////////////////
+    // single_flight runs identical concurrent requests once. Requests are
+    // identical when they have the same plan and the same parameter values.
+    // Request which comes while identical one is in flight waits for it and
+    // gets the same rows, nothing is kept after execution is done.
+    //////////////////////////////////////////////////////////////////////////
+    class single_flight
+    {
+        struct flight_key
+        {
+            const compiled_plan *plan = nullptr;
+            std::size_t parameters_hash = 0;
+
+            friend bool operator==(const flight_key &, const flight_key &) = default;
+        };
+
+        struct flight_key_hash
+        {
+            std::size_t operator()(const flight_key &key) const noexcept
+            {
+                return std::hash<const void *>{}(key.plan) * 31 + key.parameters_hash;
+            }
+        };
+
+        struct flight
+        {
+            const std::vector<std::string_view> *parameter_values; // of the first request
+            shared_rows rows;
+            std::exception_ptr error; // thrown by executor, rethrown to waiting requests
+            bool done = false;
+            std::condition_variable done_cv;
+        };
+
+        statement_executor executor;
+        std::mutex mutex;
+        std::unordered_map<flight_key, std::shared_ptr<flight>, flight_key_hash> flights;
+        std::atomic<size_t> executed_count = 0;
+        std::atomic<size_t> deduplicated_count = 0;
+
+    public:
+        explicit single_flight(statement_executor executor_)
+            : executor{std::move(executor_)}
+        {
+        }
+
+        // runs plan of context with context.parameter_values or waits for identical request.
+        // Exception of executor is rethrown to the waiting requests too
+        bool execute(query_context &context, shared_rows &rows);
+
+        // statements sent to database
+        size_t get_executed_count() const { return executed_count; }
+        // requests served by execution of another request
+        size_t get_deduplicated_count() const { return deduplicated_count; }
+    };
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <struct/query_context.hpp>
+#include <data/sql/sql_optimizer.hpp>
+
+namespace blitz_query_cpp
+{
+    // rewrites SQL expressions built by sql_query_resolver before they are rendered,
+    // query_plan_builder runs it on every plan it renders
+    class sql_query_optimizer
+    {
+        sql::optimizer_pass passes;
+
+    public:
+        explicit sql_query_optimizer(sql::optimizer_pass passes_ = sql::optimizer_pass::All)
+            : passes{passes_}
+        {
+        }
+
+        bool process(query_context &context);
+    };
+}
@@ -1,26 +1,80 @@
 #pragma once
 
 #include <struct/query_context.hpp>
+#include <data/sql/sql_mapping.hpp>
+#include <span>
 
 namespace blitz_query_cpp
 {
+    enum class result_format
+    {
+        Rows, // columns of selected fields, mapped to objects by result_shape
+        Json  // single json column with the whole data object
+    };
+
     class sql_query_resolver
     {
         static constexpr std::string Key = "sql";
-        static constexpr std::string_view TableDirective = "@table";
-        static constexpr std::string_view ColumnDirective = "@column";
-        static constexpr std::string_view IsProjected = "@always_projected";
-        static constexpr std::string_view DefaultSchama = "public";
 
+        // table of a selection set, nested selections are LEFT JOIN LATERAL subqueries
+        struct selection_level
+        {
+            const sql::table_mapping *mapping = nullptr;
+            std::string alias;
+            sql::sql_expr_t subquery; // empty for root level
+            std::vector<std::string_view> columns; // output columns of subquery
+            result_shape *shape = nullptr;
+            std::vector<std::pair<const sql::column_mapping *, index_t>> output; // selected and hidden columns by mapping
+            std::vector<const sql::column_mapping *> sort_keys;                  // keys of cursor
+        };
+
+        // call of mutation field, its input objects are rows
+        struct mutation_call
+        {
+            syntax_node *field_node = nullptr;
+            const field *field_decl = nullptr;
+            std::string_view operation; // insert, update or delete
+            const object_type *type = nullptr;
+            std::vector<syntax_node *> rows;
+            syntax_node *rows_variable = nullptr; // list variable of input objects of insert, rows are taken at bind
+            std::vector<const field *> columns; // fields of input objects, the same in every row
+            syntax_node *filter = nullptr;
+            std::vector<syntax_node *> keys; // primary key of every row when rows are found by key
+            // response key and field of selection, field is nullptr for count of changed rows
+            std::vector<std::pair<std::string_view, const field *>> selection;
+        };
+
+        result_format format;
+        index_t bulk_threshold; // inserts of this many rows are bulk loads, 0 if only @bulk fields are
         syntax_node *_operation;
         sql::sql_expr_t _query;
         std::string_view _table_name, _schema_name;
         int alias_number = 1;
+        int columns_count = 0;
+        bool need_keys = false;
         std::string current_selection_alias;
+        selection_key _selection;
 
         bool process_query(query_context &context);
         bool process_mutation(query_context &context);
-        bool process_field(query_context &context, const field &field_decl);
+        static bool parse_mutation_call(query_context &context, syntax_node *field_node, mutation_call &call);
+        static bool can_merge(const mutation_call &a, const mutation_call &b);
+        static sql::sql_expr_t returning(const mutation_call &call, const std::string &alias_name, sql::sql_expr_t ordinal, mutation_statement &statement);
+        bool add_mutation_statement(query_context &context, std::span<const mutation_call> calls);
+        bool process_field(query_context &context, selection_level &level, const sql::column_mapping &column, std::string_view response_key);
+        static int find_output_column(const selection_level &level, const sql::column_mapping &column);
+        bool process_selection(query_context &context, selection_level &level, const object_type &type, syntax_node *selection_set, field_mask &selected);
+        bool process_relation(query_context &context, selection_level &parent, const field &field_decl, syntax_node *field_node);
+        bool process_batched_relation(query_context &context, selection_level &parent, const field &field_decl, syntax_node *field_node);
+        index_t output_column(selection_level &level, const sql::column_mapping &column);
+        // page is _query or subquery of root table, see process_query
+        bool process_paging(query_context &context, selection_level &level, const object_type &type, syntax_node *segment, sql::sql_expr_t &page);
+        bool process_total_count(query_context &context, selection_level &level, const object_type &type, const field &segment_field, syntax_node *segment);
+        bool process_json_selection(query_context &context, const sql::table_mapping &mapping, const std::string &alias, const object_type &type,
+                                    syntax_node *selection_set, sql::sql_expr_t &query, sql::sql_expr_t &object, field_mask &selected);
+        bool process_json_relation(query_context &context, const sql::table_mapping &parent_mapping, const std::string &parent_alias, const object_type &parent_type,
+                                   const field &field_decl, syntax_node *field_node, sql::sql_expr_t &query, sql::sql_expr_t &value);
+        sql::column_t level_column(selection_level &level, std::string_view identifier);
         std::string next_alias_name()
         {
             std::string alias = "_a" + std::to_string(alias_number);
@@ -29,7 +83,17 @@ namespace blitz_query_cpp
         }
 
     public:
+        static constexpr index_t DefaultBulkThreshold = 0;
+
+        explicit sql_query_resolver(result_format format_ = result_format::Rows, index_t bulk_threshold_ = DefaultBulkThreshold)
+            : format{format_}, bulk_threshold{bulk_threshold_}
+        {
+        }
+
         bool process(query_context &context);
+
+        // fields of the root selection including always projected ones
+        const selection_key &get_selection() const { return _selection; }
     };
 
 }
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    // text values of result row
+    using result_row = std::vector<std::string>;
+
+    // runs statement with text parameters
+    using statement_executor = std::function<bool(const std::string &sql, const std::vector<std::string> &parameters, std::vector<result_row> &rows)>;
+
+    // runs COPY ... FROM STDIN with data, on connection of statement_executor
+    using copy_executor = std::function<bool(const std::string &sql, std::string_view data)>;
+}
@@ -57,6 +57,22 @@ namespace blitz_query_cpp
         using WriterT::_options;
         bool _first_value_in_object = true;
 
+        void open_container(char c)
+        {
+            _nesting_level++;
+            _first_value_in_object = true;
+            write_char(c);
+        }
+
+        void close_container(char c)
+        {
+            _nesting_level--;
+            write_newline();
+            write_indent(_nesting_level);
+            write_char(c);
+            _first_value_in_object = false;
+        }
+
     public:
         using WriterT::write;
         using WriterT::write_char;
@@ -123,46 +139,64 @@ namespace blitz_query_cpp
             return true;
         }
 
+        // writes comma before array items
+        void write_separator()
+        {
+            if (!_first_value_in_object)
+                write_char(',');
+            _first_value_in_object = false;
+        }
+
+        void write_null()
+        {
+            write("null");
+        }
+
+        void write_null(std::string_view name)
+        {
+            write_name(name);
+            write_null();
+        }
+
+        template <class T>
+        void write_item(T v)
+        {
+            write_separator();
+            write_value(v);
+        }
+
         void begin_object()
         {
-            _nesting_level++;
-            _first_value_in_object = true;
-            write_char('{');
+            write_separator();
+            open_container('{');
         }
 
         void begin_object(std::string_view name)
         {
             write_name(name);
-            begin_object();
+            open_container('{');
         }
 
         void end_object()
         {
-            _nesting_level--;
-            write_newline();
-            write_indent(_nesting_level);
-            write_char('}');
+            close_container('}');
         }
 
         void begin_array()
         {
-            _nesting_level++;
-            _first_value_in_object = true;
-            write_char('[');
+            write_separator();
+            open_container('[');
         }
 
         void begin_array(std::string_view name)
         {
             write_name(name);
-            begin_array();
+            open_container('[');
         }
 
         void end_array()
         {
-            _nesting_level--;
-            write_newline();
-            write_indent(_nesting_level);
-            write_char(']');
+            close_container(']');
         }
 
         template <class T>
@@ -10,9 +10,28 @@
 #include <syntax/syntax_node.hpp>
 #include <syntax/document.hpp>
 #include <data/sql/sql_expr.hpp>
+#include <struct/query_plan.hpp>
+#include <memory>
 
 namespace blitz_query_cpp
 {
+    // complete serialized response, later processing stages are skipped
+    struct json_response
+    {
+        std::string data;
+    };
+
+    // wraps data object built by database, text is copied without decoding
+    inline json_response json_data_response(std::string_view data)
+    {
+        json_response res;
+        res.data.reserve(data.size() + 9);
+        res.data.append("{\"data\":");
+        res.data.append(data);
+        res.data.append(1, '}');
+        return res;
+    }
+
     struct query_context
     {
         query_context(const schema_t *schema_, std::string doc)
@@ -22,10 +41,49 @@ namespace blitz_query_cpp
 
         const schema_t *schema;
         document_t document;
+        std::string operation_name;
+        // raw variable values, true and false for booleans, JSON arrays for lists
+        std::unordered_map<std::string, std::string> variables;
+        // SQL expression of the result is allocated here
+        arena_t arena;
         std::unordered_map<std::string, std::string> data;
-        std::variant<sql::sql_expr_t> result;
+        std::variant<sql::sql_expr_t, json_response, std::shared_ptr<const compiled_plan>> result;
+        result_shape shape;
+        // selections loaded by separate queries, batch_queries are rendered to batches[i].sql
+        std::vector<batch_load> batches;
+        std::vector<sql::sql_expr_t> batch_queries;
+        // statements of mutation, mutation_queries are rendered to mutations[i].sql
+        std::vector<mutation_statement> mutations;
+        std::vector<sql::sql_expr_t> mutation_queries;
+        // key of the plan for this request, set by query_plan_resolver
+        plan_key plan_cache_key;
+        // values of plan parameters, point to plan, to variables or to derived_values
+        std::vector<std::string_view> parameter_values;
+        // values of parameters of every batch_load of the plan, from $2
+        std::vector<std::vector<std::string_view>> batch_parameter_values;
+        // values computed from variables at bind: decoded cursors by variable, LIKE patterns by parameter
+        std::unordered_map<std::string, std::vector<std::string>> derived_values;
+        // rows of bulk loads of list variables by mutation, taken at bind, see bulk_load
+        std::vector<std::vector<bulk_value>> bulk_values;
         std::vector<std::string> error_msgs;
 
+        bool has_response() const
+        {
+            return std::holds_alternative<json_response>(result);
+        }
+
+        const compiled_plan *get_plan() const
+        {
+            auto plan = std::get_if<std::shared_ptr<const compiled_plan>>(&result);
+            return plan ? plan->get() : nullptr;
+        }
+
+        // document does not need to be parsed and resolved
+        bool is_resolved() const
+        {
+            return !std::holds_alternative<sql::sql_expr_t>(result);
+        }
+
         bool report_error(std::string_view msg)
         {
             error_msgs.emplace_back(msg);
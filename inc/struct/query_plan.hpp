@@ -0,0 +1,154 @@
+#pragma once
+
+#include <global_definitions.hpp>
+#include <data/sql/postgresql_renderer.hpp>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    struct query_context;
+    struct object_type;
+
+    // identifies operation whose SQL does not change between requests
+    struct plan_key
+    {
+        uint64_t schema_version = 0;
+        uint64_t signature = 0;
+        std::string tokens; // document tokens, signature hit is verified by them
+        std::string operation_name;
+        uint64_t conditions = 0; // bit i is set when i-th @skip/@include or cursor variable is given and not false or null
+
+        friend bool operator==(const plan_key &, const plan_key &) = default;
+    };
+
+    struct plan_key_hash
+    {
+        std::size_t operator()(const plan_key &key) const noexcept
+        {
+            std::size_t res = std::hash<uint64_t>{}(key.signature);
+            res = res * 31 + std::hash<uint64_t>{}(key.schema_version);
+            res = res * 31 + std::hash<uint64_t>{}(key.conditions);
+            return res * 31 + std::hash<std::string>{}(key.operation_name);
+        }
+    };
+
+    // value of SQL parameter, constant or taken from request variable
+    struct plan_parameter
+    {
+        sql::parameter_type type;
+        std::string value; // variable name for Variable type
+        std::string sql_type; // SQL type of declared variable, empty if it is not known, see pg_scalar_type
+    };
+
+    // Maps result rows to objects. Each selection takes a range of columns:
+    // fields in order, then hidden key columns, then nested selections.
+    // Fields are response keys, a field selected under several aliases is
+    // one column shared by their entries in field_columns.
+    // Rows with the same key columns belong to the same object.
+    // Batched selection takes columns of rows of its own batch query.
+    struct result_shape
+    {
+        const object_type *type = nullptr;
+        std::string root_field; // response key of selection
+        std::vector<std::string> fields;
+        std::vector<index_t> field_columns; // output column of every field
+        bool is_list = false;
+        bool is_json = false; // single column with data object, see json_data_response
+        index_t first_column = 0;
+        index_t hidden_columns = 0;
+        std::vector<index_t> key_columns;
+        int batch = -1; // index of batch_load which loads rows of selection
+        // collection segment, selection is its list of items. One row more
+        // than page size is fetched, it tells that the next page exists.
+        std::string segment_field;
+        index_t page_size = 0;
+        std::string page_size_variable; // take is a variable
+        std::vector<index_t> cursor_columns; // sort key of row, see encode_cursor
+        int total_count_column = -1;         // totalCount of segment in every row, -1 if it is not selected
+        std::vector<result_shape> children;
+    };
+
+    // Selection which is not joined to its parent. It is loaded by one query
+    // for all parent rows, WHERE key = ANY($1) with distinct parent keys, and
+    // rows are distributed to parents by key, see batch_loader. Parameters of
+    // filters of the selection follow the keys from $2.
+    struct batch_load
+    {
+        std::string sql;
+        std::vector<plan_parameter> parameters;
+        index_t parent_key_column = 0; // in rows of parent selection
+        index_t key_column = 0;        // in rows of batch query, first column
+    };
+
+    // value of row of bulk load, literal or name of variable
+    struct bulk_value
+    {
+        std::string value;
+        bool is_variable = false;
+        bool is_null = false;
+    };
+
+    // Rows of large insert are copied to temporary table by binary COPY FROM
+    // STDIN, then statement inserts them all by INSERT ... SELECT. Data of
+    // COPY is encoded at execution from values, see execute_mutation. Without
+    // copy executor rows go to the table by multi-row insert_sql instead.
+    // Rows of list variable of input objects are taken from it at bind.
+    struct bulk_load
+    {
+        std::string create_sql; // temporary table which is dropped on commit
+        std::string copy_sql;
+        std::string insert_sql; // INSERT ... VALUES, rows of parameters are appended
+        std::vector<std::string> column_types; // SQL types of columns of temporary table
+        std::vector<bulk_value> values;        // row by row
+        std::string rows_variable;             // list variable of rows, values are empty then
+        std::vector<std::string> input_fields; // field of input objects of every column
+    };
+
+    // Statement of mutation fields. Statements of operation run in order in one
+    // transaction, see execute_mutation. Adjacent calls of the same mutation
+    // field are merged, every input object is a row of VALUES.
+    struct mutation_statement
+    {
+        std::string sql;
+        index_t first_parameter = 0; // parameters of statement are a range of plan parameters
+        index_t parameters_count = 0;
+        std::string operation;   // insert, update or delete
+        std::string object_name; // type of table
+        // response key of every row of VALUES, the only one for statement of single call
+        std::vector<std::string> row_fields;
+        // first column of returned rows is 1 based row of VALUES, rows of INSERT come in order of VALUES
+        // or of rows of bulk load instead. Conflicting rows of bulk load which are skipped are not returned.
+        bool ordinal_column = false;
+        // selected columns of returned rows of every call, shape.first_column follows ordinal.
+        // Fields of count_fields are numbers of rows returned for call.
+        result_shape shape;
+        std::vector<std::string> count_fields;
+        bulk_load bulk; // empty copy_sql if rows are in sql
+
+        bool is_bulk() const { return !bulk.copy_sql.empty(); }
+    };
+
+    // name of plan parameter which is LIKE pattern of variable, it is computed at bind
+    std::string like_parameter_name(std::string_view variable, sql::like_match match);
+    bool parse_like_parameter_name(std::string_view name, std::string_view &variable, sql::like_match &match);
+
+    // name of plan parameter which is array of items of list variable, it is computed at bind
+    std::string list_parameter_name(std::string_view variable);
+    bool parse_list_parameter_name(std::string_view name, std::string_view &variable);
+
+    struct compiled_plan
+    {
+        std::string sql;
+        std::vector<plan_parameter> parameters;
+        result_shape shape;
+        std::vector<batch_load> batches;
+        std::vector<mutation_statement> mutations; // sql is empty for mutation
+
+        // fills context.parameter_values for SQL parameters and
+        // context.batch_parameter_values for parameters of batches
+        bool bind(query_context &context) const;
+    };
+}
@@ -31,6 +31,8 @@ namespace blitz_query_cpp
         syntax_node_type type;
         std::string_view content;
         std::string_view name;
+        symbol_t name_symbol = NoSymbol;
+        uint64_t name_hash_code = 0; // computed by tokenizer, see util/name_hash.hpp
         std::string_view alias;
         std::string_view description;
         syntax_node *parent = nullptr;
@@ -1,8 +1,12 @@
 
 #pragma once
 #include <type_system/schema.hpp>
+#include <memory>
 
 namespace blitz_query_cpp
 {
+    // immutable schema with built-in scalars, directives and introspection types
+    std::shared_ptr<const schema_t> builtin_schema();
+    // makes built-in types visible in schema without copying them
     bool add_introspection_types(schema_t &schema);
 }
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <bit>
+#include <functional>
+
+namespace blitz_query_cpp
+{
+    // Types with more fields have no field masks
+    constexpr index_t MaxMaskFields = 128;
+
+    //////////////////////////////////////////////////////////////////////////
+    // field_mask is a set of fields of one object type, bit i stands for the
+    // field with index i. Used as a cheap selection key and to merge and
+    // compare selections without string work.
+    //////////////////////////////////////////////////////////////////////////
+
+    class field_mask
+    {
+        static constexpr index_t WordBits = 64;
+        static constexpr index_t WordsCount = MaxMaskFields / WordBits;
+        uint64_t words[WordsCount] = {};
+
+    public:
+        void set(index_t index) { words[index / WordBits] |= uint64_t(1) << (index % WordBits); }
+        void reset(index_t index) { words[index / WordBits] &= ~(uint64_t(1) << (index % WordBits)); }
+        bool test(index_t index) const { return (words[index / WordBits] >> (index % WordBits)) & 1; }
+
+        // sets bit and returns true if it was not set before
+        bool insert(index_t index)
+        {
+            if (test(index))
+                return false;
+            set(index);
+            return true;
+        }
+
+        bool empty() const
+        {
+            for (uint64_t word : words)
+            {
+                if (word)
+                    return false;
+            }
+            return true;
+        }
+
+        index_t count() const
+        {
+            index_t res = 0;
+            for (uint64_t word : words)
+                res += std::popcount(word);
+            return res;
+        }
+
+        // calls func for every set bit in ascending order
+        template <class F>
+        void for_each(F &&func) const
+        {
+            for (index_t w = 0; w < WordsCount; w++)
+            {
+                for (uint64_t word = words[w]; word; word &= word - 1)
+                    func(w * WordBits + std::countr_zero(word));
+            }
+        }
+
+        field_mask &operator|=(const field_mask &other)
+        {
+            for (index_t w = 0; w < WordsCount; w++)
+                words[w] |= other.words[w];
+            return *this;
+        }
+
+        field_mask &operator&=(const field_mask &other)
+        {
+            for (index_t w = 0; w < WordsCount; w++)
+                words[w] &= other.words[w];
+            return *this;
+        }
+
+        // removes fields of other mask
+        field_mask &operator-=(const field_mask &other)
+        {
+            for (index_t w = 0; w < WordsCount; w++)
+                words[w] &= ~other.words[w];
+            return *this;
+        }
+
+        friend field_mask operator|(field_mask a, const field_mask &b) { return a |= b; }
+        friend field_mask operator&(field_mask a, const field_mask &b) { return a &= b; }
+        friend field_mask operator-(field_mask a, const field_mask &b) { return a -= b; }
+        friend bool operator==(const field_mask &, const field_mask &) = default;
+
+        std::size_t hash() const
+        {
+            std::size_t res = 0;
+            for (uint64_t word : words)
+                res = res * 0x9E3779B97F4A7C15ull + std::hash<uint64_t>{}(word);
+            return res;
+        }
+    };
+
+    // selected fields of an object type
+    struct selection_key
+    {
+        const struct object_type *type = nullptr;
+        field_mask fields;
+
+        friend bool operator==(const selection_key &, const selection_key &) = default;
+    };
+
+    struct selection_key_hash
+    {
+        std::size_t operator()(const selection_key &key) const noexcept
+        {
+            return std::hash<const void *>{}(key.type) ^ key.fields.hash();
+        }
+    };
+}
@@ -1,9 +1,12 @@
 #pragma once
 #include <global_definitions.hpp>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <optional>
 #include <type_system/type_system_classes.hpp>
+#include <util/arena.hpp>
 
 namespace blitz_query_cpp
 {
@@ -14,32 +17,91 @@ namespace blitz_query_cpp
         const object_type *mutation_type = nullptr;
 
     public:
+        // immutable schema with types shared between many schemas, own types shadow its types
+        std::shared_ptr<const schema_t> base;
         named_collection<object_type> types;
         named_collection<directive_type> directive_types;
         std::vector<directive> directives;
+        // storage for directive parameters and default values
+        arena_t values;
+        symbol_map<const object_type> types_by_symbol;
+        // unique for every compiled state of the schema, 0 if schema is not compiled
+        uint64_t version = 0;
 
         std::string query_type_name;
         std::string mutation_type_name;
 
+        // type name -> names of types referencing it by field, argument or implements clause.
+        // Filled by compile and used to recompile only affected types on schema extension.
+        std::unordered_map<std::string, std::unordered_set<std::string>, name_hash, std::equal_to<>> type_dependents;
+
     public:
         const directive_type *find_directive_type(std::string_view name) const
         {
-            auto dir = std::find_if(directive_types.begin(), directive_types.end(),
-                                    [name](auto &dir)
-                                    {
-                                        return dir.name == name;
-                                    });
-            if (dir == directive_types.end())
-                return nullptr;
-            return &*dir;
+            auto dir = directive_types.find(name);
+            if (dir != directive_types.end())
+                return &*dir;
+            return base ? base->find_directive_type(name) : nullptr;
         }
 
         const object_type *find_type(std::string_view name) const
         {
             auto type = types.find(name);
-            if (type == types.end())
-                return nullptr;
-            return &*type;
+            if (type != types.end())
+                return &*type;
+            return base ? base->find_type(name) : nullptr;
+        }
+
+        const object_type *find_type(symbol_t symbol, hashed_name name) const
+        {
+            if (const object_type *type = types_by_symbol.find(symbol))
+                return type;
+            auto type = types.find(name);
+            if (type != types.end())
+                return &*type;
+            return base ? base->find_type(symbol, name) : nullptr;
+        }
+
+        // types of base schemas refer to base versions of types changed by upper layers,
+        // returns version of the type visible in this schema
+        const object_type *current_type(const object_type *type) const
+        {
+            if (!type || !base)
+                return type;
+            for (const schema_t *layer = this; layer; layer = layer->base.get())
+            {
+                if (const object_type *current = layer->types_by_symbol.find(type->symbol))
+                    return current;
+            }
+            return type;
+        }
+
+        // calls func for every type visible in schema including types of base schemas
+        template <class F>
+        void for_each_type(F &&func) const
+        {
+            for (const schema_t *layer = this; layer; layer = layer->base.get())
+            {
+                for (const object_type &type : layer->types)
+                {
+                    // skip types shadowed by upper layer
+                    if (find_type(type.name) == &type)
+                        func(type);
+                }
+            }
+        }
+
+        template <class F>
+        void for_each_directive_type(F &&func) const
+        {
+            for (const schema_t *layer = this; layer; layer = layer->base.get())
+            {
+                for (const directive_type &dir : layer->directive_types)
+                {
+                    if (find_directive_type(dir.name) == &dir)
+                        func(dir);
+                }
+            }
         }
 
         const object_type *get_query_type() const
@@ -7,9 +7,22 @@
 
 namespace blitz_query_cpp
 {
+    struct schema_compile_options
+    {
+        // number of threads used to resolve types, results are the same as for serial compilation
+        unsigned threads = 1;
+        // number of types processed by a thread at once
+        index_t grain_size = 64;
+    };
+
     class schema_parser_t
     {
+        schema_compile_options options;
+        arena_t *values_arena = nullptr;
         std::string error_msg;
+        // types defined or extended since last compilation
+        std::unordered_set<std::string> changed_types;
+        bool directive_types_changed = false;
 
         template <class... Args>
         bool report_error(std::string_view fmt, Args &&...args)
@@ -36,10 +49,22 @@ namespace blitz_query_cpp
         bool process_input_value(input_value &value, const syntax_node &node);
         bool process_filed_type(input_value &value, const syntax_node &node);
         bool process_arguments(named_collection<input_value> &arguments, const syntax_node &enum_field_node);
-        bool process_parameter_value(parameter_value &param, const syntax_node &value_node);
-        bool process_params(named_collection<parameter_value> &arguments, const syntax_node &node);
+        bool process_parameter_value(value_t &value, const syntax_node &value_node);
+        bool process_params(parameter_list &arguments, const syntax_node &node);
+
+        void mark_changed(const syntax_node &definition);
+        bool copy_from_base(schema_t &schema, std::string_view type_name);
+        void copy_on_write(schema_t &schema, const syntax_node &definition);
+        bool compile_types(schema_t &schema, const std::vector<object_type *> &types);
+        void index_type(schema_t &schema, object_type &type);
+        void resolve_root_types(schema_t &schema);
 
     public:
+        schema_parser_t(const schema_compile_options &options_ = {})
+            : options{options_}
+        {
+        }
+
         std::string_view get_error_msg() const { return error_msg; }
 
         bool parse(schema_t &schema, std::string_view schema_string);
@@ -69,5 +94,9 @@ namespace blitz_query_cpp
         }
 
         bool compile(schema_t &schema);
+
+        // parses schema extension document and recompiles only changed types and types depending on them
+        bool extend(schema_t &schema, std::string_view extension_string);
+        bool compile_changed(schema_t &schema);
     };
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <type_system/schema.hpp>
+#include <format>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // schema_registry keeps named immutable schemas. A schema may be layered
+    // over another registered schema: it owns only types defined or changed
+    // by its own document, all other types are shared with the base schema.
+    // Registered schemas are never modified, replacing a schema does not
+    // affect schemas layered over its previous version.
+    //////////////////////////////////////////////////////////////////////////
+
+    class schema_registry
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<const schema_t>, name_hash, std::equal_to<>> schemas;
+        std::string error_msg;
+
+        template <class... Args>
+        bool report_error(std::string_view fmt, Args &&...args)
+        {
+            error_msg = std::vformat(fmt, std::make_format_args(args...));
+            return false;
+        }
+
+        bool add(std::string_view name, std::shared_ptr<const schema_t> base, std::string_view schema_string);
+
+    public:
+        // adds schema layered over built-in types
+        bool add_schema(std::string_view name, std::string_view schema_string);
+        // adds schema layered over registered schema, schema_string may define and extend types
+        bool add_schema(std::string_view name, std::string_view base_name, std::string_view schema_string);
+        bool remove_schema(std::string_view name);
+
+        std::shared_ptr<const schema_t> find(std::string_view name) const;
+        size_t size() const;
+
+        // copy, error may be replaced by other thread
+        std::string get_error_msg() const
+        {
+            std::shared_lock lock{mutex};
+            return error_msg;
+        }
+    };
+}
@@ -2,9 +2,14 @@
 #include <global_definitions.hpp>
 #include <type_system/type_kind.hpp>
 #include <type_system/value_kind.hpp>
+#include <type_system/value.hpp>
+#include <type_system/field_mask.hpp>
 #include <syntax/directive_target.hpp>
+#include <util/symbol_map.hpp>
+#include <util/name_hash.hpp>
 #include <unordered_set>
 #include <algorithm>
+#include <memory>
 #include <vector>
 #include <string_view>
 #include <string>
@@ -12,16 +17,21 @@
 
 namespace blitz_query_cpp
 {
+    namespace sql
+    {
+        struct table_mapping;
+    }
+
     struct name_hash
     {
-        using hash_type = std::hash<std::string_view>;
         using is_transparent = void;
 
-        std::size_t operator()(const char *str) const noexcept { return hash_type{}(str); }
-        std::size_t operator()(std::string_view str) const noexcept { return hash_type{}(str); }
-        std::size_t operator()(std::string const &str) const noexcept { return hash_type{}(str); }
+        std::size_t operator()(const char *str) const noexcept { return hash_name(str); }
+        std::size_t operator()(std::string_view str) const noexcept { return hash_name(str); }
+        std::size_t operator()(std::string const &str) const noexcept { return hash_name(str); }
+        std::size_t operator()(const hashed_name &name) const noexcept { return name.hash; }
         template <class T>
-        std::size_t operator()(const T &named_obj) const noexcept { return hash_type{}(named_obj.name); }
+        std::size_t operator()(const T &named_obj) const noexcept { return hash_name(named_obj.name); }
     };
 
     template <class T>
@@ -31,6 +41,8 @@ namespace blitz_query_cpp
 
         bool operator()(const T &a, const std::string_view &name) const noexcept { return a.name == name; }
         bool operator()(const std::string_view &name, const T &a) const noexcept { return a.name == name; }
+        bool operator()(const T &a, const hashed_name &name) const noexcept { return a.name == name.name; }
+        bool operator()(const hashed_name &name, const T &a) const noexcept { return a.name == name.name; }
         bool operator()(const T &a, const T &b) const noexcept { return a.name == b.name; }
     };
 
@@ -56,6 +68,7 @@ namespace blitz_query_cpp
 
         std::string name;
         std::string description;
+        symbol_t symbol = NoSymbol; // assigned at schema compile
     };
 
     struct directive_type : type_system_object
@@ -70,18 +83,6 @@ namespace blitz_query_cpp
         named_collection<struct input_value> arguments;
     };
 
-    struct parameter_value : type_system_object
-    {
-        using type_system_object::type_system_object;
-
-        value_kind value_type = value_kind::None;
-        std::string string_value;
-        long long int_value = 0;
-        double float_value = 0;
-        bool bool_value = false;
-        named_collection<parameter_value> fields;
-    };
-
     struct directive
     {
         directive() = default;
@@ -89,7 +90,7 @@ namespace blitz_query_cpp
 
         std::string name;
         const directive_type *directive_type = nullptr;
-        named_collection<parameter_value> parameters;
+        parameter_list parameters; // stored in schema values arena
     };
 
     struct type_system_object_with_directives : type_system_object
@@ -130,7 +131,7 @@ namespace blitz_query_cpp
         {
             return (field_type_nullability & (1 << list_nesting_depth)) != 0 || (default_value.value_type != value_kind::None && default_value.value_type != value_kind::Null);
         }
-        parameter_value default_value;
+        value_t default_value;
         type_reference declaring_type;
         type_reference field_type;
         uint32_t field_type_nullability = 0;
@@ -156,5 +157,21 @@ namespace blitz_query_cpp
         type_kind kind;
         named_collection<field> fields;
         named_collection<type_reference> implements;
+        symbol_map<const field> fields_by_symbol;
+        std::shared_ptr<const sql::table_mapping> sql_mapping; // built at compile for types with @table directive
+
+        // field index is used as a bit in field_mask
+        bool has_field_mask() const { return fields.size() <= MaxMaskFields; }
+
+        const field *find_field(symbol_t symbol, hashed_name name) const
+        {
+            if (const field *res = fields_by_symbol.find(symbol))
+                return res;
+            // name was not interned when document was parsed
+            auto res = fields.find(name);
+            if (res == fields.end())
+                return nullptr;
+            return &*res;
+        }
     };
 }
\ No newline at end of file
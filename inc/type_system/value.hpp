@@ -0,0 +1,76 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <type_system/value_kind.hpp>
+#include <string_view>
+#include <algorithm>
+
+namespace blitz_query_cpp
+{
+    struct parameter_value;
+    class parameter_list;
+
+    // Compact tagged value used for directive parameters, default values and variables.
+    // Strings and child lists are not owned, they live in arena of the schema or request.
+    struct value_t
+    {
+        value_kind value_type = value_kind::None;
+        uint32_t size = 0; // string length or count of fields
+        union
+        {
+            bool bool_value;
+            long long int_value = 0;
+            double float_value;
+            const char *string_data;
+            const parameter_value *fields_data;
+        };
+
+        std::string_view string_value() const
+        {
+            if (value_type != value_kind::String && value_type != value_kind::Enum)
+                return {};
+            return std::string_view(string_data, size);
+        }
+
+        // object fields or list items
+        inline parameter_list fields() const;
+    };
+
+    static_assert(sizeof(value_t) <= 16);
+
+    struct parameter_value
+    {
+        std::string_view name; // empty for list items
+        value_t value;
+    };
+
+    class parameter_list
+    {
+        const parameter_value *_begin = nullptr;
+        const parameter_value *_end = nullptr;
+
+    public:
+        parameter_list() = default;
+        parameter_list(const parameter_value *begin, index_t size) : _begin{begin}, _end{begin + size} {}
+
+        const parameter_value *begin() const { return _begin; }
+        const parameter_value *end() const { return _end; }
+        index_t size() const { return _end - _begin; }
+        bool empty() const { return _begin == _end; }
+        const parameter_value &operator[](index_t index) const { return _begin[index]; }
+
+        const parameter_value *find(std::string_view name) const
+        {
+            return std::find_if(_begin, _end, [name](const parameter_value &param)
+                                { return param.name == name; });
+        }
+
+        bool contains(std::string_view name) const { return find(name) != end(); }
+    };
+
+    parameter_list value_t::fields() const
+    {
+        if (value_type != value_kind::List && value_type != value_kind::Object)
+            return {};
+        return parameter_list(fields_data, size);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // arena_t is a monotonic allocator. Memory is taken from big blocks and
+    // released all at once when arena is destroyed or reset.
+    // Only trivially destructible objects should be placed in arena.
+    //////////////////////////////////////////////////////////////////////////
+
+    class arena_t
+    {
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        std::byte *current = nullptr;
+        index_t space_left = 0;
+        index_t block_size;
+        index_t first_block_size = 0;
+        index_t bytes_allocated = 0;
+
+        void *allocate_block(index_t size, index_t align)
+        {
+            index_t new_block_size = std::max(block_size, size + align);
+            if (blocks.empty())
+                first_block_size = new_block_size;
+            blocks.emplace_back(new std::byte[new_block_size]);
+            current = blocks.back().get();
+            space_left = new_block_size;
+            return try_allocate(size, align);
+        }
+
+        void *try_allocate(index_t size, index_t align)
+        {
+            index_t padding = (align - reinterpret_cast<std::uintptr_t>(current) % align) % align;
+            if (padding + size > space_left)
+                return nullptr;
+            std::byte *res = current + padding;
+            current = res + size;
+            space_left -= padding + size;
+            bytes_allocated += size;
+            return res;
+        }
+
+    public:
+        explicit arena_t(index_t block_size_ = 4096)
+            : block_size{block_size_}
+        {
+        }
+
+        arena_t(const arena_t &) = delete;
+        arena_t &operator=(const arena_t &) = delete;
+        arena_t(arena_t &&) = default;
+        arena_t &operator=(arena_t &&) = default;
+
+        void *allocate(index_t size, index_t align = alignof(std::max_align_t))
+        {
+            if (void *res = try_allocate(size, align))
+                return res;
+            return allocate_block(size, align);
+        }
+
+        template <class T>
+        T *allocate_array(index_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "arena does not call destructors");
+            if (count == 0)
+                return nullptr;
+            T *res = static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+            std::uninitialized_default_construct_n(res, count);
+            return res;
+        }
+
+        template <class T, class... Args>
+        T *create(Args &&...args)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "arena does not call destructors");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        std::string_view store(std::string_view value)
+        {
+            if (value.empty())
+                return {};
+            char *res = static_cast<char *>(allocate(value.size(), 1));
+            std::memcpy(res, value.data(), value.size());
+            return std::string_view(res, value.size());
+        }
+
+        // keeps the first block for reuse
+        void reset()
+        {
+            if (blocks.size() > 1)
+                blocks.erase(blocks.begin() + 1, blocks.end());
+            current = blocks.empty() ? nullptr : blocks.front().get();
+            space_left = blocks.empty() ? 0 : first_block_size;
+            bytes_allocated = 0;
+        }
+
+        index_t allocated_bytes() const { return bytes_allocated; }
+        index_t blocks_count() const { return blocks.size(); }
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // Cursor of keyset pagination is opaque for clients. It holds sort key
+    // values of the last row of a page, length prefixed and base64 encoded.
+    // Next page starts after the row with these key values.
+    //////////////////////////////////////////////////////////////////////////
+
+    std::string encode_cursor(std::span<const std::string_view> values);
+
+    // returns false if cursor is not produced by encode_cursor
+    bool decode_cursor(std::string_view cursor, std::vector<std::string> &values);
+
+    // name of plan parameter which takes value index of cursor in variable,
+    // values are taken from variable when plan is bound
+    std::string cursor_parameter_name(std::string_view variable, index_t index);
+
+    // splits cursor parameter name, returns false for regular variables
+    bool parse_cursor_parameter_name(std::string_view name, std::string_view &variable, index_t &index);
+}
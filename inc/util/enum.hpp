@@ -6,19 +6,19 @@
 //////////////////////////////////////////////////////////////////////////
 
 #define DECLARE_ENUM_OPERATIONS(ENUM_NAME)                               \
-inline ENUM_NAME                                                         \
+constexpr ENUM_NAME                                                      \
 operator|(ENUM_NAME left, ENUM_NAME right)                               \
 { return ENUM_NAME(static_cast<int>(left) | static_cast<int>(right)); }  \
                                                                          \
-inline ENUM_NAME                                                         \
+constexpr ENUM_NAME                                                      \
 operator&(ENUM_NAME left, ENUM_NAME right)                               \
 { return ENUM_NAME(static_cast<int>(left) & static_cast<int>(right)); }  \
                                                                          \
-inline ENUM_NAME                                                         \
+constexpr ENUM_NAME                                                      \
 operator^(ENUM_NAME left, ENUM_NAME right)                               \
 { return ENUM_NAME(static_cast<int>(left) ^ static_cast<int>(right)); }  \
                                                                          \
-inline ENUM_NAME                                                         \
+constexpr ENUM_NAME                                                      \
 operator~(ENUM_NAME left)                                                \
 { return ENUM_NAME(~static_cast<int>(left)); }                           \
                                                                          \
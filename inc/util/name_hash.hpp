@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <string_view>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // 64-bit FNV-1a hash used for all names. Tokenizer computes it while
+    // scanning name bytes, so a name from request is hashed only once.
+    //////////////////////////////////////////////////////////////////////////
+
+    constexpr uint64_t NameHashInit = 14695981039346656037ull;
+    constexpr uint64_t NameHashPrime = 1099511628211ull;
+
+    constexpr uint64_t name_hash_update(uint64_t hash, char ch)
+    {
+        return (hash ^ uint8_t(ch)) * NameHashPrime;
+    }
+
+    constexpr uint64_t hash_name(std::string_view str)
+    {
+        uint64_t hash = NameHashInit;
+        for (char ch : str)
+            hash = name_hash_update(hash, ch);
+        return hash;
+    }
+
+    constexpr uint64_t operator""_name_hash(const char *str, size_t size)
+    {
+        return hash_name(std::string_view(str, size));
+    }
+
+    // name with precomputed hash for heterogeneous lookups in named collections
+    struct hashed_name
+    {
+        std::string_view name;
+        uint64_t hash;
+    };
+}
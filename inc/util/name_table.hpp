@@ -0,0 +1,79 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <util/name_hash.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // name_table maps names to 32-bit symbols. It is append only: once
+    // interned, symbol of a name never changes. Names are interned at schema
+    // compile time, parser attaches symbols to name tokens, so schema lookups
+    // are done by integer instead of string.
+    //
+    // Readers never lock: intern only changes the writer side, freeze
+    // publishes an immutable snapshot of it which is swapped atomically.
+    // Schema compile freezes the table when it is done interning.
+    //////////////////////////////////////////////////////////////////////////
+
+    class name_table
+    {
+        struct view_hash
+        {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view str) const noexcept { return hash_name(str); }
+            std::size_t operator()(const hashed_name &name) const noexcept { return name.hash; }
+        };
+
+        struct view_equal
+        {
+            using is_transparent = void;
+            bool operator()(std::string_view a, std::string_view b) const noexcept { return a == b; }
+            bool operator()(std::string_view a, const hashed_name &b) const noexcept { return a == b.name; }
+            bool operator()(const hashed_name &a, std::string_view b) const noexcept { return a.name == b; }
+        };
+
+        using symbols_map = std::unordered_map<std::string_view, symbol_t, view_hash, view_equal>;
+
+    public:
+        // immutable state of the table, safe to read from any thread
+        class snapshot
+        {
+            friend class name_table;
+            std::vector<std::string_view> names; // symbol - 1 is index of the name
+            symbols_map symbols;
+
+        public:
+            symbol_t find(std::string_view name) const { return find(name, hash_name(name)); }
+            symbol_t find(std::string_view name, uint64_t hash) const;
+            std::string_view name(symbol_t symbol) const;
+            index_t size() const { return names.size(); }
+        };
+
+    private:
+        std::mutex mutex;
+        std::deque<std::string> names; // strings never move, snapshots reference them
+        symbols_map symbols;
+        std::atomic<std::shared_ptr<const snapshot>> current{std::make_shared<const snapshot>()};
+
+    public:
+        static name_table &global();
+
+        symbol_t intern(std::string_view name);
+        // publishes names interned since last freeze to readers
+        void freeze();
+        std::shared_ptr<const snapshot> get_snapshot() const { return current.load(std::memory_order_acquire); }
+
+        symbol_t find(std::string_view name) const { return get_snapshot()->find(name); }
+        symbol_t find(std::string_view name, uint64_t hash) const { return get_snapshot()->find(name, hash); }
+        std::string_view name(symbol_t symbol) const { return get_snapshot()->name(symbol); }
+        index_t size() const { return get_snapshot()->size(); }
+    };
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <global_definitions.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // parallel_for runs func(index) for every index in [0, count) on up to
+    // thread_count threads. Range is split evenly between workers, a worker
+    // that is done with its own part steals chunks from the other parts.
+    // Returns false if any call returned false, remaining work is skipped then.
+    //////////////////////////////////////////////////////////////////////////
+
+    template <class F>
+    bool parallel_for(index_t count, unsigned thread_count, F &&func, index_t grain_size = 16)
+    {
+        if (count == 0)
+            return true;
+        grain_size = std::max<index_t>(grain_size, 1);
+        thread_count = std::max(1u, std::min<unsigned>(thread_count, unsigned((count + grain_size - 1) / grain_size)));
+
+        if (thread_count == 1)
+        {
+            for (index_t i = 0; i < count; i++)
+            {
+                if (!func(i))
+                    return false;
+            }
+            return true;
+        }
+
+        struct alignas(64) work_range
+        {
+            std::atomic<index_t> next;
+            index_t end;
+        };
+
+        std::unique_ptr<work_range[]> ranges{new work_range[thread_count]};
+        for (unsigned i = 0; i < thread_count; i++)
+        {
+            ranges[i].next = count * i / thread_count;
+            ranges[i].end = count * (i + 1) / thread_count;
+        }
+
+        std::atomic<bool> failed = false;
+
+        auto run_range = [&](work_range &range)
+        {
+            while (!failed.load(std::memory_order_relaxed))
+            {
+                index_t begin = range.next.fetch_add(grain_size, std::memory_order_relaxed);
+                if (begin >= range.end)
+                    return;
+                index_t end = std::min(begin + grain_size, range.end);
+                for (index_t i = begin; i < end; i++)
+                {
+                    if (!func(i))
+                    {
+                        failed = true;
+                        return;
+                    }
+                }
+            }
+        };
+
+        auto worker = [&](unsigned worker_index)
+        {
+            for (unsigned i = 0; i < thread_count; i++)
+                run_range(ranges[(worker_index + i) % thread_count]);
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(thread_count - 1);
+        for (unsigned i = 1; i < thread_count; i++)
+            threads.emplace_back(worker, i);
+        worker(0);
+        for (auto &thread : threads)
+            thread.join();
+
+        return !failed;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <util/name_table.hpp>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    //////////////////////////////////////////////////////////////////////////
+    // symbol_map is an open addressing table from symbol to pointer.
+    // Lookup is an array access plus integer compare.
+    //////////////////////////////////////////////////////////////////////////
+
+    template <class T>
+    class symbol_map
+    {
+        struct entry
+        {
+            symbol_t key = NoSymbol;
+            T *value = nullptr;
+        };
+
+        std::vector<entry> entries;
+        index_t count = 0;
+
+        index_t slot(symbol_t key) const { return (key * 0x9E3779B1u) & (entries.size() - 1); }
+
+        void grow()
+        {
+            std::vector<entry> old = std::move(entries);
+            entries.assign(old.empty() ? 16 : old.size() * 2, entry{});
+            count = 0;
+            for (auto &e : old)
+            {
+                if (e.key != NoSymbol)
+                    insert_or_assign(e.key, e.value);
+            }
+        }
+
+    public:
+        void clear()
+        {
+            entries.clear();
+            count = 0;
+        }
+
+        void insert_or_assign(symbol_t key, T *value)
+        {
+            if (key == NoSymbol)
+                return;
+            if ((count + 1) * 2 > entries.size())
+                grow();
+            index_t mask = entries.size() - 1;
+            for (index_t i = slot(key);; i = (i + 1) & mask)
+            {
+                if (entries[i].key == key)
+                {
+                    entries[i].value = value;
+                    return;
+                }
+                if (entries[i].key == NoSymbol)
+                {
+                    entries[i] = entry{key, value};
+                    count++;
+                    return;
+                }
+            }
+        }
+
+        T *find(symbol_t key) const
+        {
+            if (key == NoSymbol || entries.empty())
+                return nullptr;
+            index_t mask = entries.size() - 1;
+            for (index_t i = slot(key);; i = (i + 1) & mask)
+            {
+                if (entries[i].key == key)
+                    return entries[i].value;
+                if (entries[i].key == NoSymbol)
+                    return nullptr;
+            }
+        }
+
+        index_t size() const { return count; }
+    };
+}
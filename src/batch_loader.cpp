@@ -0,0 +1,40 @@
+#include <processing/batch_loader.hpp>
+#include <data/sql/postgresql_renderer.hpp>
+
+namespace blitz_query_cpp
+{
+    void batch_loader::add_key(std::string_view key)
+    {
+        if (rows.try_emplace(key).second)
+            keys.push_back(key);
+    }
+
+    std::string batch_loader::get_keys_parameter() const
+    {
+        return sql::pg_array_literal(keys);
+    }
+
+    std::vector<std::string> batch_loader::get_parameters(std::span<const std::string_view> batch_values) const
+    {
+        std::vector<std::string> res;
+        res.reserve(batch_values.size() + 1);
+        res.push_back(get_keys_parameter());
+        res.insert(res.end(), batch_values.begin(), batch_values.end());
+        return res;
+    }
+
+    void batch_loader::add_row(std::string_view key, index_t row)
+    {
+        auto key_rows = rows.find(key);
+        if (key_rows != rows.end())
+            key_rows->second.push_back(row);
+    }
+
+    std::span<const index_t> batch_loader::get_rows(std::string_view key) const
+    {
+        auto key_rows = rows.find(key);
+        if (key_rows == rows.end())
+            return {};
+        return key_rows->second;
+    }
+}
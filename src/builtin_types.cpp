@@ -1,143 +1,299 @@
 #include <type_system/type_system_classes.hpp>
 #include <type_system/schema.hpp>
 #include <type_system/schema_parser.hpp>
+#include <type_system/builtin_types.hpp>
 #include <iostream>
+#include <span>
 
 namespace blitz_query_cpp
 {
-    std::string_view introspection_schema = R""""(
-
-scalar Int
-scalar Float
-scalar String
-scalar Boolean
-scalar Long
-
-directive @skip(if: Boolean!) on FIELD | FRAGMENT_SPREAD | INLINE_FRAGMENT
-directive @include(if: Boolean!) on FIELD | FRAGMENT_SPREAD | INLINE_FRAGMENT
-directive @deprecated(reason: String = "No longer supported") on FIELD
-directive @specifiedBy(url: String!) on SCALAR
-
-
-scalar UUID @specifiedBy(url: "https://tools.ietf.org/html/rfc4122")
-
-"""
-Represents an ISO-8601 compliant date time type.
-"""
-scalar DateTime  @specifiedBy(url: "https://scalars.graphql.org/andimarek/date-time")
-
-
-"A GraphQL Schema containes all available types and directives on the server and the entry points for query, mutation, and subscription operations."
-type __Schema {
-  description: String
-  "A list of all types in this schema."
-  types: [__Type!]!
-  "The root type for query operations."
-  queryType: __Type!
-  "The root type for mutation operations."
-  mutationType: __Type
-  "The root type for subscription operations."
-  subscriptionType: __Type
-  "A list of all directives in this schema."
-  directives: [__Directive!]!
-}
+    //////////////////////////////////////////////////////////////////////////
+    // Built-in scalars, directives and introspection types are described by
+    // static tables. Schema with these types is built once from the tables
+    // and shared by all schemas as their base schema.
+    //////////////////////////////////////////////////////////////////////////
 
+    struct builtin_type_ref
+    {
+        std::string_view name;
+        uint32_t nullability = 0; // bit is set for nullable level, level 0 is the outermost one
+        int list_depth = 0;
+    };
 
-type __Type {
-  kind: __TypeKind!
-  name: String
-  description: String
-  "must be non-null for OBJECT and INTERFACE, otherwise null."
-  fields(includeDeprecated: Boolean = false): [__Field!]
-  "must be non-null for OBJECT and INTERFACE, otherwise null."
-  interfaces: [__Type!]
-  "must be non-null for INTERFACE and UNION, otherwise null."
-  possibleTypes: [__Type!]
-  "must be non-null for ENUM, otherwise null."
-  enumValues(includeDeprecated: Boolean = false): [__EnumValue!]
-  "must be non-null for INPUT_OBJECT, otherwise null."
-  inputFields(includeDeprecated: Boolean = false): [__InputValue!]
-  "must be non-null for NON_NULL and LIST, otherwise null."
-  ofType: __Type
-  "may be non-null for custom SCALAR, otherwise null."
-  specifiedByURL: String
-}
+    // parses type reference like "[__Type!]!" at compile time
+    consteval builtin_type_ref type_ref(std::string_view sdl)
+    {
+        builtin_type_ref res;
+        while (sdl.front() == '[')
+        {
+            if (sdl.back() == '!')
+                sdl.remove_suffix(1);
+            else
+                res.nullability |= 1u << res.list_depth;
+            sdl.remove_prefix(1);
+            sdl.remove_suffix(1);
+            res.list_depth++;
+        }
+        if (sdl.back() == '!')
+            sdl.remove_suffix(1);
+        else
+            res.nullability |= 1u << res.list_depth;
+        res.name = sdl;
+        return res;
+    }
 
-enum __TypeKind {
-  SCALAR
-  OBJECT
-  INTERFACE
-  UNION
-  ENUM
-  INPUT_OBJECT
-  LIST
-  NON_NULL
-}
+    struct builtin_input_value
+    {
+        std::string_view name;
+        builtin_type_ref type;
+        std::string_view description = {};
+        value_kind default_kind = value_kind::None;
+        std::string_view default_value = {};
+    };
 
-type __Field {
-  name: String!
-  description: String
-  args(includeDeprecated: Boolean = false): [__InputValue!]!
-  type: __Type!
-  isDeprecated: Boolean!
-  deprecationReason: String
-}
+    struct builtin_field
+    {
+        std::string_view name;
+        builtin_type_ref type;
+        std::string_view description = {};
+        std::span<const builtin_input_value> arguments = {};
+    };
 
-type __InputValue {
-  name: String!
-  description: String
-  type: __Type!
-  defaultValue: String
-  isDeprecated: Boolean!
-  deprecationReason: String
-}
+    struct builtin_type
+    {
+        type_kind kind;
+        std::string_view name;
+        std::string_view description = {};
+        std::span<const builtin_field> fields = {};
+        std::span<const std::string_view> enum_values = {};
+        std::string_view specified_by = {};
+    };
 
-type __EnumValue {
-  name: String!
-  description: String
-  isDeprecated: Boolean!
-  deprecationReason: String
-}
+    struct builtin_directive
+    {
+        std::string_view name;
+        directive_target_t target;
+        std::span<const builtin_input_value> arguments;
+        std::string_view description = {};
+    };
 
-type __Directive {
-  name: String!
-  description: String
-  locations: [__DirectiveLocation!]!
-  args(includeDeprecated: Boolean = false): [__InputValue!]!
-  isRepeatable: Boolean!
-}
+    static constexpr std::string_view SpecifiedByDirective = "@specifiedBy";
 
-enum __DirectiveLocation {
-  QUERY
-  MUTATION
-  SUBSCRIPTION
-  FIELD
-  FRAGMENT_DEFINITION
-  FRAGMENT_SPREAD
-  INLINE_FRAGMENT
-  VARIABLE_DEFINITION
-  SCHEMA
-  SCALAR
-  OBJECT
-  FIELD_DEFINITION
-  ARGUMENT_DEFINITION
-  INTERFACE
-  UNION
-  ENUM
-  ENUM_VALUE
-  INPUT_OBJECT
-  INPUT_FIELD_DEFINITION
-})"""";
+    static constexpr builtin_input_value include_deprecated_args[] = {
+        {"includeDeprecated", type_ref("Boolean"), {}, value_kind::Boolean, "false"},
+    };
 
-    bool add_introspection_types(schema_t &schema)
+    static constexpr builtin_field schema_fields[] = {
+        {"description", type_ref("String")},
+        {"types", type_ref("[__Type!]!"), "A list of all types in this schema."},
+        {"queryType", type_ref("__Type!"), "The root type for query operations."},
+        {"mutationType", type_ref("__Type"), "The root type for mutation operations."},
+        {"subscriptionType", type_ref("__Type"), "The root type for subscription operations."},
+        {"directives", type_ref("[__Directive!]!"), "A list of all directives in this schema."},
+    };
+
+    static constexpr builtin_field type_fields[] = {
+        {"kind", type_ref("__TypeKind!")},
+        {"name", type_ref("String")},
+        {"description", type_ref("String")},
+        {"fields", type_ref("[__Field!]"), "must be non-null for OBJECT and INTERFACE, otherwise null.", include_deprecated_args},
+        {"interfaces", type_ref("[__Type!]"), "must be non-null for OBJECT and INTERFACE, otherwise null."},
+        {"possibleTypes", type_ref("[__Type!]"), "must be non-null for INTERFACE and UNION, otherwise null."},
+        {"enumValues", type_ref("[__EnumValue!]"), "must be non-null for ENUM, otherwise null.", include_deprecated_args},
+        {"inputFields", type_ref("[__InputValue!]"), "must be non-null for INPUT_OBJECT, otherwise null.", include_deprecated_args},
+        {"ofType", type_ref("__Type"), "must be non-null for NON_NULL and LIST, otherwise null."},
+        {"specifiedByURL", type_ref("String"), "may be non-null for custom SCALAR, otherwise null."},
+    };
+
+    static constexpr std::string_view type_kind_values[] = {
+        "SCALAR", "OBJECT", "INTERFACE", "UNION", "ENUM", "INPUT_OBJECT", "LIST", "NON_NULL"};
+
+    static constexpr builtin_field field_fields[] = {
+        {"name", type_ref("String!")},
+        {"description", type_ref("String")},
+        {"args", type_ref("[__InputValue!]!"), {}, include_deprecated_args},
+        {"type", type_ref("__Type!")},
+        {"isDeprecated", type_ref("Boolean!")},
+        {"deprecationReason", type_ref("String")},
+    };
+
+    static constexpr builtin_field input_value_fields[] = {
+        {"name", type_ref("String!")},
+        {"description", type_ref("String")},
+        {"type", type_ref("__Type!")},
+        {"defaultValue", type_ref("String")},
+        {"isDeprecated", type_ref("Boolean!")},
+        {"deprecationReason", type_ref("String")},
+    };
+
+    static constexpr builtin_field enum_value_fields[] = {
+        {"name", type_ref("String!")},
+        {"description", type_ref("String")},
+        {"isDeprecated", type_ref("Boolean!")},
+        {"deprecationReason", type_ref("String")},
+    };
+
+    static constexpr builtin_field directive_fields[] = {
+        {"name", type_ref("String!")},
+        {"description", type_ref("String")},
+        {"locations", type_ref("[__DirectiveLocation!]!")},
+        {"args", type_ref("[__InputValue!]!"), {}, include_deprecated_args},
+        {"isRepeatable", type_ref("Boolean!")},
+    };
+
+    static constexpr std::string_view directive_location_values[] = {
+        "QUERY", "MUTATION", "SUBSCRIPTION", "FIELD", "FRAGMENT_DEFINITION", "FRAGMENT_SPREAD",
+        "INLINE_FRAGMENT", "VARIABLE_DEFINITION", "SCHEMA", "SCALAR", "OBJECT", "FIELD_DEFINITION",
+        "ARGUMENT_DEFINITION", "INTERFACE", "UNION", "ENUM", "ENUM_VALUE", "INPUT_OBJECT", "INPUT_FIELD_DEFINITION"};
+
+    static constexpr builtin_type builtin_types[] = {
+        {type_kind::Scalar, "Int"},
+        {type_kind::Scalar, "Float"},
+        {type_kind::Scalar, "String"},
+        {type_kind::Scalar, "Boolean"},
+        {type_kind::Scalar, "Long"},
+        {type_kind::Scalar, "UUID", {}, {}, {}, "https://tools.ietf.org/html/rfc4122"},
+        {type_kind::Scalar, "DateTime", "Represents an ISO-8601 compliant date time type.", {}, {}, "https://scalars.graphql.org/andimarek/date-time"},
+        {type_kind::Object, "__Schema", "A GraphQL Schema containes all available types and directives on the server and the entry points for query, mutation, and subscription operations.", schema_fields},
+        {type_kind::Object, "__Type", {}, type_fields},
+        {type_kind::Enum, "__TypeKind", {}, {}, type_kind_values},
+        {type_kind::Object, "__Field", {}, field_fields},
+        {type_kind::Object, "__InputValue", {}, input_value_fields},
+        {type_kind::Object, "__EnumValue", {}, enum_value_fields},
+        {type_kind::Object, "__Directive", {}, directive_fields},
+        {type_kind::Enum, "__DirectiveLocation", {}, {}, directive_location_values},
+    };
+
+    static constexpr builtin_input_value if_args[] = {
+        {"if", type_ref("Boolean!")},
+    };
+
+    static constexpr builtin_input_value deprecated_args[] = {
+        {"reason", type_ref("String"), {}, value_kind::String, "No longer supported"},
+    };
+
+    static constexpr builtin_input_value specified_by_args[] = {
+        {"url", type_ref("String!")},
+    };
+
+    static constexpr builtin_directive builtin_directives[] = {
+        {"@skip", directive_target_t::Field | directive_target_t::FragmentSpread | directive_target_t::InlineFragment, if_args},
+        {"@include", directive_target_t::Field | directive_target_t::FragmentSpread | directive_target_t::InlineFragment, if_args},
+        {"@deprecated", directive_target_t::FieldDefinition | directive_target_t::ArgumentDefinition | directive_target_t::InputFieldDefinition | directive_target_t::EnumValue, deprecated_args},
+        {SpecifiedByDirective, directive_target_t::Scalar, specified_by_args},
+    };
+
+    // strings of the tables have static storage, so values may point to them directly
+    static value_t string_value(std::string_view str)
+    {
+        value_t value;
+        value.value_type = value_kind::String;
+        value.string_data = str.data();
+        value.size = uint32_t(str.size());
+        return value;
+    }
+
+    template <class T>
+    static void set_type(T &value, const builtin_type_ref &ref)
+    {
+        value.field_type.name = ref.name;
+        value.field_type_nullability = ref.nullability;
+        value.list_nesting_depth = ref.list_depth;
+    }
+
+    static void add_arguments(named_collection<input_value> &arguments, std::span<const builtin_input_value> definitions)
+    {
+        for (const builtin_input_value &definition : definitions)
+        {
+            input_value value{definition.name, definition.description};
+            value.index = arguments.size();
+            set_type(value, definition.type);
+            if (definition.default_kind == value_kind::Boolean)
+            {
+                value.default_value.value_type = value_kind::Boolean;
+                value.default_value.bool_value = definition.default_value == "true";
+            }
+            else if (definition.default_kind == value_kind::String)
+            {
+                value.default_value = string_value(definition.default_value);
+            }
+            arguments.insert(std::move(value));
+        }
+    }
+
+    static object_type make_type(schema_t &schema, const builtin_type &definition)
     {
+        object_type type{definition.kind, definition.name, definition.description};
+        for (const builtin_field &field_definition : definition.fields)
+        {
+            field fld{field_definition.name, field_definition.description};
+            fld.index = type.fields.size();
+            fld.declaring_type.name = type.name;
+            set_type(fld, field_definition.type);
+            add_arguments(fld.arguments, field_definition.arguments);
+            type.fields.insert(std::move(fld));
+        }
+        for (std::string_view value_name : definition.enum_values)
+        {
+            field value{value_name, {}};
+            value.index = type.fields.size();
+            type.fields.insert(std::move(value));
+        }
+        if (!definition.specified_by.empty())
+        {
+            parameter_value *url = schema.values.create<parameter_value>();
+            url->name = "url";
+            url->value = string_value(definition.specified_by);
+            directive dir{SpecifiedByDirective};
+            dir.parameters = parameter_list{url, 1};
+            type.directives.push_back(std::move(dir));
+        }
+        return type;
+    }
+
+    static std::shared_ptr<const schema_t> build_builtin_schema()
+    {
+        auto schema = std::make_shared<schema_t>();
+        for (const builtin_type &definition : builtin_types)
+            schema->types.insert(make_type(*schema, definition));
+
+        for (const builtin_directive &definition : builtin_directives)
+        {
+            directive_type dir{definition.name, definition.description, definition.target};
+            add_arguments(dir.arguments, definition.arguments);
+            schema->directive_types.insert(std::move(dir));
+        }
+
         schema_parser_t parser;
-        bool res = parser.parse(schema, introspection_schema);
-        if(!res)
+        if (!parser.compile(*schema))
         {
-            std::cerr << "ERROR: Failed to add introspection types: " <<  parser.get_error_msg() << std::endl;
+            std::cerr << "ERROR: Failed to compile built-in types: " << parser.get_error_msg() << std::endl;
         }
-        return res;
+        return schema;
+    }
+
+    std::shared_ptr<const schema_t> builtin_schema()
+    {
+        static const std::shared_ptr<const schema_t> schema = build_builtin_schema();
+        return schema;
+    }
+
+    bool add_introspection_types(schema_t &schema)
+    {
+        if (schema.base)
+            return true;
+        schema.base = builtin_schema();
+        // types referencing built-in types were not resolved yet
+        if (schema.version != 0)
+        {
+            schema_parser_t parser;
+            if (!parser.compile(schema))
+            {
+                std::cerr << "ERROR: Failed to add introspection types: " << parser.get_error_msg() << std::endl;
+                return false;
+            }
+        }
+        return true;
     }
 
-}
\ No newline at end of file
+}
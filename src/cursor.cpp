@@ -0,0 +1,109 @@
+#include <util/cursor.hpp>
+#include <charconv>
+
+namespace blitz_query_cpp
+{
+    static constexpr std::string_view Base64Chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static constexpr char CursorParameterSeparator = '#';
+
+    static void append_base64(std::string &res, std::string_view data)
+    {
+        size_t i = 0;
+        for (; i + 2 < data.size(); i += 3)
+        {
+            uint32_t n = uint32_t(uint8_t(data[i])) << 16 | uint32_t(uint8_t(data[i + 1])) << 8 | uint8_t(data[i + 2]);
+            for (int shift = 18; shift >= 0; shift -= 6)
+                res.append(1, Base64Chars[(n >> shift) & 63]);
+        }
+        if (i == data.size())
+            return;
+        uint32_t n = uint32_t(uint8_t(data[i])) << 16;
+        if (i + 1 < data.size())
+            n |= uint32_t(uint8_t(data[i + 1])) << 8;
+        res.append(1, Base64Chars[(n >> 18) & 63]);
+        res.append(1, Base64Chars[(n >> 12) & 63]);
+        res.append(1, i + 1 < data.size() ? Base64Chars[(n >> 6) & 63] : '=');
+        res.append(1, '=');
+    }
+
+    static bool decode_base64(std::string_view data, std::string &res)
+    {
+        if (data.size() % 4 != 0)
+            return false;
+        uint32_t n = 0;
+        int bits = 0;
+        for (size_t i = 0; i < data.size(); i++)
+        {
+            if (data[i] == '=')
+                return i + 2 >= data.size() && (i + 1 == data.size() || data[i + 1] == '=');
+            size_t value = Base64Chars.find(data[i]);
+            if (value == std::string_view::npos)
+                return false;
+            n = n << 6 | uint32_t(value);
+            bits += 6;
+            if (bits >= 8)
+            {
+                bits -= 8;
+                res.append(1, char((n >> bits) & 0xFF));
+            }
+        }
+        return true;
+    }
+
+    // <length>:<value> for every value
+    std::string encode_cursor(std::span<const std::string_view> values)
+    {
+        std::string data;
+        for (std::string_view value : values)
+        {
+            data.append(std::to_string(value.size()));
+            data.append(1, ':');
+            data.append(value);
+        }
+        std::string res;
+        res.reserve((data.size() + 2) / 3 * 4);
+        append_base64(res, data);
+        return res;
+    }
+
+    bool decode_cursor(std::string_view cursor, std::vector<std::string> &values)
+    {
+        std::string data;
+        if (cursor.empty() || !decode_base64(cursor, data))
+            return false;
+        std::string_view rest = data;
+        while (!rest.empty())
+        {
+            size_t size = 0;
+            auto [ptr, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), size);
+            if (ec != std::errc{} || ptr == rest.data() + rest.size() || *ptr != ':')
+                return false;
+            rest.remove_prefix(ptr - rest.data() + 1);
+            if (size > rest.size())
+                return false;
+            values.emplace_back(rest.substr(0, size));
+            rest.remove_prefix(size);
+        }
+        return true;
+    }
+
+    std::string cursor_parameter_name(std::string_view variable, index_t index)
+    {
+        std::string res{variable};
+        res.append(1, CursorParameterSeparator);
+        res.append(std::to_string(index));
+        return res;
+    }
+
+    bool parse_cursor_parameter_name(std::string_view name, std::string_view &variable, index_t &index)
+    {
+        size_t pos = name.rfind(CursorParameterSeparator);
+        if (pos == std::string_view::npos)
+            return false;
+        auto [ptr, ec] = std::from_chars(name.data() + pos + 1, name.data() + name.size(), index);
+        if (ec != std::errc{} || ptr != name.data() + name.size())
+            return false;
+        variable = name.substr(0, pos);
+        return true;
+    }
+}
@@ -0,0 +1,115 @@
+#include <parser/document_signature.hpp>
+#include <parser/tokenizer.hpp>
+#include <algorithm>
+#include <bit>
+
+namespace blitz_query_cpp
+{
+    static bool is_operation_keyword(const token_t &token)
+    {
+        switch (token.hash)
+        {
+        case "query"_name_hash:
+        case "mutation"_name_hash:
+        case "subscription"_name_hash:
+            return true;
+        }
+        return false;
+    }
+
+    static bool is_condition_directive(const token_t &token)
+    {
+        return token.hash == "@skip"_name_hash || token.hash == "@include"_name_hash;
+    }
+
+    // variable of cursor argument changes SQL when it is null or not given, see process_paging
+    static bool is_cursor_argument(const token_t &token)
+    {
+        return token.type == token_type::Name && token.hash == "after"_name_hash;
+    }
+
+    // type and length prefix value of token, so "a b" and "ab" differ
+    static void append_token(std::string &tokens, const token_t &token)
+    {
+        uint32_t size = static_cast<uint32_t>(token.value.size());
+        tokens.push_back(char(std::countr_zero(static_cast<uint32_t>(token.type))));
+        for (int i = 0; i < 4; i++)
+            tokens.push_back(char(size >> (i * 8)));
+        tokens.append(token.value);
+    }
+
+    static uint64_t document_signature(std::string_view doc, std::vector<std::string_view> *condition_variables, std::string *tokens)
+    {
+        tokenizer_t tokenizer{doc};
+        uint64_t hash = NameHashInit;
+        int depth = 0;
+        bool operation_name_expected = false;
+        bool in_condition = false;
+        int cursor_tokens = 0; // name and colon of cursor argument before its value
+
+        for (token_t token = tokenizer.next_token(); token.type != token_type::End; token = tokenizer.next_token())
+        {
+            if (token.type == token_type::InvalidToken)
+                return 0;
+            if (token.type == token_type::Comment)
+                continue;
+            if (operation_name_expected && token.type == token_type::Name)
+            {
+                operation_name_expected = false;
+                continue;
+            }
+            operation_name_expected = depth == 0 && token.type == token_type::Name && is_operation_keyword(token);
+
+            if (token.type == token_type::LBrace)
+                depth++;
+            else if (token.type == token_type::RBrace)
+                depth--;
+
+            if (condition_variables)
+            {
+                if (token.type == token_type::Directive)
+                    in_condition = is_condition_directive(token);
+                else if (token.type == token_type::RParen)
+                    in_condition = false;
+                else if ((in_condition || cursor_tokens == 2) && token.type == token_type::ParameterLiteral)
+                {
+                    std::string_view name = token.value.substr(1);
+                    if (std::find(condition_variables->begin(), condition_variables->end(), name) == condition_variables->end())
+                        condition_variables->push_back(name);
+                }
+                if (is_cursor_argument(token))
+                    cursor_tokens = 1;
+                else
+                    cursor_tokens = cursor_tokens == 1 && token.type == token_type::Colon ? 2 : 0;
+            }
+
+            if (tokens)
+                append_token(*tokens, token);
+            // token type separates values, so "a b" and "ab" give different hashes
+            uint32_t type = static_cast<uint32_t>(token.type);
+            for (int i = 0; i < 4; i++)
+                hash = name_hash_update(hash, char(type >> (i * 8)));
+            for (char ch : token.value)
+                hash = name_hash_update(hash, ch);
+        }
+        return hash == 0 ? 1 : hash;
+    }
+
+    uint64_t document_signature(std::string_view doc)
+    {
+        return document_signature(doc, nullptr, nullptr);
+    }
+
+    uint64_t document_signature(std::string_view doc, std::string &tokens)
+    {
+        tokens.clear();
+        return document_signature(doc, nullptr, &tokens);
+    }
+
+    uint64_t document_signature(std::string_view doc, std::vector<std::string_view> &condition_variables, std::string &tokens)
+    {
+        condition_variables.clear();
+        tokens.clear();
+        return document_signature(doc, &condition_variables, &tokens);
+    }
+}
@@ -0,0 +1,578 @@
+#include <processing/introspection_resolver.hpp>
+#include <parser/document_signature.hpp>
+#include <serialization/buffer_writer.hpp>
+#include <serialization/json/json_serializer.hpp>
+#include <algorithm>
+#include <charconv>
+#include <vector>
+
+namespace blitz_query_cpp
+{
+    static constexpr std::string_view DeprecatedDirective = "@deprecated";
+    static constexpr std::string_view SpecifiedByDirective = "@specifiedBy";
+    static constexpr std::string_view DefaultDeprecationReason = "No longer supported";
+
+    std::string introspection_query(const introspection_options &options)
+    {
+        std::string_view description = options.descriptions ? "description\n" : "";
+        std::string_view input_deprecation = options.input_value_deprecation ? "(includeDeprecated: true)" : "";
+
+        std::string query = "query IntrospectionQuery {\n__schema {\n";
+        if (options.schema_description)
+            query += "description\n";
+        query += "queryType { name }\nmutationType { name }\nsubscriptionType { name }\n"
+                 "types { ...FullType }\ndirectives {\nname\n";
+        query += description;
+        if (options.directive_is_repeatable)
+            query += "isRepeatable\n";
+        query += "locations\nargs";
+        query += input_deprecation;
+        query += " { ...InputValue }\n}\n}\n}\n";
+
+        query += "fragment FullType on __Type {\nkind\nname\n";
+        query += description;
+        if (options.specified_by_url)
+            query += "specifiedByURL\n";
+        query += "fields(includeDeprecated: true) {\nname\n";
+        query += description;
+        query += "args";
+        query += input_deprecation;
+        query += " { ...InputValue }\ntype { ...TypeRef }\nisDeprecated\ndeprecationReason\n}\ninputFields";
+        query += input_deprecation;
+        query += " { ...InputValue }\ninterfaces { ...TypeRef }\nenumValues(includeDeprecated: true) {\nname\n";
+        query += description;
+        query += "isDeprecated\ndeprecationReason\n}\npossibleTypes { ...TypeRef }\n}\n";
+
+        query += "fragment InputValue on __InputValue {\nname\n";
+        query += description;
+        query += "type { ...TypeRef }\ndefaultValue\n";
+        if (options.input_value_deprecation)
+            query += "isDeprecated\ndeprecationReason\n";
+        query += "}\n";
+
+        query += "fragment TypeRef on __Type {\nkind\nname\n";
+        for (int i = 0; i < 7; i++)
+            query += "ofType {\nkind\nname\n";
+        for (int i = 0; i < 7; i++)
+            query += "}\n";
+        query += "}\n";
+        return query;
+    }
+
+    // prints value as GraphQL literal, as expected in defaultValue field
+    static void print_value(std::string &out, const value_t &value)
+    {
+        switch (value.value_type)
+        {
+        case value_kind::Boolean:
+            out += value.bool_value ? "true" : "false";
+            break;
+        case value_kind::Integer:
+            out += std::to_string(value.int_value);
+            break;
+        case value_kind::Float:
+        {
+            char buffer[64];
+            auto res = std::to_chars(std::begin(buffer), std::end(buffer), value.float_value);
+            out.append(buffer, res.ptr);
+            break;
+        }
+        case value_kind::Enum:
+            out += value.string_value();
+            break;
+        case value_kind::String:
+            out += '"';
+            for (char c : value.string_value())
+            {
+                switch (c)
+                {
+                case '\n':
+                    out += "\\n";
+                    continue;
+                case '"':
+                case '\\':
+                    out += '\\';
+                    break;
+                default:
+                    break;
+                }
+                out += c;
+            }
+            out += '"';
+            break;
+        case value_kind::Null:
+            out += "null";
+            break;
+        case value_kind::List:
+        case value_kind::Object:
+        {
+            bool is_object = value.value_type == value_kind::Object;
+            out += is_object ? '{' : '[';
+            bool first = true;
+            for (const parameter_value &item : value.fields())
+            {
+                if (!first)
+                    out += ", ";
+                first = false;
+                if (is_object)
+                {
+                    out += item.name;
+                    out += ": ";
+                }
+                print_value(out, item.value);
+            }
+            out += is_object ? '}' : ']';
+            break;
+        }
+        case value_kind::None:
+        default:
+            break;
+        }
+    }
+
+    template <class T>
+    static std::vector<const T *> sorted_by_index(const named_collection<T> &values)
+    {
+        std::vector<const T *> res;
+        res.reserve(values.size());
+        for (const T &value : values)
+            res.push_back(&value);
+        std::sort(res.begin(), res.end(), [](const T *a, const T *b)
+                  { return a->index < b->index; });
+        return res;
+    }
+
+    template <class T>
+    static void sort_by_name(std::vector<const T *> &values)
+    {
+        std::sort(values.begin(), values.end(), [](const T *a, const T *b)
+                  { return a->name < b->name; });
+    }
+
+    template <class T>
+    static std::vector<const T *> sorted_by_name(const named_collection<T> &values)
+    {
+        std::vector<const T *> res;
+        res.reserve(values.size());
+        for (const T &value : values)
+            res.push_back(&value);
+        sort_by_name(res);
+        return res;
+    }
+
+    class introspection_writer
+    {
+        const schema_t &schema;
+        const introspection_options &options;
+        json_writer<buffer_writer> writer{writer_options{}};
+        std::vector<const object_type *> types;
+        std::vector<const directive_type *> directive_types;
+        std::unordered_map<std::string_view, std::vector<const object_type *>> implementations;
+        std::string_view default_deprecation_reason = DefaultDeprecationReason;
+
+        void write_description(const type_system_object &object)
+        {
+            if (!options.descriptions)
+                return;
+            if (object.description.empty())
+                writer.write_null("description");
+            else
+                writer.write_str_value("description", object.description);
+        }
+
+        void write_deprecation(const type_system_object_with_directives &object)
+        {
+            const directive *deprecated = object.find_directive(DeprecatedDirective);
+            writer.write_value("isDeprecated", deprecated != nullptr);
+            if (!deprecated)
+            {
+                writer.write_null("deprecationReason");
+                return;
+            }
+            auto reason = deprecated->parameters.find("reason");
+            writer.write_str_value("deprecationReason", reason != deprecated->parameters.end() ? reason->value.string_value() : default_deprecation_reason);
+        }
+
+        std::string_view kind_name(const type_reference &ref)
+        {
+            const object_type *type = ref.type ? ref.type : schema.find_type(ref.name);
+            switch (type ? type->kind : type_kind::Scalar)
+            {
+            case type_kind::Enum:
+                return "ENUM";
+            case type_kind::InputObject:
+                return "INPUT_OBJECT";
+            case type_kind::Interface:
+                return "INTERFACE";
+            case type_kind::Object:
+                return "OBJECT";
+            case type_kind::Union:
+                return "UNION";
+            default:
+                return "SCALAR";
+            }
+        }
+
+        void write_named_type(const type_reference &ref)
+        {
+            writer.write_str_value("kind", kind_name(ref));
+            writer.write_str_value("name", ref.name);
+            writer.write_null("ofType");
+        }
+
+        void write_wrapper(std::string_view kind)
+        {
+            writer.write_str_value("kind", kind);
+            writer.write_null("name");
+            writer.begin_object("ofType");
+        }
+
+        // field_type_nullability has a bit set for every nullable level, level 0 is the outermost one
+        void write_type_ref(const input_value &value)
+        {
+            writer.begin_object("type");
+            int wrappers = 0;
+            for (int level = 0;; level++)
+            {
+                if ((value.field_type_nullability & (1u << level)) == 0)
+                {
+                    write_wrapper("NON_NULL");
+                    wrappers++;
+                }
+                if (level == value.list_nesting_depth)
+                    break;
+                write_wrapper("LIST");
+                wrappers++;
+            }
+            write_named_type(value.field_type);
+            for (int i = 0; i < wrappers; i++)
+                writer.end_object();
+            writer.end_object();
+        }
+
+        void write_input_value(const input_value &value)
+        {
+            writer.begin_object();
+            writer.write_str_value("name", value.name);
+            write_description(value);
+            write_type_ref(value);
+            if (value.default_value.value_type == value_kind::None)
+            {
+                writer.write_null("defaultValue");
+            }
+            else
+            {
+                std::string default_value;
+                print_value(default_value, value.default_value);
+                writer.write_str_value("defaultValue", default_value);
+            }
+            if (options.input_value_deprecation)
+                write_deprecation(value);
+            writer.end_object();
+        }
+
+        // args and inputFields without includeDeprecated: true leave deprecated values out
+        bool is_listed(const input_value &value)
+        {
+            return options.input_value_deprecation || !value.find_directive(DeprecatedDirective);
+        }
+
+        void write_arguments(std::string_view name, const named_collection<input_value> &arguments)
+        {
+            writer.begin_array(name);
+            for (const input_value *argument : sorted_by_index(arguments))
+            {
+                if (is_listed(*argument))
+                    write_input_value(*argument);
+            }
+            writer.end_array();
+        }
+
+        void write_field(const field &fld)
+        {
+            writer.begin_object();
+            writer.write_str_value("name", fld.name);
+            write_description(fld);
+            write_arguments("args", fld.arguments);
+            write_type_ref(fld);
+            write_deprecation(fld);
+            writer.end_object();
+        }
+
+        void write_type_refs(std::string_view name, const std::vector<const type_reference *> &refs)
+        {
+            writer.begin_array(name);
+            for (const type_reference *ref : refs)
+            {
+                writer.begin_object();
+                write_named_type(*ref);
+                writer.end_object();
+            }
+            writer.end_array();
+        }
+
+        void write_possible_types(const object_type &type)
+        {
+            if (type.kind == type_kind::Union)
+            {
+                write_type_refs("possibleTypes", sorted_by_name(type.implements));
+                return;
+            }
+            if (type.kind != type_kind::Interface)
+            {
+                writer.write_null("possibleTypes");
+                return;
+            }
+            writer.begin_array("possibleTypes");
+            auto impl = implementations.find(type.name);
+            if (impl != implementations.end())
+            {
+                for (const object_type *implementation : impl->second)
+                {
+                    writer.begin_object();
+                    writer.write_str_value("kind", "OBJECT");
+                    writer.write_str_value("name", implementation->name);
+                    writer.write_null("ofType");
+                    writer.end_object();
+                }
+            }
+            writer.end_array();
+        }
+
+        void write_type(const object_type &type)
+        {
+            bool has_fields = type.kind == type_kind::Object || type.kind == type_kind::Interface;
+
+            writer.begin_object();
+            writer.write_str_value("kind", kind_name(type_reference{type.name}));
+            writer.write_str_value("name", type.name);
+            write_description(type);
+            if (options.specified_by_url)
+            {
+                const directive *specified_by = type.find_directive(SpecifiedByDirective);
+                auto url = specified_by ? specified_by->parameters.find("url") : nullptr;
+                if (specified_by && url != specified_by->parameters.end())
+                    writer.write_str_value("specifiedByURL", url->value.string_value());
+                else
+                    writer.write_null("specifiedByURL");
+            }
+
+            if (has_fields)
+            {
+                writer.begin_array("fields");
+                for (const field *fld : sorted_by_index(type.fields))
+                    write_field(*fld);
+                writer.end_array();
+            }
+            else
+                writer.write_null("fields");
+
+            if (type.kind == type_kind::InputObject)
+            {
+                writer.begin_array("inputFields");
+                for (const field *fld : sorted_by_index(type.fields))
+                {
+                    if (is_listed(*fld))
+                        write_input_value(*fld);
+                }
+                writer.end_array();
+            }
+            else
+                writer.write_null("inputFields");
+
+            if (has_fields)
+                write_type_refs("interfaces", sorted_by_name(type.implements));
+            else
+                writer.write_null("interfaces");
+
+            if (type.kind == type_kind::Enum)
+            {
+                writer.begin_array("enumValues");
+                for (const field *value : sorted_by_index(type.fields))
+                {
+                    writer.begin_object();
+                    writer.write_str_value("name", value->name);
+                    write_description(*value);
+                    write_deprecation(*value);
+                    writer.end_object();
+                }
+                writer.end_array();
+            }
+            else
+                writer.write_null("enumValues");
+
+            write_possible_types(type);
+            writer.end_object();
+        }
+
+        void write_directive(const directive_type &dir)
+        {
+            std::string_view name = dir.name;
+            if (name.starts_with('@'))
+                name.remove_prefix(1);
+
+            writer.begin_object();
+            writer.write_str_value("name", name);
+            write_description(dir);
+            if (options.directive_is_repeatable)
+                writer.write_value("isRepeatable", has_any_flag(dir.target, directive_target_t::IsRepeatable));
+            writer.begin_array("locations");
+            for (unsigned bit = 1; bit < 32; bit++)
+            {
+                directive_target_t location = directive_target_t(1u << bit);
+                if (has_any_flag(dir.target, location))
+                    writer.write_item(std::string_view(enum_name(location)));
+            }
+            writer.end_array();
+            write_arguments("args", dir.arguments);
+            writer.end_object();
+        }
+
+        void write_root_type(std::string_view name, const object_type *type)
+        {
+            if (!type)
+            {
+                writer.write_null(name);
+                return;
+            }
+            writer.begin_object(name);
+            writer.write_str_value("name", type->name);
+            writer.end_object();
+        }
+
+    public:
+        introspection_writer(const schema_t &schema_, const introspection_options &options_)
+            : schema{schema_}, options{options_}
+        {
+            schema.for_each_type([this](const object_type &type)
+                                 { types.push_back(&type); });
+            sort_by_name(types);
+            schema.for_each_directive_type([this](const directive_type &dir)
+                                           { directive_types.push_back(&dir); });
+            sort_by_name(directive_types);
+
+            for (const object_type *type : types)
+            {
+                if (type->kind != type_kind::Object)
+                    continue;
+                for (const type_reference &inter : type->implements)
+                    implementations[inter.name].push_back(type);
+            }
+
+            if (const directive_type *deprecated = schema.find_directive_type(DeprecatedDirective))
+            {
+                auto reason = deprecated->arguments.find("reason");
+                if (reason != deprecated->arguments.end() && reason->default_value.value_type == value_kind::String)
+                    default_deprecation_reason = reason->default_value.string_value();
+            }
+        }
+
+        std::string write()
+        {
+            writer.begin_object();
+            writer.begin_object("data");
+            writer.begin_object("__schema");
+            if (options.schema_description)
+                writer.write_null("description");
+            write_root_type("queryType", schema.get_query_type());
+            write_root_type("mutationType", schema.get_mutation_type());
+            write_root_type("subscriptionType", nullptr);
+
+            writer.begin_array("types");
+            for (const object_type *type : types)
+                write_type(*type);
+            writer.end_array();
+
+            writer.begin_array("directives");
+            for (const directive_type *dir : directive_types)
+                write_directive(*dir);
+            writer.end_array();
+
+            writer.end_object();
+            writer.end_object();
+            writer.end_object();
+            return std::string(writer.get_string());
+        }
+    };
+
+    std::string introspection_response(const schema_t &schema, const introspection_options &options)
+    {
+        return introspection_writer{schema, options}.write();
+    }
+
+    introspection_cache::introspection_cache()
+    {
+        for (unsigned key = 0; key < introspection_options::VariantsCount; key++)
+        {
+            introspection_options options = introspection_options::of_key(key);
+            register_query(introspection_query(options), options);
+        }
+    }
+
+    void introspection_cache::register_query(std::string_view query, const introspection_options &options)
+    {
+        known_query known{{}, options};
+        uint64_t signature = document_signature(query, known.tokens);
+        std::lock_guard lock{mutex};
+        known_queries.insert_or_assign(signature, std::move(known));
+    }
+
+    std::optional<introspection_options> introspection_cache::find_query(std::string_view query) const
+    {
+        // cheap check to skip signature of regular queries
+        if (query.find("__schema") == std::string_view::npos)
+            return std::nullopt;
+        std::string tokens;
+        uint64_t signature = document_signature(query, tokens);
+        std::lock_guard lock{mutex};
+        auto res = known_queries.find(signature);
+        // signatures of other documents may collide
+        if (res == known_queries.end() || res->second.tokens != tokens)
+            return std::nullopt;
+        return res->second.options;
+    }
+
+    std::shared_ptr<const std::string> introspection_cache::get_response(const schema_t &schema, const introspection_options &options)
+    {
+        uint64_t version = schema.version;
+        {
+            std::lock_guard lock{mutex};
+            auto entry = schemas.find(&schema);
+            if (entry != schemas.end() && entry->second.version == version)
+            {
+                auto response = entry->second.responses.find(options.key());
+                if (response != entry->second.responses.end())
+                    return response->second;
+            }
+        }
+
+        // other requests are not blocked while response is built, the first one built is kept
+        auto response = std::make_shared<const std::string>(introspection_response(schema, options));
+        std::lock_guard lock{mutex};
+        schema_responses &entry = schemas[&schema];
+        if (entry.version != version)
+        {
+            entry.version = version;
+            entry.responses.clear();
+        }
+        auto [res, inserted] = entry.responses.try_emplace(options.key(), std::move(response));
+        return res->second;
+    }
+
+    void introspection_cache::remove_schema(const schema_t *schema)
+    {
+        std::lock_guard lock{mutex};
+        schemas.erase(schema);
+    }
+
+    bool introspection_resolver::process(query_context &context)
+    {
+        if (context.has_response())
+            return true;
+        auto options = cache.find_query(context.document.doc_value);
+        if (!options)
+            return true;
+        context.result = json_response{*cache.get_response(*context.schema, *options)};
+        return true;
+    }
+}
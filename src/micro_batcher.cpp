@@ -0,0 +1,210 @@
+#include <processing/micro_batcher.hpp>
+#include <data/sql/postgresql_renderer.hpp>
+#include <util/cursor.hpp>
+#include <algorithm>
+#include <charconv>
+
+namespace blitz_query_cpp
+{
+    static std::string parameter_name(size_t index)
+    {
+        return "p" + std::to_string(index + 1);
+    }
+
+    // replaces $n of variables with columns of unnested arrays, quoted text is skipped
+    static void replace_variables(std::string &res, std::string_view sql, const std::vector<plan_parameter> &parameters)
+    {
+        size_t pos = 0;
+        while (pos < sql.size())
+        {
+            char c = sql[pos];
+            if (c == '\'' || c == '"')
+            {
+                size_t end = sql.find(c, pos + 1);
+                end = end == std::string_view::npos ? sql.size() : end + 1;
+                res.append(sql.substr(pos, end - pos));
+                pos = end;
+                continue;
+            }
+            size_t number = 0;
+            auto [ptr, ec] = std::from_chars(sql.data() + pos + 1, sql.data() + sql.size(), number);
+            if (c != '$' || ec != std::errc{} || number == 0 || number > parameters.size() ||
+                parameters[number - 1].type != sql::parameter_type::Variable)
+            {
+                res.append(1, c);
+                pos++;
+                continue;
+            }
+            res.append("_b.");
+            res.append(parameter_name(number - 1));
+            pos = ptr - sql.data();
+        }
+    }
+
+    bool can_merge_plan(const compiled_plan &plan)
+    {
+        if (!plan.batches.empty() || !plan.mutations.empty())
+            return false;
+        return std::none_of(plan.parameters.begin(), plan.parameters.end(), [](const plan_parameter &param)
+                            {
+                                std::string_view variable;
+                                index_t cursor_index = 0;
+                                sql::like_match match;
+                                return param.type == sql::parameter_type::Variable &&
+                                       (param.sql_type.empty() || parse_cursor_parameter_name(param.value, variable, cursor_index) ||
+                                        parse_like_parameter_name(param.value, variable, match) ||
+                                        parse_list_parameter_name(param.value, variable)); });
+    }
+
+    std::string merge_plan_sql(const compiled_plan &plan)
+    {
+        if (!can_merge_plan(plan))
+            return {};
+        std::string arrays, columns;
+        for (size_t i = 0; i < plan.parameters.size(); i++)
+        {
+            const plan_parameter &param = plan.parameters[i];
+            if (param.type != sql::parameter_type::Variable)
+                continue;
+            arrays.append(arrays.empty() ? "" : ", ");
+            arrays.append("$" + std::to_string(i + 1) + "::");
+            arrays.append(param.sql_type);
+            arrays.append("[]");
+            columns.append(parameter_name(i));
+            columns.append(", ");
+        }
+        if (arrays.empty())
+            return {};
+
+        std::string res;
+        res.reserve(plan.sql.size() + arrays.size() + columns.size() + 96);
+        res.append("SELECT _b.ord, _q.* FROM unnest(");
+        res.append(arrays);
+        res.append(") WITH ORDINALITY as _b(");
+        res.append(columns);
+        res.append("ord) CROSS JOIN LATERAL (");
+        replace_variables(res, plan.sql, plan.parameters);
+        res.append(") as _q");
+        return res;
+    }
+
+    bool micro_batcher::run_batch(const compiled_plan &plan, pending_batch &batch)
+    {
+        batch.results.resize(batch.requests.size());
+        std::vector<std::string> parameters;
+        parameters.reserve(plan.parameters.size());
+        if (batch.requests.size() == 1)
+        {
+            for (std::string_view value : *batch.requests[0])
+                parameters.emplace_back(value);
+            return executor(plan.sql, parameters, batch.results[0]);
+        }
+
+        // constants are the same for all requests of plan
+        std::vector<std::string_view> values(batch.requests.size());
+        for (size_t i = 0; i < plan.parameters.size(); i++)
+        {
+            if (plan.parameters[i].type != sql::parameter_type::Variable)
+            {
+                parameters.emplace_back((*batch.requests[0])[i]);
+                continue;
+            }
+            for (size_t r = 0; r < batch.requests.size(); r++)
+                values[r] = (*batch.requests[r])[i];
+            parameters.push_back(sql::pg_array_literal(values));
+        }
+
+        std::vector<result_row> rows;
+        if (!executor(merge_plan_sql(plan), parameters, rows))
+            return false;
+        for (result_row &row : rows)
+        {
+            size_t ordinal = 0;
+            if (row.empty() || std::from_chars(row[0].data(), row[0].data() + row[0].size(), ordinal).ec != std::errc{} ||
+                ordinal == 0 || ordinal > batch.results.size())
+                return false;
+            row.erase(row.begin());
+            batch.results[ordinal - 1].push_back(std::move(row));
+        }
+        return true;
+    }
+
+    bool micro_batcher::execute(query_context &context, std::vector<result_row> &rows)
+    {
+        const compiled_plan *plan = context.get_plan();
+        if (!plan)
+            return context.report_error("Request has no compiled plan");
+        if (!plan->mutations.empty())
+            return context.report_error("Mutation is not batched, it runs by execute_mutation");
+        // requests without variables are all the same, there is nothing to merge
+        bool mergeable = can_merge_plan(*plan) &&
+                             std::any_of(plan->parameters.begin(), plan->parameters.end(), [](const plan_parameter &param)
+                                         { return param.type == sql::parameter_type::Variable; });
+
+        std::unique_lock lock{mutex};
+        auto batch = std::make_shared<pending_batch>();
+        if (mergeable)
+        {
+            std::shared_ptr<pending_batch> &slot = pending[plan];
+            if (slot && slot->requests.size() < max_batch_size)
+            {
+                // join batch of the first request
+                batch = slot;
+                size_t index = batch->requests.size();
+                batch->requests.push_back(&context.parameter_values);
+                if (batch->requests.size() >= max_batch_size)
+                    batch->done_cv.notify_all();
+                batch->done_cv.wait(lock, [&batch]
+                                    { return batch->done; });
+                if (batch->error)
+                    std::rethrow_exception(batch->error);
+                if (!batch->succeeded)
+                    return context.report_error("Failed to execute batched statement");
+                rows = std::move(batch->results[index]);
+                return true;
+            }
+            // new batch, full one is about to run
+            slot = batch;
+        }
+
+        batch->requests.push_back(&context.parameter_values);
+        if (mergeable)
+        {
+            batch->done_cv.wait_for(lock, window, [this, &batch]
+                                    { return batch->requests.size() >= max_batch_size; });
+            auto current = pending.find(plan);
+            if (current != pending.end() && current->second == batch)
+                pending.erase(current);
+        }
+        statements_count++;
+        lock.unlock();
+
+        // requests which joined the batch wait for it whatever happens
+        bool succeeded = false;
+        try
+        {
+            succeeded = run_batch(*plan, *batch);
+        }
+        catch (...)
+        {
+            batch->error = std::current_exception();
+        }
+
+        lock.lock();
+        batch->succeeded = succeeded;
+        batch->done = true;
+        batch->done_cv.notify_all();
+        if (batch->error)
+            std::rethrow_exception(batch->error);
+        if (!succeeded)
+            return context.report_error("Failed to execute batched statement");
+        rows = std::move(batch->results[0]);
+        return true;
+    }
+
+    size_t micro_batcher::get_statements_count()
+    {
+        std::lock_guard lock{mutex};
+        return statements_count;
+    }
+}
@@ -0,0 +1,144 @@
+#include <processing/mutation_executor.hpp>
+#include <data/sql/pg_copy_writer.hpp>
+#include <algorithm>
+#include <span>
+
+namespace blitz_query_cpp
+{
+    // limit of parameters of PostgreSQL statement
+    static constexpr size_t MaxStatementParameters = 65535;
+
+    // value of bulk row from plan or request variables
+    static bool bulk_value_text(query_context &context, const bulk_value &value, std::string_view &text)
+    {
+        text = value.value;
+        if (!value.is_variable)
+            return true;
+        auto variable = context.variables.find(value.value);
+        if (variable == context.variables.end())
+            return context.report_error("Variable '${}' is not provided", value.value);
+        text = variable->second;
+        return true;
+    }
+
+    // rows of bulk load, values are encoded from plan and variables without copies
+    static bool encode_bulk_rows(query_context &context, const bulk_load &bulk, std::span<const bulk_value> values, sql::copy_binary_writer &writer)
+    {
+        std::vector<sql::copy_type> types;
+        for (const std::string &column_type : bulk.column_types)
+            types.push_back(sql::copy_type_of(column_type));
+        if (types.empty())
+            return context.report_error("Bulk load has no columns");
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            size_t column = i % types.size();
+            if (column == 0)
+                writer.begin_row(int16_t(types.size()));
+            const bulk_value &value = values[i];
+            if (value.is_null)
+            {
+                writer.write_null();
+                continue;
+            }
+            std::string_view text;
+            if (!bulk_value_text(context, value, text))
+                return false;
+            if (!writer.write_value(types[column], text))
+                return context.report_error("Value '{}' is not valid {}", text, bulk.column_types[column]);
+        }
+        return true;
+    }
+
+    // rows of bulk load without copy executor, multi-row INSERT ... VALUES
+    // statements with as many rows as parameters of statement allow
+    static bool insert_bulk_rows(query_context &context, const bulk_load &bulk, std::span<const bulk_value> values, const statement_executor &executor)
+    {
+        size_t columns = bulk.column_types.size();
+        if (columns == 0)
+            return context.report_error("Bulk load has no columns");
+        size_t statement_values = std::max<size_t>(1, MaxStatementParameters / columns) * columns;
+        std::string sql;
+        std::vector<std::string> parameters;
+        std::vector<result_row> no_rows;
+        for (size_t first = 0; first < values.size(); first += statement_values)
+        {
+            size_t last = std::min(values.size(), first + statement_values);
+            sql = bulk.insert_sql;
+            parameters.clear();
+            for (size_t i = first; i < last; i++)
+            {
+                if ((i - first) % columns == 0)
+                    sql.append(i == first ? "(" : "), (");
+                else
+                    sql.append(", ");
+                if (values[i].is_null)
+                {
+                    sql.append("NULL");
+                    continue;
+                }
+                std::string_view text;
+                if (!bulk_value_text(context, values[i], text))
+                    return false;
+                parameters.emplace_back(text);
+                sql.append(1, '$').append(std::to_string(parameters.size()));
+            }
+            sql.append(1, ')');
+            if (!executor(sql, parameters, no_rows))
+                return false;
+        }
+        return true;
+    }
+
+    bool execute_mutation(query_context &context, const statement_executor &executor, std::vector<std::vector<result_row>> &rows,
+                          const copy_executor &copy)
+    {
+        const compiled_plan *plan = context.get_plan();
+        if (!plan || plan->mutations.empty())
+            return context.report_error("Request has no compiled mutation");
+
+        // single statement is atomic itself, temporary table of bulk load lives until commit
+        bool use_transaction = plan->mutations.size() > 1 || plan->mutations[0].is_bulk();
+        const std::vector<std::string> no_parameters;
+        std::vector<result_row> no_rows;
+        if (use_transaction && !executor("BEGIN", no_parameters, no_rows))
+            return context.report_error("Failed to start transaction");
+
+        rows.assign(plan->mutations.size(), {});
+        std::vector<std::string> parameters;
+        for (size_t i = 0; i < plan->mutations.size(); i++)
+        {
+            const mutation_statement &statement = plan->mutations[i];
+            bool executed = statement.first_parameter + statement.parameters_count <= context.parameter_values.size();
+            if (executed && statement.is_bulk())
+            {
+                // rows of list variable are bound to context
+                std::span<const bulk_value> values = statement.bulk.values;
+                if (!statement.bulk.rows_variable.empty())
+                    values = i < context.bulk_values.size() ? std::span<const bulk_value>(context.bulk_values[i]) : std::span<const bulk_value>();
+                sql::copy_binary_writer writer;
+                if (copy)
+                    executed = encode_bulk_rows(context, statement.bulk, values, writer) &&
+                               executor(statement.bulk.create_sql, no_parameters, no_rows) &&
+                               copy(statement.bulk.copy_sql, writer.finish());
+                else
+                    executed = executor(statement.bulk.create_sql, no_parameters, no_rows) &&
+                               insert_bulk_rows(context, statement.bulk, values, executor);
+            }
+            if (executed)
+            {
+                auto first = context.parameter_values.begin() + statement.first_parameter;
+                parameters.assign(first, first + statement.parameters_count);
+                executed = executor(statement.sql, parameters, rows[i]);
+            }
+            if (!executed)
+            {
+                if (use_transaction)
+                    executor("ROLLBACK", no_parameters, no_rows);
+                return context.report_error("Failed to execute {} of '{}'", statement.operation, statement.object_name);
+            }
+        }
+        if (use_transaction && !executor("COMMIT", no_parameters, no_rows))
+            return context.report_error("Failed to commit transaction");
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+#include <util/name_table.hpp>
+
+namespace blitz_query_cpp
+{
+    name_table &name_table::global()
+    {
+        static name_table table;
+        return table;
+    }
+
+    symbol_t name_table::intern(std::string_view name)
+    {
+        if (name.empty())
+            return NoSymbol;
+        hashed_name key{name, hash_name(name)};
+
+        std::lock_guard lock{mutex};
+        auto it = symbols.find(key);
+        if (it != symbols.end())
+            return it->second;
+        const std::string &stored = names.emplace_back(name);
+        symbol_t symbol = symbol_t(names.size());
+        symbols.emplace(stored, symbol);
+        return symbol;
+    }
+
+    void name_table::freeze()
+    {
+        std::lock_guard lock{mutex};
+        if (get_snapshot()->size() == names.size())
+            return;
+        auto next = std::make_shared<snapshot>();
+        next->names.assign(names.begin(), names.end());
+        next->symbols = symbols;
+        current.store(std::move(next), std::memory_order_release);
+    }
+
+    symbol_t name_table::snapshot::find(std::string_view name, uint64_t hash) const
+    {
+        auto it = symbols.find(hashed_name{name, hash});
+        if (it == symbols.end())
+            return NoSymbol;
+        return it->second;
+    }
+
+    std::string_view name_table::snapshot::name(symbol_t symbol) const
+    {
+        if (symbol == NoSymbol || symbol > names.size())
+            return {};
+        return names[symbol - 1];
+    }
+}
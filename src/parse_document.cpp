@@ -6,6 +6,8 @@ namespace blitz_query_cpp
 
     bool parse_document::process(query_context &context)
     {
+        if (context.is_resolved())
+            return true;
         parser_t parser{context.document};
         if (!parser.parse())
         {
@@ -101,6 +101,8 @@ index_t parser_t::count_tokens()
 bool parser_t::next_token()
 {
     last_token_end = current_token.pos + current_token.size;
+    last_token_symbol = current_token.symbol;
+    last_token_hash = current_token.hash;
     current_token = tokenizer.next_token();
     return true;
 }
@@ -130,31 +132,31 @@ bool parser_t::parse_definitions()
 
     if (current_token.type == token_type::Name)
     {
-        switch (hash_crc32(current_token.value))
+        switch (current_token.hash)
         {
-        case "query"_crc32:
-        case "mutation"_crc32:
-        case "subscription"_crc32:
+        case "query"_name_hash:
+        case "mutation"_name_hash:
+        case "subscription"_name_hash:
             return parse_operation_definition();
-        case "fragment"_crc32:
+        case "fragment"_name_hash:
             return parse_fragment_definition();
-        case "directive"_crc32:
+        case "directive"_name_hash:
             return parse_directive_definition();
-        case "schema"_crc32:
+        case "schema"_name_hash:
             return parse_schema_definition(syntax_node_type::SchemaDefinition);
-        case "scalar"_crc32:
+        case "scalar"_name_hash:
             return parse_scalar_type_definition(syntax_node_type::ScalarTypeDefinition);
-        case "type"_crc32:
+        case "type"_name_hash:
             return parse_object_type_definition(syntax_node_type::ObjectTypeDefinition, "type");
-        case "interface"_crc32:
+        case "interface"_name_hash:
             return parse_object_type_definition(syntax_node_type::ObjectTypeDefinition, "interface");
-        case "union"_crc32:
+        case "union"_name_hash:
             return parse_union_type_definition(syntax_node_type::UnionTypeDefinition);
-        case "enum"_crc32:
+        case "enum"_name_hash:
             return parse_enum_type_definition(syntax_node_type::EnumTypeDefinition);
-        case "input"_crc32:
+        case "input"_name_hash:
             return parse_input_object_type_definition(syntax_node_type::InputObjectTypeDefinition);
-        case "extend"_crc32:
+        case "extend"_name_hash:
             return parse_type_extension();
         }
     }
@@ -347,7 +349,7 @@ bool parser_t::parse_list(bool is_constant)
             return false;
     }
 
-    if (!expect_token(token_type::RBrace))
+    if (!expect_token(token_type::RBracket))
         return false;
 
     return pop_node();
@@ -431,6 +433,8 @@ bool parser_t::parse_directive(bool is_constant)
         return false;
     syntax_node &directive_node = current_node();
     directive_node.name = directive_node.content;
+    directive_node.name_symbol = last_token_symbol;
+    directive_node.name_hash_code = last_token_hash;
 
     if (!parse_arguments(is_constant))
         return false;
@@ -507,6 +511,8 @@ bool parser_t::parse_field()
     }
     syntax_node &selection_node = current_node();
     selection_node.alias = selection_node.name = selection_node.content;
+    selection_node.name_symbol = last_token_symbol;
+    selection_node.name_hash_code = last_token_hash;
 
     if (current_token.of_type(token_type::Colon))
     {
@@ -518,7 +524,6 @@ bool parser_t::parse_field()
             return false;
         }
 
-        selection_node.name = current_token.value;
         selection_node.alias = selection_node.content;
         selection_node.size = selection_node.pos;
     }
@@ -575,19 +580,19 @@ bool parser_t::parse_type_extension()
 {
     if (!next_token())
         return report_error(error_code_t::UnexpectedEndOfDocument, "Type extension expected");
-    switch (hash_crc32(current_token.value))
+    switch (current_token.hash)
     {
-    case "scalar"_crc32:
+    case "scalar"_name_hash:
         return parse_scalar_type_definition(syntax_node_type::ScalarTypeExtension);
-    case "union"_crc32:
+    case "union"_name_hash:
         return parse_union_type_definition(syntax_node_type::UnionTypeExtension);
-    case "enum"_crc32:
+    case "enum"_name_hash:
         return parse_enum_type_definition(syntax_node_type::EnumTypeExtension);
-    case "type"_crc32:
+    case "type"_name_hash:
         return parse_object_type_definition(syntax_node_type::ObjectTypeExtension, "type");
-    case "interface"_crc32:
+    case "interface"_name_hash:
         return parse_object_type_definition(syntax_node_type::InterfaceTypeDefinition, "interface");
-    case "imput"_crc32:
+    case "imput"_name_hash:
         return parse_input_object_type_definition(syntax_node_type::InterfaceTypeDefinition);
     }
     return report_error(error_code_t::InvalidToken, "Expected type, scalar, union, enum, interface or union. Got: {}", current_token.value);
@@ -825,6 +830,8 @@ bool parser_t::parse_name(token_type name_type)
     syntax_node &parent = current_node();
 
     parent.name = current_token.value;
+    parent.name_symbol = current_token.symbol;
+    parent.name_hash_code = current_token.hash;
     return next_token();
 }
 
@@ -897,6 +904,8 @@ bool parser_t::parse_named_type(NodeParseOptions opts)
     if (!parse_node(syntax_node_type::NamedType, token_type::Name, opts))
         return false;
     last_node().name = last_node().content;
+    last_node().name_symbol = last_token_symbol;
+    last_node().name_hash_code = last_token_hash;
     return true;
 }
 
@@ -0,0 +1,149 @@
+#include <data/sql/pg_copy_writer.hpp>
+#include <bit>
+#include <charconv>
+
+namespace blitz_query_cpp::sql
+{
+    static constexpr std::string_view CopySignature{"PGCOPY\n\377\r\n\0", 11};
+
+    copy_type copy_type_of(std::string_view sql_type)
+    {
+        static constexpr std::pair<std::string_view, copy_type> types[] = {
+            {"integer", copy_type::Integer}, {"bigint", copy_type::Bigint}, {"double precision", copy_type::Double},
+            {"boolean", copy_type::Boolean}, {"uuid", copy_type::Uuid}};
+        for (auto [name, type] : types)
+        {
+            if (name == sql_type)
+                return type;
+        }
+        return copy_type::Text;
+    }
+
+    copy_binary_writer::copy_binary_writer()
+    {
+        buffer.append(CopySignature);
+        write_int32(0); // flags
+        write_int32(0); // header extension length
+    }
+
+    // integers are in network byte order
+    void copy_binary_writer::write_int16(int16_t value)
+    {
+        buffer.append(1, char(uint16_t(value) >> 8));
+        buffer.append(1, char(value));
+    }
+
+    void copy_binary_writer::write_int32(int32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            buffer.append(1, char(uint32_t(value) >> shift));
+    }
+
+    void copy_binary_writer::write_int64(int64_t value)
+    {
+        for (int shift = 56; shift >= 0; shift -= 8)
+            buffer.append(1, char(uint64_t(value) >> shift));
+    }
+
+    void copy_binary_writer::begin_row(int16_t columns_count)
+    {
+        write_int16(columns_count);
+    }
+
+    void copy_binary_writer::write_null()
+    {
+        write_int32(-1);
+    }
+
+    template <class T>
+    static bool parse_number(std::string_view text, T &value)
+    {
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc{} && ptr == text.data() + text.size();
+    }
+
+    static int hex_digit(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    }
+
+    bool copy_binary_writer::write_value(copy_type type, std::string_view text)
+    {
+        switch (type)
+        {
+        case copy_type::Integer:
+        {
+            int32_t value = 0;
+            if (!parse_number(text, value))
+                return false;
+            write_int32(4);
+            write_int32(value);
+            return true;
+        }
+        case copy_type::Bigint:
+        {
+            int64_t value = 0;
+            if (!parse_number(text, value))
+                return false;
+            write_int32(8);
+            write_int64(value);
+            return true;
+        }
+        case copy_type::Double:
+        {
+            double value = 0;
+            if (!parse_number(text, value))
+                return false;
+            write_int32(8);
+            write_int64(std::bit_cast<int64_t>(value));
+            return true;
+        }
+        case copy_type::Boolean:
+            if (text != "true" && text != "false")
+                return false;
+            write_int32(1);
+            buffer.append(1, text == "true" ? '\1' : '\0');
+            return true;
+        case copy_type::Uuid:
+        {
+            // 32 hex digits, hyphens are optional
+            char bytes[16];
+            int digits = 0;
+            for (char c : text)
+            {
+                if (c == '-')
+                    continue;
+                int digit = hex_digit(c);
+                if (digit < 0 || digits == 32)
+                    return false;
+                if (digits % 2 == 0)
+                    bytes[digits / 2] = char(digit << 4);
+                else
+                    bytes[digits / 2] = char(bytes[digits / 2] | digit);
+                digits++;
+            }
+            if (digits != 32)
+                return false;
+            write_int32(16);
+            buffer.append(bytes, sizeof(bytes));
+            return true;
+        }
+        default:
+            write_int32(int32_t(text.size()));
+            buffer.append(text);
+            return true;
+        }
+    }
+
+    std::string_view copy_binary_writer::finish()
+    {
+        write_int16(-1);
+        return buffer;
+    }
+}
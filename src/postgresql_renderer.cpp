@@ -1,367 +1,582 @@
 #include "data/sql/postgresql_renderer.hpp"
+#include "data/sql/sql_mapping.hpp"
 #include <algorithm>
-#include <vector>
-#include <ranges>
+#include <charconv>
 
 namespace blitz_query_cpp::sql
 {
+    bool pg_need_to_qoute(std::string_view value)
+    {
+        // identifiers quoted at schema compile
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            return false;
+        return pg_need_to_quote(value);
+    }
 
-    void postgresql_renderer::visit_children(expr_node &node, std::string_view separator, std::string_view end)
+    std::string pg_array_literal(std::span<const std::string_view> values)
     {
-        bool last = true;
-        for (auto &&child : std::ranges::reverse_view(node.expr->children))
+        std::string res;
+        res.reserve(values.size() * 8 + 2);
+        res.append(1, '{');
+        for (size_t i = 0; i < values.size(); i++)
         {
-            if (last)
+            if (i > 0)
+                res.append(1, ',');
+            res.append(1, '"');
+            for (char c : values[i])
             {
-                if (!end.empty())
-                    node_stack.emplace_back(nullptr, end);
+                if (c == '"' || c == '\\')
+                    res.append(1, '\\');
+                res.append(1, c);
             }
-            else
+            res.append(1, '"');
+        }
+        res.append(1, '}');
+        return res;
+    }
+
+    std::string pg_like_pattern(std::string_view value, like_match match)
+    {
+        std::string res;
+        res.reserve(value.size() + 4);
+        if (match != like_match::Prefix)
+            res.append(1, '%');
+        for (char c : value)
+        {
+            if (c == '%' || c == '_' || c == '\\')
+                res.append(1, '\\');
+            res.append(1, c);
+        }
+        if (match != like_match::Suffix)
+            res.append(1, '%');
+        return res;
+    }
+
+    static constexpr size_t MinCapacity = 256;
+
+    // rough output size, buffer grows if estimation is too small
+    static size_t estimate_size(const sql_node *node)
+    {
+        // keywords, separators and quotes
+        size_t size = node->value.size() + 8;
+        for (const sql_node *child : node->get_children())
+            size += estimate_size(child);
+        if (node->clauses)
+        {
+            for (int c = 0; c < int(select_clause::Count); c++)
             {
-                if (!separator.empty())
-                    node_stack.emplace_back(nullptr, separator);
+                if (node->clauses[c])
+                    size += estimate_size(node->clauses[c]);
             }
-            node_stack.emplace_back(&child);
-            last = false;
         }
+        return size;
     }
 
-    void postgresql_renderer::push_value(std::string_view value)
+    void postgresql_renderer::write_quoted_value(std::string_view value)
     {
-        node_stack.emplace_back(nullptr, value);
+        bool quote = pg_need_to_qoute(value);
+        if (quote)
+            buffer.append(1, '"');
+        buffer.append(value);
+        if (quote)
+            buffer.append(1, '"');
     }
 
-    void postgresql_renderer::push_node(const sql_expr_t &node)
+    // standard_conforming_strings is on by default, so only quotes are escaped
+    void postgresql_renderer::write_string_literal(std::string_view value)
     {
-        node_stack.emplace_back(&node);
+        buffer.append(1, '\'');
+        for (size_t pos = value.find('\''); pos != std::string_view::npos; pos = value.find('\''))
+        {
+            buffer.append(value.substr(0, pos + 1));
+            buffer.append(1, '\'');
+            value.remove_prefix(pos + 1);
+        }
+        buffer.append(value);
+        buffer.append(1, '\'');
     }
 
-    bool postgresql_renderer::handle_binary_op(expr_node &current, std::string_view op)
+    static parameter_type number_type(std::string_view value)
     {
-        if (current.expr->children.size() < 2)
+        if (value.starts_with('-'))
+            value.remove_prefix(1);
+        bool integer = !value.empty() && std::all_of(value.begin(), value.end(), [](char c)
+                                                     { return c >= '0' && c <= '9'; });
+        return integer ? parameter_type::Integer : parameter_type::Numeric;
+    }
+
+    void postgresql_renderer::write_literal(parameter_type type, std::string_view value)
+    {
+        if (parameterize_literals)
+        {
+            parameters.push_back(query_parameter{type, value});
+            char number[16];
+            auto res = std::to_chars(number, number + sizeof(number), first_parameter + int(parameters.size()) - 1);
+            buffer.append(1, '$');
+            buffer.append(number, res.ptr);
+            return;
+        }
+        if (type == parameter_type::Text)
+            write_string_literal(value);
+        else
+            buffer.append(value);
+    }
+
+    bool postgresql_renderer::render_children(const sql_node *node, std::string_view separator)
+    {
+        bool first = true;
+        for (const sql_node *child : node->get_children())
+        {
+            if (!first)
+                buffer.append(separator);
+            if (!render_node(child))
+                return false;
+            first = false;
+        }
+        return true;
+    }
+
+    bool postgresql_renderer::render_clauses(const sql_node *node)
+    {
+        if (!node->clauses)
+            return render_children(node);
+        for (int c = 0; c < int(select_clause::Count); c++)
+        {
+            const sql_node *clause = node->clauses[c];
+            if (!clause)
+                continue;
+            // joins slot is a list of join nodes
+            if (!(c == int(select_clause::Joins) ? render_children(clause) : render_node(clause)))
+                return false;
+        }
+        return true;
+    }
+
+    // values, columns and function calls bind tighter than any operator
+    static constexpr int ValuePrecedence = 10;
+
+    // PostgreSQL operator precedence, WHERE and HAVING lists are AND
+    static int precedence(sql_expr_type type)
+    {
+        switch (type)
+        {
+        case sql_expr_type::Or:
+            return 1;
+        case sql_expr_type::And:
+        case sql_expr_type::Where:
+        case sql_expr_type::Having:
+            return 2;
+        case sql_expr_type::Not:
+            return 3;
+        case sql_expr_type::IsNull:
+        case sql_expr_type::IsNotNull:
+            return 4;
+        case sql_expr_type::Eq:
+        case sql_expr_type::Ne:
+        case sql_expr_type::Le:
+        case sql_expr_type::Gt:
+        case sql_expr_type::Lq:
+        case sql_expr_type::Gq:
+            return 5;
+        case sql_expr_type::Like:
+            return 6;
+        case sql_expr_type::Plus:
+        case sql_expr_type::Minus:
+            return 7;
+        case sql_expr_type::Multiply:
+        case sql_expr_type::Divide:
+            return 8;
+        default:
+            return ValuePrecedence;
+        }
+    }
+
+    // Operand is in parens when it binds weaker than its operator or is the
+    // right operand of the same precedence. AND inside OR is grouped too, and
+    // operands of unary operators and casts which are not values, so
+    // conditions read as they are evaluated.
+    static bool needs_parens(sql_expr_type op, const sql_node *operand, bool first)
+    {
+        if (op == sql_expr_type::Where || op == sql_expr_type::Having)
+            op = sql_expr_type::And;
+        int operand_precedence = precedence(operand->type);
+        if (operand_precedence == ValuePrecedence)
             return false;
-        bool need_paren = current.expr->children[0].children.size() > 0 || current.expr->children[1].children.size() > 0;
-        if (need_paren)
-            push_value(")");
-        push_node(current.expr->children[1]);
-        push_value(op);
-        push_node(current.expr->children[0]);
-        if (need_paren)
-            buffer.append(1, '(');
+        if (op == sql_expr_type::Not || op == sql_expr_type::IsNull || op == sql_expr_type::IsNotNull || op == sql_expr_type::Cast)
+            return true;
+        if (operand->type == op && (op == sql_expr_type::And || op == sql_expr_type::Or))
+            return false;
+        if (operand->type == sql_expr_type::And && op == sql_expr_type::Or)
+            return true;
+        int op_precedence = precedence(op);
+        return operand_precedence < op_precedence || (operand_precedence == op_precedence && !first);
+    }
 
+    bool postgresql_renderer::render_operand(sql_expr_type op, const sql_node *operand, bool first)
+    {
+        bool parens = needs_parens(op, operand, first);
+        if (parens)
+            buffer.append(1, '(');
+        if (!render_node(operand))
+            return false;
+        if (parens)
+            buffer.append(1, ')');
         return true;
     }
 
-    bool postgresql_renderer::handle_join(expr_node &current, std::string_view join_type)
+    // flattened AND and OR have more than two operands
+    bool postgresql_renderer::render_operands(const sql_node *node, std::string_view op)
     {
-        buffer.append(join_type);
-        visit_children(current);
+        for (uint32_t i = 0; i < node->children_count; i++)
+        {
+            if (i > 0)
+                buffer.append(op);
+            if (!render_operand(node->type, node->children[i], i == 0))
+                return false;
+        }
         return true;
     }
 
-    bool pg_need_to_qoute(std::string_view value)
+    bool postgresql_renderer::render_binary_op(const sql_node *node, std::string_view op)
     {
-        return !std::all_of(value.begin(), value.end(), [](char c)
-                            { return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_'; });
+        if (node->children_count < 2)
+            return false;
+        return render_operands(node, op);
     }
 
-    void postgresql_renderer::write_quoted_value(expr_node &current)
+    bool postgresql_renderer::render_join(const sql_node *node, std::string_view join_type)
     {
-        bool quote = pg_need_to_qoute(current.expr->value);
-        if (quote)
+        buffer.append(join_type);
+        return render_children(node);
+    }
+
+    bool postgresql_renderer::render_ordering(const sql_node *node, std::string_view direction)
+    {
+        if (node->children_count == 0)
+        {
             buffer.append(1, '"');
-        buffer.append(current.expr->value);
-        if (quote)
+            buffer.append(node->value);
             buffer.append(1, '"');
+        }
+        else if (!render_children(node))
+            return false;
+        buffer.append(direction);
+        return true;
     }
 
-    bool postgresql_renderer::render(const sql_expr_t &expr)
+    bool postgresql_renderer::render_node(const sql_node *node)
     {
-        push_node(expr);
-
-        while (!node_stack.empty())
+        switch (node->type)
         {
-            expr_node current = node_stack.back();
-            node_stack.pop_back();
-            if (current.expr == nullptr)
+        case sql_expr_type::Column:
+            write_quoted_value(node->value);
+            return true;
+        case sql_expr_type::TableName:
+            write_quoted_value(node->value);
+            // write column ref if any
+            if (node->children_count == 0)
+                return true;
+            buffer.append(1, '.');
+            return render_node(node->children[0]);
+        case sql_expr_type::SchemaName:
+            write_quoted_value(node->value);
+            buffer.append(1, '.');
+            if (node->children_count == 0)
+                return false;
+            return render_node(node->children[0]);
+        case sql_expr_type::Function:
+            buffer.append(node->value);
+            buffer.append(1, '(');
+            if (!render_children(node, ", "))
+                return false;
+            buffer.append(1, ')');
+            return true;
+        case sql_expr_type::StringLiteral:
+            write_literal(parameter_type::Text, node->value);
+            return true;
+        case sql_expr_type::NumberLiteral:
+            write_literal(number_type(node->value), node->value);
+            return true;
+        case sql_expr_type::BoolLiteral:
+            buffer.append(node->value);
+            return true;
+        case sql_expr_type::Parameter:
+            if (parameterize_literals && number_type(node->value) != parameter_type::Integer)
             {
-                buffer.append(current.value);
-                continue;
+                write_literal(parameter_type::Variable, node->value);
+                return true;
             }
+            buffer.append(1, '$');
+            buffer.append(node->value);
+            return true;
+        case sql_expr_type::Asias:
+        {
+            bool need_paren = node->children_count > 1 ||
+                              (node->children_count == 1 && (node->children[0]->type == sql_expr_type::Select || node->children[0]->type == sql_expr_type::SelectDistinct ||
+                                                             node->children[0]->type == sql_expr_type::Values));
+            if (need_paren)
+                buffer.append(1, '(');
+            if (!render_children(node, ", "))
+                return false;
+            if (need_paren)
+                buffer.append(1, ')');
+            buffer.append(" as ");
+            write_quoted_value(node->value);
+            return true;
+        }
+        case sql_expr_type::Row:
+            buffer.append(1, '(');
+            if (!render_children(node, ", "))
+                return false;
+            buffer.append(1, ')');
+            return true;
+        case sql_expr_type::Null:
+            buffer.append("NULL");
+            return true;
+        case sql_expr_type::Star:
+            buffer.append(1, '*');
+            return true;
+        case sql_expr_type::Window:
+            if (node->children_count != 1 || !render_node(node->children[0]))
+                return false;
+            buffer.append(" OVER ()");
+            return true;
+        case sql_expr_type::Cast:
+            if (node->children_count != 1 || !render_operand(node->type, node->children[0], true))
+                return false;
+            buffer.append("::");
+            buffer.append(node->value);
+            return true;
+        case sql_expr_type::JsonObject:
+            buffer.append("json_build_object(");
+            if (!render_children(node, ", "))
+                return false;
+            buffer.append(1, ')');
+            return true;
+        case sql_expr_type::JsonField:
+            // keys are part of query shape, they are never parameters
+            if (node->children_count != 1)
+                return false;
+            write_string_literal(node->value);
+            buffer.append(", ");
+            return render_node(node->children[0]);
+        case sql_expr_type::JsonLiteral:
+            write_string_literal(node->value);
+            buffer.append("::json");
+            return true;
+        case sql_expr_type::JsonArrayElement:
+            if (node->children_count != 1)
+                return false;
+            buffer.append(1, '(');
+            if (!render_node(node->children[0]))
+                return false;
+            buffer.append(")->");
+            buffer.append(node->value);
+            return true;
+        case sql_expr_type::Plus:
+            return render_binary_op(node, " + ");
+        case sql_expr_type::Minus:
+            return render_binary_op(node, " - ");
+        case sql_expr_type::Multiply:
+            return render_binary_op(node, " * ");
+        case sql_expr_type::Divide:
+            return render_binary_op(node, " / ");
+        case sql_expr_type::And:
+            return render_binary_op(node, " AND ");
+        case sql_expr_type::Or:
+            return render_binary_op(node, " OR ");
+        case sql_expr_type::Eq: // =
+            return render_binary_op(node, " = ");
+        case sql_expr_type::Ne: // <>
+            return render_binary_op(node, " <> ");
+        case sql_expr_type::Le: // <
+            return render_binary_op(node, " < ");
+        case sql_expr_type::Gt: // >
+            return render_binary_op(node, " > ");
+        case sql_expr_type::Lq: // <=
+            return render_binary_op(node, " <= ");
+        case sql_expr_type::Gq: // >=
+            return render_binary_op(node, " >= ");
+        case sql_expr_type::Like:
+            return render_binary_op(node, " LIKE ");
 
-            switch (current.expr->type)
+        case sql_expr_type::Select:
+            buffer.append("SELECT ");
+            return render_clauses(node);
+        case sql_expr_type::SelectDistinct:
+            buffer.append("SELECT DISTINCT ");
+            return render_clauses(node);
+        case sql_expr_type::From:
+            buffer.append(" FROM ");
+            if (node->children_count == 0)
             {
-            case sql_expr_type::Column:
-                write_quoted_value(current);
-                break;
-            case sql_expr_type::TableName:
-                write_quoted_value(current);
-                // write column ref if any
-                if (current.expr->children.size() > 0)
-                {
-                    buffer.append(1, '.');
-                    push_node(current.expr->children[0]);
-                }
-                break;
-            case sql_expr_type::SchemaName:
+                buffer.append(1, '"');
+                buffer.append(node->value);
+                buffer.append(1, '"');
+                return true;
+            }
+            if (node->children[0]->type == sql_expr_type::Select || node->children[0]->type == sql_expr_type::SelectDistinct)
             {
-                bool quote = pg_need_to_qoute(current.expr->value);
-                if (quote)
-                    buffer.append(1, '"');
-                buffer.append(current.expr->value);
-                if (quote)
-                    buffer.append(1, '"');
-                buffer.append(1, '.');
-                if (current.expr->children.size() == 0)
+                buffer.append(1, '(');
+                if (!render_children(node, "), ("))
                     return false;
-                push_node(current.expr->children[0]);
+                buffer.append(1, ')');
+                return true;
             }
-            break;
-            case sql_expr_type::Function:
-                buffer.append(current.expr->value);
-                buffer.append(1, '(');
-                visit_children(current, ", ", ")");
-                break;
-            case sql_expr_type::StringLiteral:
-                buffer.append(1, '\'');
-                buffer.append(current.expr->value);
-                buffer.append(1, '\'');
-                break;
-            case sql_expr_type::NumberLiteral:
-                buffer.append(current.expr->value);
-                break;
-            case sql_expr_type::Parameter:
-                buffer.append(1, '$');
-                buffer.append(current.expr->value);
-                break;
-            case sql_expr_type::Asias:
+            return render_children(node, ", ");
+        case sql_expr_type::SelectColumns:
+            return render_children(node, ", ");
+        case sql_expr_type::Where:
+            buffer.append(" WHERE ");
+            return render_operands(node, " AND ");
+        case sql_expr_type::Having:
+            buffer.append(" HAVING ");
+            return render_operands(node, " AND ");
+        case sql_expr_type::Group:
+            buffer.append(" GROUP BY ");
+            return render_children(node, ", ");
+        case sql_expr_type::Order:
+            buffer.append(" ORDER BY ");
+            return render_children(node, ", ");
+        case sql_expr_type::InnerJoin:
+            return render_join(node, " INNER JOIN ");
+        case sql_expr_type::LeftJoin:
+            return render_join(node, " LEFT JOIN ");
+        case sql_expr_type::RightJoin:
+            return render_join(node, " RIGHT JOIN ");
+        case sql_expr_type::OuterJoin:
+            return render_join(node, " FULL OUTER JOIN ");
+        case sql_expr_type::LeftJoinLateral:
+            return render_join(node, " LEFT JOIN LATERAL ");
+        case sql_expr_type::On:
+            // columns to compare or condition
+            if (node->children_count != 2 && node->children_count != 1)
+                return false;
+            buffer.append(" ON ");
+            return render_children(node, " = ");
+        case sql_expr_type::Beetween:
+            buffer.append("BEETWEEN ");
+            if (node->children_count != 2)
+                return false;
+            return render_children(node, " AND ");
+        case sql_expr_type::Exists:
+            buffer.append("EXISTS(");
+            if (node->children_count != 1)
+                return false;
+            if (!render_node(node->children[0]))
+                return false;
+            buffer.append(") ");
+            return true;
+        case sql_expr_type::In:
+            buffer.append("IN( ");
+            if (!render_children(node, ", "))
+                return false;
+            buffer.append(") ");
+            return true;
+        case sql_expr_type::IsNull:
+            if (node->children_count == 1 && !render_operand(node->type, node->children[0], true))
+                return false;
+            buffer.append(" IS NULL");
+            return true;
+        case sql_expr_type::IsNotNull:
+            if (node->children_count == 1 && !render_operand(node->type, node->children[0], true))
+                return false;
+            buffer.append(" IS NOT NULL");
+            return true;
+        case sql_expr_type::Limit:
+            buffer.append(" LIMIT ");
+            if (node->children_count == 1)
+                return render_node(node->children[0]);
+            write_literal(parameter_type::Integer, node->value);
+            return true;
+        case sql_expr_type::Offset:
+            buffer.append(" OFFSET ");
+            if (node->children_count == 1)
+                return render_node(node->children[0]);
+            write_literal(parameter_type::Integer, node->value);
+            return true;
+        case sql_expr_type::Asc:
+            return render_ordering(node, " ASC");
+        case sql_expr_type::Desc:
+            return render_ordering(node, " DESC");
+        case sql_expr_type::Not:
+            if (node->children_count != 1)
+                return false;
+            buffer.append("NOT ");
+            return render_operand(node->type, node->children[0], true);
+        // clauses of INSERT, UPDATE and DELETE are children in order of rendering
+        case sql_expr_type::Insert:
+            // table, columns row, VALUES or SELECT, optional ON CONFLICT and RETURNING
+            if (node->children_count < 3)
+                return false;
+            buffer.append("INSERT INTO ");
+            for (uint32_t i = 0; i < node->children_count; i++)
             {
-                std::string alias;
-                alias.reserve(current.expr->value.size() + 8);
-                if (current.expr->children.size() > 1)
-                {
-                    alias.append(")");
-                    buffer.append("(");
-                }
-                alias.append(" as ");
-                bool quote = pg_need_to_qoute(current.expr->value);
-                if (quote)
-                    alias.append(1, '"');
-                alias.append(current.expr->value);
-                if (quote)
-                    alias.append(1, '"');
-                visit_children(current, ", ", alias);
-            }
-            break;
-            case sql_expr_type::Plus:
-                if (!handle_binary_op(current, " + "))
+                if (i == 1 || i == 2)
+                    buffer.append(1, ' ');
+                if (!render_node(node->children[i]))
                     return false;
-                break;
-            case sql_expr_type::Minus:
-                if (!handle_binary_op(current, " - "))
-                    return false;
-                break;
-            case sql_expr_type::Multiply:
-                if (!handle_binary_op(current, " * "))
-                    return false;
-                break;
-            case sql_expr_type::Divide:
-                if (!handle_binary_op(current, " / "))
-                    return false;
-                break;
-            case sql_expr_type::And:
-                if (!handle_binary_op(current, " AND "))
-                    return false;
-                break;
-            case sql_expr_type::Or:
-                if (!handle_binary_op(current, " OR "))
-                    return false;
-                break;
-            case sql_expr_type::Eq: // =
-                if (!handle_binary_op(current, " = "))
-                    return false;
-                break;
-            case sql_expr_type::Ne: // <>
-                if (!handle_binary_op(current, " <> "))
-                    return false;
-                break;
-            case sql_expr_type::Le: // <
-                if (!handle_binary_op(current, " < "))
-                    return false;
-                break;
-            case sql_expr_type::Gt: // >
-                if (!handle_binary_op(current, " > "))
-                    return false;
-                break;
-            case sql_expr_type::Lq: // <=
-                if (!handle_binary_op(current, " <= "))
-                    return false;
-                break;
-            case sql_expr_type::Gq: // >=
-                if (!handle_binary_op(current, " >= "))
-                    return false;
-                break;
-            case sql_expr_type::Like:
-                if (!handle_binary_op(current, " LIKE "))
-                    return false;
-                break;
-
-            case sql_expr_type::Select:
-                buffer.append("SELECT ");
-                visit_children(current);
-                break;
-            case sql_expr_type::SelectDistinct:
-                buffer.append("SELECT DISTINCT ");
-                visit_children(current);
-                break;
-            case sql_expr_type::From:
-                buffer.append(" FROM ");
-                if (current.expr->children.size() == 0)
-                {
-                    buffer.append(1, '"');
-                    buffer.append(current.expr->value);
-                    buffer.append(1, '"');
-                }
-                else
-                {
-                    std::string_view end, sep = ", ";
-                    if (current.expr->children[0].type == sql_expr_type::Select || current.expr->children[0].type == sql_expr_type::SelectDistinct)
-                    {
-                        buffer.append(1, '(');
-                        end = ")";
-                        sep = "), (";
-                    }
-                    visit_children(current, sep, end);
-                }
-                break;
-            case sql_expr_type::Insert:
-                break;
-            case sql_expr_type::Update:
-                break;
-            case sql_expr_type::Delete:
-                break;
-            case sql_expr_type::SelectColumns:
-                visit_children(current, ", ");
-                break;
-            case sql_expr_type::Where:
-                buffer.append(" WHERE ");
-                visit_children(current, " AND ");
-                break;
-            case sql_expr_type::Having:
-                visit_children(current, " AND ");
-                break;
-            case sql_expr_type::Group:
-                buffer.append(" GROUP BY ");
-                visit_children(current, ", ");
-                break;
-            case sql_expr_type::Order:
-                buffer.append(" ORDER BY ");
-                visit_children(current, ", ");
-                break;
-            case sql_expr_type::InnerJoin:
-                if (!handle_join(current, " INNER JOIN "))
-                    return false;
-                break;
-            case sql_expr_type::LeftJoin:
-                if (!handle_join(current, " LEFT JOIN "))
-                    return false;
-                break;
-            case sql_expr_type::RightJoin:
-                if (!handle_join(current, " RIGHT JOIN "))
-                    return false;
-                break;
-            case sql_expr_type::OuterJoin:
-                if (!handle_join(current, " FULL OUTER JOIN "))
-                    return false;
-                break;
-            case sql_expr_type::On:
-                if (current.expr->children.size() != 2)
-                    return false;
-                buffer.append(" ON ");
-                push_node(current.expr->children[1]);
-                push_value(" = ");
-                push_node(current.expr->children[0]);
-                break;
-            case sql_expr_type::Values:
-                break;
-            case sql_expr_type::All:
-                break;
-            case sql_expr_type::Any:
-                break;
-            case sql_expr_type::Beetween:
-                buffer.append("BEETWEEN ");
-                if (current.expr->children.size() != 2)
-                    return false;
-                visit_children(current, " AND ");
-                break;
-            case sql_expr_type::Exists:
-                buffer.append("EXISTS(");
-                if (current.expr->children.size() != 1)
-                    return false;
-                visit_children(current, "", ") ");
-                break;
-            case sql_expr_type::In:
-                buffer.append("IN( ");
-                visit_children(current, ", ", ") ");
-                break;
-            case sql_expr_type::IsNull:
-                buffer.append(" IS NULL");
-                break;
-            case sql_expr_type::IsNotNull:
-                buffer.append(" NOT IS NULL");
-                break;
-            case sql_expr_type::Limit:
-                buffer.append(" LIMIT ");
-                buffer.append(current.expr->value);
-                break;
-            case sql_expr_type::Asc:
-                if (current.expr->children.size() == 0)
-                {
-                    buffer.append(1, '"');
-                    buffer.append(current.expr->value);
-                    buffer.append(1, '"');
-                    buffer.append(" ASC");
-                }
-                else
-                {
-                    push_value(" ASC");
-                    visit_children(current);
-                }
-                break;
-            case sql_expr_type::Desc:
-                if (current.expr->children.size() == 0)
-                {
-                    buffer.append(1, '"');
-                    buffer.append(current.expr->value);
-                    buffer.append(1, '"');
-                    buffer.append(" DESC");
-                }
-                else
-                {
-                    push_value(" DESC");
-                    visit_children(current);
-                }
-                break;
-            case sql_expr_type::Not:
-                buffer.append(" NOT ");
-                if (current.expr->children.size() != 1)
+            }
+            return true;
+        case sql_expr_type::Update:
+            buffer.append("UPDATE ");
+            return render_children(node);
+        case sql_expr_type::Delete:
+            buffer.append("DELETE FROM ");
+            return render_children(node);
+        case sql_expr_type::Values:
+            buffer.append("VALUES ");
+            return render_children(node, ", ");
+        case sql_expr_type::Set:
+            // column = value pairs, target columns are not qualified
+            buffer.append(" SET ");
+            for (uint32_t i = 0; i < node->children_count; i++)
+            {
+                if (i > 0)
+                    buffer.append(", ");
+                if (node->children[i]->type != sql_expr_type::Eq || !render_children(node->children[i], " = "))
                     return false;
-                push_node(current.expr->children[0]);
-                break;
-            case sql_expr_type::Set:
-                break;
-            case sql_expr_type::Union:
-                break;
-            case sql_expr_type::UnionAll:
-                break;
-            case sql_expr_type::Offset:
-                buffer.append(" OFFSET ");
-                buffer.append(current.expr->value);
-                break;
-            default:
-                return false;
             }
+            return true;
+        case sql_expr_type::Using:
+            buffer.append(" USING ");
+            return render_children(node, ", ");
+        case sql_expr_type::OnConflict:
+            buffer.append(" ON CONFLICT");
+            if (node->children_count == 0)
+            {
+                buffer.append(" DO NOTHING");
+                return true;
+            }
+            if (node->children_count != 2)
+                return false;
+            buffer.append(1, ' ');
+            if (!render_node(node->children[0]))
+                return false;
+            buffer.append(" DO UPDATE");
+            return render_node(node->children[1]);
+        case sql_expr_type::Returning:
+            buffer.append(" RETURNING ");
+            return render_children(node, ", ");
+        case sql_expr_type::All:
+        case sql_expr_type::Any:
+        case sql_expr_type::Union:
+        case sql_expr_type::UnionAll:
+            return true;
+        default:
+            return false;
         }
-        return true;
     }
-}
\ No newline at end of file
+
+    bool postgresql_renderer::render(const sql_expr_t &expr)
+    {
+        buffer.clear();
+        parameters.clear();
+        if (!expr.node)
+            return false;
+        // reused renderer already has a buffer of typical size
+        if (buffer.capacity() < MinCapacity)
+            buffer.reserve(estimate_size(expr.node));
+        return render_node(expr.node);
+    }
+}
@@ -0,0 +1,511 @@
+#include <processing/query_plan_cache.hpp>
+#include <parser/document_signature.hpp>
+#include <data/sql/sql_mapping.hpp>
+#include <util/cursor.hpp>
+#include <algorithm>
+
+namespace blitz_query_cpp
+{
+    // only 64 conditions fit the key
+    static constexpr size_t MaxConditions = 64;
+
+    static constexpr std::string_view LikeSuffixes[] = {"#prefix", "#suffix", "#contains"};
+    static constexpr std::string_view ListSuffix = "#list";
+
+    std::string like_parameter_name(std::string_view variable, sql::like_match match)
+    {
+        std::string res{variable};
+        res.append(LikeSuffixes[int(match)]);
+        return res;
+    }
+
+    bool parse_like_parameter_name(std::string_view name, std::string_view &variable, sql::like_match &match)
+    {
+        for (int i = 0; i < int(std::size(LikeSuffixes)); i++)
+        {
+            if (name.ends_with(LikeSuffixes[i]))
+            {
+                variable = name.substr(0, name.size() - LikeSuffixes[i].size());
+                match = sql::like_match(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string list_parameter_name(std::string_view variable)
+    {
+        std::string res{variable};
+        res.append(ListSuffix);
+        return res;
+    }
+
+    bool parse_list_parameter_name(std::string_view name, std::string_view &variable)
+    {
+        if (!name.ends_with(ListSuffix))
+            return false;
+        variable = name.substr(0, name.size() - ListSuffix.size());
+        return true;
+    }
+
+    static bool is_separator(char c)
+    {
+        return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static void skip_separators(std::string_view value, size_t &pos)
+    {
+        while (pos < value.size() && is_separator(value[pos]))
+            pos++;
+    }
+
+    // JSON string at pos, escapes are decoded
+    static bool parse_string_value(std::string_view value, size_t &pos, std::string &res)
+    {
+        for (pos++; pos < value.size() && value[pos] != '"'; pos++)
+        {
+            char c = value[pos];
+            if (c == '\\')
+            {
+                if (++pos >= value.size())
+                    return false;
+                switch (value[pos])
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    c = value[pos];
+                    break;
+                case 'n':
+                    c = '\n';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                default:
+                    return false;
+                }
+            }
+            res.push_back(c);
+        }
+        if (pos >= value.size())
+            return false;
+        pos++;
+        return true;
+    }
+
+    // number, true or false at pos, null and nested values are not scalars
+    static bool parse_scalar_value(std::string_view value, size_t &pos, std::string_view &res)
+    {
+        size_t start = pos;
+        while (pos < value.size() && value[pos] != ']' && value[pos] != '}' && value[pos] != ':' && !is_separator(value[pos]))
+            pos++;
+        res = value.substr(start, pos - start);
+        return !res.empty() && res != "null" && !res.starts_with('[') && !res.starts_with('{');
+    }
+
+    // items of list variable, JSON array of scalars like [1, "a"]; commas are optional as in GraphQL
+    static bool parse_list_value(std::string_view value, std::vector<std::string> &items)
+    {
+        size_t pos = 0;
+        skip_separators(value, pos);
+        if (pos >= value.size() || value[pos] != '[')
+            return false;
+        pos++;
+        while (true)
+        {
+            skip_separators(value, pos);
+            if (pos >= value.size())
+                return false;
+            if (value[pos] == ']')
+            {
+                pos++;
+                skip_separators(value, pos);
+                return pos == value.size();
+            }
+            if (value[pos] != '"')
+            {
+                std::string_view item;
+                if (!parse_scalar_value(value, pos, item))
+                    return false;
+                items.emplace_back(item);
+                continue;
+            }
+            if (!parse_string_value(value, pos, items.emplace_back()))
+                return false;
+        }
+    }
+
+    // rows of list variable of input objects, JSON array of objects with scalar
+    // fields like [{"id": 1, "name": null}]; values are in order of fields, missing ones are null
+    static bool parse_object_list_value(std::string_view value, const std::vector<std::string> &fields, std::vector<bulk_value> &values)
+    {
+        size_t pos = 0;
+        skip_separators(value, pos);
+        if (pos >= value.size() || value[pos] != '[')
+            return false;
+        pos++;
+        while (true)
+        {
+            skip_separators(value, pos);
+            if (pos >= value.size())
+                return false;
+            if (value[pos] == ']')
+            {
+                pos++;
+                skip_separators(value, pos);
+                return pos == value.size();
+            }
+            if (value[pos] != '{')
+                return false;
+            pos++;
+            size_t row = values.size();
+            values.resize(row + fields.size(), bulk_value{{}, false, true});
+            std::string name;
+            while (true)
+            {
+                skip_separators(value, pos);
+                if (pos >= value.size())
+                    return false;
+                if (value[pos] == '}')
+                {
+                    pos++;
+                    break;
+                }
+                name.clear();
+                if (value[pos] != '"' || !parse_string_value(value, pos, name))
+                    return false;
+                skip_separators(value, pos);
+                if (pos >= value.size() || value[pos] != ':')
+                    return false;
+                pos++;
+                skip_separators(value, pos);
+                auto field = std::find(fields.begin(), fields.end(), name);
+                if (field == fields.end() || pos >= value.size())
+                    return false;
+                bulk_value &res = values[row + (field - fields.begin())];
+                res.value.clear();
+                if (value[pos] == '"')
+                {
+                    if (!parse_string_value(value, pos, res.value))
+                        return false;
+                    res.is_null = false;
+                    continue;
+                }
+                std::string_view scalar;
+                if (!parse_scalar_value(value, pos, scalar))
+                {
+                    if (scalar != "null")
+                        return false;
+                    res.is_null = true;
+                    continue;
+                }
+                res.value = scalar;
+                res.is_null = false;
+            }
+        }
+    }
+
+    static bool bind_list_value(query_context &context, std::vector<std::string_view> &values, const std::string &parameter_name, std::string_view variable_name)
+    {
+        auto variable = context.variables.find(std::string{variable_name});
+        if (variable == context.variables.end())
+            return context.report_error("Variable '${}' is not provided", variable_name);
+        auto [array, inserted] = context.derived_values.try_emplace(parameter_name);
+        if (inserted)
+        {
+            std::vector<std::string> items;
+            if (!parse_list_value(variable->second, items))
+            {
+                context.derived_values.erase(array);
+                return context.report_error("Variable '${}' should be a list of scalars", variable_name);
+            }
+            std::vector<std::string_view> item_views(items.begin(), items.end());
+            array->second.push_back(sql::pg_array_literal(item_views));
+        }
+        values.emplace_back(array->second[0]);
+        return true;
+    }
+
+    static bool bind_like_pattern(query_context &context, std::vector<std::string_view> &values, const std::string &parameter_name,
+                                  std::string_view variable_name, sql::like_match match)
+    {
+        auto variable = context.variables.find(std::string{variable_name});
+        if (variable == context.variables.end())
+            return context.report_error("Variable '${}' is not provided", variable_name);
+        // parameter values already bound point to existing patterns
+        auto [pattern, inserted] = context.derived_values.try_emplace(parameter_name);
+        if (inserted)
+            pattern->second.push_back(sql::pg_like_pattern(variable->second, match));
+        values.emplace_back(pattern->second[0]);
+        return true;
+    }
+
+    // number of sort key values in cursor, indexes of its parameters repeat for mixed directions
+    static index_t cursor_size(const std::vector<plan_parameter> &parameters, std::string_view variable_name)
+    {
+        index_t res = 0;
+        for (const plan_parameter &param : parameters)
+        {
+            std::string_view variable;
+            index_t index = 0;
+            if (param.type == sql::parameter_type::Variable && parse_cursor_parameter_name(param.value, variable, index) && variable == variable_name)
+                res = std::max(res, index + 1);
+        }
+        return res;
+    }
+
+    // value of cursor parameter is taken from decoded cursor variable
+    static bool bind_cursor_value(query_context &context, std::vector<std::string_view> &values, const std::vector<plan_parameter> &parameters,
+                                  std::string_view variable_name, index_t index)
+    {
+        auto cursor = context.derived_values.find(std::string{variable_name});
+        if (cursor == context.derived_values.end())
+        {
+            auto variable = context.variables.find(std::string{variable_name});
+            if (variable == context.variables.end())
+                return context.report_error("Variable '${}' is not provided", variable_name);
+            cursor = context.derived_values.try_emplace(variable->first).first;
+            if (!decode_cursor(variable->second, cursor->second) || cursor->second.size() != cursor_size(parameters, variable_name))
+            {
+                context.derived_values.erase(cursor);
+                return context.report_error("Variable '${}' is not a valid cursor", variable_name);
+            }
+        }
+        if (index >= cursor->second.size())
+            return context.report_error("Variable '${}' is not a valid cursor", variable_name);
+        values.emplace_back(cursor->second[index]);
+        return true;
+    }
+
+    static bool bind_parameters(query_context &context, const std::vector<plan_parameter> &parameters, std::vector<std::string_view> &values)
+    {
+        values.clear();
+        values.reserve(parameters.size());
+        for (const plan_parameter &param : parameters)
+        {
+            if (param.type != sql::parameter_type::Variable)
+            {
+                values.emplace_back(param.value);
+                continue;
+            }
+            std::string_view derived_from;
+            index_t cursor_index = 0;
+            sql::like_match match;
+            if (parse_cursor_parameter_name(param.value, derived_from, cursor_index))
+            {
+                if (!bind_cursor_value(context, values, parameters, derived_from, cursor_index))
+                    return false;
+                continue;
+            }
+            if (parse_like_parameter_name(param.value, derived_from, match))
+            {
+                if (!bind_like_pattern(context, values, param.value, derived_from, match))
+                    return false;
+                continue;
+            }
+            if (parse_list_parameter_name(param.value, derived_from))
+            {
+                if (!bind_list_value(context, values, param.value, derived_from))
+                    return false;
+                continue;
+            }
+            auto variable = context.variables.find(param.value);
+            if (variable == context.variables.end())
+                return context.report_error("Variable '${}' is not provided", param.value);
+            values.emplace_back(variable->second);
+        }
+        return true;
+    }
+
+    static bool bind_bulk_rows(query_context &context, const bulk_load &bulk, std::vector<bulk_value> &values)
+    {
+        auto variable = context.variables.find(bulk.rows_variable);
+        if (variable == context.variables.end())
+            return context.report_error("Variable '${}' is not provided", bulk.rows_variable);
+        values.clear();
+        if (!parse_object_list_value(variable->second, bulk.input_fields, values))
+            return context.report_error("Variable '${}' should be a list of input objects with scalar fields", bulk.rows_variable);
+        return true;
+    }
+
+    bool compiled_plan::bind(query_context &context) const
+    {
+        if (!bind_parameters(context, parameters, context.parameter_values))
+            return false;
+        context.batch_parameter_values.resize(batches.size());
+        for (size_t i = 0; i < batches.size(); i++)
+        {
+            if (!bind_parameters(context, batches[i].parameters, context.batch_parameter_values[i]))
+                return false;
+        }
+        context.bulk_values.resize(mutations.size());
+        for (size_t i = 0; i < mutations.size(); i++)
+        {
+            if (!mutations[i].bulk.rows_variable.empty() && !bind_bulk_rows(context, mutations[i].bulk, context.bulk_values[i]))
+                return false;
+        }
+        return true;
+    }
+
+    std::shared_ptr<const compiled_plan> query_plan_cache::find(const plan_key &key)
+    {
+        std::lock_guard lock{mutex};
+        auto res = plans.find(key);
+        if (res == plans.end())
+            return nullptr;
+        recently_used.splice(recently_used.begin(), recently_used, res->second.use);
+        return res->second.plan;
+    }
+
+    void query_plan_cache::insert(const plan_key &key, std::shared_ptr<const compiled_plan> plan)
+    {
+        std::lock_guard lock{mutex};
+        if (auto res = plans.find(key); res != plans.end())
+        {
+            res->second.plan = std::move(plan);
+            recently_used.splice(recently_used.begin(), recently_used, res->second.use);
+            return;
+        }
+        if (max_plans == 0)
+            return;
+        if (plans.size() >= max_plans)
+        {
+            plans.erase(*recently_used.back());
+            recently_used.pop_back();
+        }
+        // keys of unordered_map stay in place
+        auto res = plans.emplace(key, entry{std::move(plan), {}}).first;
+        recently_used.push_front(&res->first);
+        res->second.use = recently_used.begin();
+    }
+
+    size_t query_plan_cache::size() const
+    {
+        std::lock_guard lock{mutex};
+        return plans.size();
+    }
+
+    void query_plan_cache::clear()
+    {
+        std::lock_guard lock{mutex};
+        plans.clear();
+        recently_used.clear();
+    }
+
+    bool query_plan_resolver::process(query_context &context)
+    {
+        if (context.is_resolved())
+            return true;
+        plan_key &key = context.plan_cache_key;
+        std::vector<std::string_view> condition_variables;
+        uint64_t signature = document_signature(context.document.doc_value, condition_variables, key.tokens);
+        // not cacheable, handled by regular stages
+        if (signature == 0 || condition_variables.size() > MaxConditions)
+            return true;
+
+        key.schema_version = context.schema->version;
+        key.signature = signature;
+        key.operation_name = context.operation_name;
+        key.conditions = 0;
+        for (size_t i = 0; i < condition_variables.size(); i++)
+        {
+            auto variable = context.variables.find(std::string{condition_variables[i]});
+            if (variable != context.variables.end() && variable->second != "false" && variable->second != "null")
+                key.conditions |= uint64_t(1) << i;
+        }
+
+        auto plan = cache.find(key);
+        if (!plan)
+            return true;
+        if (!plan->bind(context))
+            return false;
+        context.result = std::move(plan);
+        return true;
+    }
+
+    // types of variables are taken from variable definitions of operation,
+    // ID and custom scalars are compared to columns of unknown type
+    static void set_variable_types(query_context &context, std::vector<plan_parameter> &parameters)
+    {
+        auto operation = std::find_if(context.document.children.begin(), context.document.children.end(), [](syntax_node *node)
+                                      { return node->of_type(syntax_node_type::OperationDefinition); });
+        if (operation == context.document.children.end())
+            return;
+        for (plan_parameter &param : parameters)
+        {
+            if (param.type != sql::parameter_type::Variable)
+                continue;
+            param.sql_type.clear();
+            for (syntax_node *variable : (*operation)->variables)
+            {
+                std::string_view name = variable->name;
+                if (name.starts_with('$'))
+                    name.remove_prefix(1);
+                if (name == param.value && variable->definition_type)
+                    param.sql_type = sql::pg_scalar_type(variable->definition_type->name);
+            }
+        }
+    }
+
+    static void add_parameters(std::vector<plan_parameter> &res, const std::vector<sql::query_parameter> &parameters)
+    {
+        res.reserve(res.size() + parameters.size());
+        for (const sql::query_parameter &param : parameters)
+            res.push_back(plan_parameter{param.type, std::string{param.value}, {}});
+    }
+
+    bool query_plan_builder::process(query_context &context)
+    {
+        const sql::sql_expr_t *expr = std::get_if<sql::sql_expr_t>(&context.result);
+        if (!expr || (!expr->node && context.mutation_queries.empty()))
+            return true;
+        // plan is rendered once, so it is worth optimizing
+        if (!optimizer.process(context))
+            return false;
+
+        auto plan = std::make_shared<compiled_plan>();
+        if (expr->node)
+        {
+            if (!renderer.render(*expr))
+                return context.report_error("Failed to render SQL");
+            plan->sql = renderer.get_string();
+            add_parameters(plan->parameters, renderer.get_parameters());
+        }
+        // parameters of every statement are numbered from $1
+        plan->mutations = context.mutations;
+        for (size_t i = 0; i < context.mutation_queries.size(); i++)
+        {
+            if (!renderer.render(context.mutation_queries[i]))
+                return context.report_error("Failed to render SQL");
+            mutation_statement &statement = plan->mutations[i];
+            statement.sql = renderer.get_string();
+            statement.first_parameter = index_t(plan->parameters.size());
+            statement.parameters_count = index_t(renderer.get_parameters().size());
+            add_parameters(plan->parameters, renderer.get_parameters());
+        }
+        set_variable_types(context, plan->parameters);
+        plan->shape = context.shape;
+        plan->batches = context.batches;
+        // $1 of batch query is array of keys
+        for (size_t i = 0; i < context.batch_queries.size(); i++)
+        {
+            if (!batch_renderer.render(context.batch_queries[i]))
+                return context.report_error("Failed to render SQL");
+            batch_load &batch = plan->batches[i];
+            batch.sql = batch_renderer.get_string();
+            add_parameters(batch.parameters, batch_renderer.get_parameters());
+            set_variable_types(context, batch.parameters);
+        }
+
+        if (!plan->bind(context))
+            return false;
+        if (context.plan_cache_key.signature != 0)
+            cache.insert(context.plan_cache_key, plan);
+        context.result = std::shared_ptr<const compiled_plan>{std::move(plan)};
+        return true;
+    }
+}
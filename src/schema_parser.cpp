@@ -1,6 +1,10 @@
 
 #include <type_system/schema_parser.hpp>
 #include <parser/parser.hpp>
+#include <util/parallel_for.hpp>
+#include <util/name_table.hpp>
+#include <data/sql/sql_mapping.hpp>
+#include <atomic>
 
 using namespace blitz_query_cpp;
 
@@ -33,8 +37,8 @@ bool schema_parser_t::parse(schema_t &schema, std::string_view schema_string)
     return true;
 }
 
-bool resolve_field(schema_t &schema, object_type &type, field &item);
-bool resolve_input_value(schema_t &schema, object_type &type, input_value &item);
+bool resolve_field(const schema_t &schema, object_type &type, field &item);
+bool resolve_input_value(const schema_t &schema, object_type &type, input_value &item);
 
 template <class T>
 bool resolve_directives(const schema_t &schema, T &item)
@@ -63,7 +67,7 @@ bool resolve_type(const schema_t &schema, T &item)
     return true;
 }
 
-bool resolve_input_value(schema_t &schema, object_type &type, input_value &item)
+bool resolve_input_value(const schema_t &schema, object_type &type, input_value &item)
 {
     item.declaring_type.type = &type;
 
@@ -76,7 +80,7 @@ bool resolve_input_value(schema_t &schema, object_type &type, input_value &item)
     return true;
 }
 
-bool resolve_field(schema_t &schema, object_type &type, field &item)
+bool resolve_field(const schema_t &schema, object_type &type, field &item)
 {
     if (!resolve_input_value(schema, type, item))
         return false;
@@ -93,42 +97,249 @@ bool resolve_field(schema_t &schema, object_type &type, field &item)
     return true;
 }
 
+void add_type_dependency(schema_t &schema, std::string_view referenced_type, const std::string &dependent_type)
+{
+    if (referenced_type == dependent_type)
+        return;
+    auto deps = schema.type_dependents.find(referenced_type);
+    if (deps == schema.type_dependents.end())
+        deps = schema.type_dependents.emplace(std::string(referenced_type), std::unordered_set<std::string>{}).first;
+    deps->second.insert(dependent_type);
+}
+
+// resolves only objects owned by the type, so it is safe to run for different types in parallel
+// fields with unresolved types are left unresolved, they are reported when used in a query
+bool resolve_type_references(const schema_t &schema, object_type &type)
+{
+    if (!resolve_directives(schema, type))
+        return false;
+
+    for (auto &cf : type.fields)
+    {
+        auto& fld = *const_cast<field*>(&cf);
+        resolve_field(schema, type, fld);
+    }
+
+    type.sql_mapping.reset();
+    if (type.find_directive(sql::TableDirective))
+    {
+        auto mapping = std::make_shared<sql::table_mapping>();
+        sql::build_table_mapping(type, *mapping);
+        type.sql_mapping = std::move(mapping);
+    }
+    return true;
+}
+
+// every compiled schema state gets unique version, caches built from schema are keyed by it
+static uint64_t next_schema_version()
+{
+    static std::atomic<uint64_t> version_counter = 0;
+    return ++version_counter;
+}
+
+// interns names of the type and its fields and adds type to dependency index
+void schema_parser_t::index_type(schema_t &schema, object_type &type)
+{
+    name_table &names = name_table::global();
+    type.symbol = names.intern(type.name);
+    schema.types_by_symbol.insert_or_assign(type.symbol, &type);
+
+    for (auto &inter : type.implements)
+        add_type_dependency(schema, inter.name, type.name);
+
+    type.fields_by_symbol.clear();
+    for (auto &cfld : type.fields)
+    {
+        auto &fld = *const_cast<field *>(&cfld);
+        fld.symbol = names.intern(fld.name);
+        type.fields_by_symbol.insert_or_assign(fld.symbol, &fld);
+        add_type_dependency(schema, fld.field_type.name, type.name);
+        for (auto &carg : fld.arguments)
+        {
+            const_cast<input_value &>(carg).symbol = names.intern(carg.name);
+            add_type_dependency(schema, carg.field_type.name, type.name);
+        }
+    }
+}
+
+bool schema_parser_t::compile_types(schema_t &schema, const std::vector<object_type *> &types)
+{
+    std::atomic<object_type *> failed_type = nullptr;
+    bool res = parallel_for(types.size(), options.threads, [&schema, &types, &failed_type](index_t i)
+                            {
+                                if (resolve_type_references(schema, *types[i]))
+                                    return true;
+                                object_type *expected = nullptr;
+                                failed_type.compare_exchange_strong(expected, types[i]);
+                                return false; }, options.grain_size);
+    if (!res)
+        return report_error("Failed to resolve references of type '{}'", failed_type.load()->name);
+
+    for (object_type *type : types)
+        index_type(schema, *type);
+    name_table::global().freeze();
+    return true;
+}
+
+void schema_parser_t::resolve_root_types(schema_t &schema)
+{
+    if (schema.base && schema.query_type_name.empty())
+        schema.query_type_name = schema.base->query_type_name;
+    if (schema.base && schema.mutation_type_name.empty())
+        schema.mutation_type_name = schema.base->mutation_type_name;
+    schema.query_type = schema.find_type(schema.query_type_name);
+    schema.mutation_type = schema.find_type(schema.mutation_type_name);
+}
+
 bool schema_parser_t::compile(schema_t &schema)
 {
     if (!resolve_directives(schema, schema))
         return false;
 
+    schema.type_dependents.clear();
+    schema.types_by_symbol.clear();
+    std::vector<object_type *> types;
+    types.reserve(schema.types.size());
     for (auto &type_const : schema.types)
     {
         // objects are hashed by name, so changing everything but name sould be kind of OK
-        auto& type = *const_cast<object_type*>(&type_const);
+        types.push_back(const_cast<object_type*>(&type_const));
+    }
 
-        if (!resolve_directives(schema, type))
-            return false;
+    if (!compile_types(schema, types))
+        return false;
 
-        for (auto &cf : type.fields)
-        {
-            auto& fld = *const_cast<field*>(&cf);
-            resolve_field(schema, type, fld);
-        }
+    resolve_root_types(schema);
+    schema.version = next_schema_version();
+
+    changed_types.clear();
+    directive_types_changed = false;
+    return true;
+}
+
+bool schema_parser_t::compile_changed(schema_t &schema)
+{
+    // new directive types may be referenced from any type
+    if (directive_types_changed)
+        return compile(schema);
+
+    if (!resolve_directives(schema, schema))
+        return false;
+
+    // extended types are reinserted into collection, so every type referencing them has to be resolved again
+    std::unordered_set<std::string> to_compile = changed_types;
+    for (const auto &type_name : changed_types)
+    {
+        auto deps = schema.type_dependents.find(type_name);
+        if (deps != schema.type_dependents.end())
+            to_compile.insert(deps->second.begin(), deps->second.end());
+    }
+
+    std::vector<object_type *> types;
+    types.reserve(to_compile.size());
+    for (const auto &type_name : to_compile)
+    {
+        auto type = schema.types.find(type_name);
+        if (type != schema.types.end())
+            types.push_back(const_cast<object_type *>(&*type));
+    }
+
+    if (!compile_types(schema, types))
+        return false;
+
+    resolve_root_types(schema);
+    schema.version = next_schema_version();
+
+    changed_types.clear();
+    return true;
+}
+
+bool schema_parser_t::extend(schema_t &schema, std::string_view extension_string)
+{
+    document_t doc{std::string(extension_string)};
+    parser_t parser{doc};
+    if (!parser.parse())
+    {
+        return report_error("syntax error: {}", parser.get_error_msg());
     }
+    if (!process_doc(schema, doc))
+    {
+        return false;
+    }
+    return compile_changed(schema);
+}
 
-    auto query_type = schema.types.find(schema.query_type_name);
-    if (query_type != schema.types.end())
-        schema.query_type = &*query_type;
+void schema_parser_t::mark_changed(const syntax_node &definition)
+{
+    switch (definition.type)
+    {
+    case syntax_node_type::SchemaDefinition:
+    case syntax_node_type::SchemaExtension:
+        break;
+    case syntax_node_type::DirectiveDefinition:
+        directive_types_changed = true;
+        break;
+    default:
+        changed_types.emplace(definition.name);
+        break;
+    }
+}
 
-    auto mutation_type = schema.types.find(schema.mutation_type_name);
-    if (mutation_type != schema.types.end())
-        schema.mutation_type = &*mutation_type;
-    
+bool schema_parser_t::copy_from_base(schema_t &schema, std::string_view type_name)
+{
+    const object_type *type = schema.base->find_type(type_name);
+    if (!type)
+        return false;
+    schema.types.insert(*type);
+    changed_types.emplace(type_name);
     return true;
 }
 
+// Types of base schema are shared until they are changed. Extended type is copied into the schema,
+// and so are base types referencing it directly, their fields and table mappings are resolved to
+// the new version. Other shared types are followed to the new version by schema_t::current_type.
+void schema_parser_t::copy_on_write(schema_t &schema, const syntax_node &definition)
+{
+    if (!schema.base || schema.types.contains(definition.name) || !schema.base->find_type(definition.name))
+        return;
+
+    switch (definition.type)
+    {
+    case syntax_node_type::InputObjectTypeExtension:
+    case syntax_node_type::EnumTypeExtension:
+    case syntax_node_type::UnionTypeExtension:
+    case syntax_node_type::ObjectTypeExtension:
+    case syntax_node_type::ScalarTypeExtension:
+    case syntax_node_type::InterfaceTypeExtension:
+        copy_from_base(schema, definition.name);
+        break;
+    default:
+        break;
+    }
+
+    for (const schema_t *layer = schema.base.get(); layer; layer = layer->base.get())
+    {
+        auto deps = layer->type_dependents.find(definition.name);
+        if (deps == layer->type_dependents.end())
+            continue;
+        for (const std::string &dependent : deps->second)
+        {
+            if (!schema.types.contains(dependent))
+                copy_from_base(schema, dependent);
+        }
+    }
+}
+
 bool schema_parser_t::process_doc(schema_t &schema, const document_t &doc)
 {
+    values_arena = &schema.values;
     for (const syntax_node *definition : doc.children)
     {
         bool result = false;
+        if (definition->type != syntax_node_type::SchemaDefinition && definition->type != syntax_node_type::SchemaExtension &&
+            definition->type != syntax_node_type::DirectiveDefinition)
+            copy_on_write(schema, *definition);
+
         switch (definition->type)
         {
         case syntax_node_type::SchemaDefinition:
@@ -181,6 +392,7 @@ bool schema_parser_t::process_doc(schema_t &schema, const document_t &doc)
         }
         if (!result)
             return false;
+        mark_changed(*definition);
     }
     return true;
 }
@@ -285,6 +497,7 @@ bool schema_parser_t::process_enum_value(object_type &enum_type, const syntax_no
     }
 
     field field{enum_field_node.name, enum_field_node.description};
+    field.index = enum_type.fields.size();
 
     if (!process_directives(field, enum_field_node))
         return false;
@@ -313,62 +526,83 @@ bool schema_parser_t::process_enum_type_def(schema_t &schema, const syntax_node
     return true;
 }
 
-bool schema_parser_t::process_parameter_value(parameter_value &param, const syntax_node &value_node)
+bool schema_parser_t::process_parameter_value(value_t &value, const syntax_node &value_node)
 {
     switch (value_node.type)
     {
     case syntax_node_type::BoolValue:
-        param.value_type = value_kind::Boolean;
-        param.bool_value = value_node.boolValue;
+        value.value_type = value_kind::Boolean;
+        value.bool_value = value_node.boolValue;
         return true;
     case syntax_node_type::IntValue:
-        param.value_type = value_kind::Integer;
-        param.int_value = value_node.intValue;
+        value.value_type = value_kind::Integer;
+        value.int_value = value_node.intValue;
         return true;
     case syntax_node_type::StringValue:
-        param.value_type = value_kind::String;
-        param.string_value = value_node.content;
-        return true;
     case syntax_node_type::EnumValue:
-        param.value_type = value_kind::Enum;
-        param.string_value = value_node.content;
+    {
+        std::string_view str = values_arena->store(value_node.content);
+        value.value_type = value_node.type == syntax_node_type::StringValue ? value_kind::String : value_kind::Enum;
+        value.string_data = str.data();
+        value.size = uint32_t(str.size());
         return true;
+    }
     case syntax_node_type::NullValue:
-        param.value_type = value_kind::Null;
-        param.string_value = value_node.content;
+        value.value_type = value_kind::Null;
         return true;
     case syntax_node_type::FloatValue:
-        param.value_type = value_kind::Float;
-        param.float_value = value_node.floatValue;
+        value.value_type = value_kind::Float;
+        value.float_value = value_node.floatValue;
         return true;
     case syntax_node_type::ListValue:
-        param.value_type = value_kind::List;
-        return process_params(param.fields, value_node);
     case syntax_node_type::ObjectValue:
-        param.value_type = value_kind::Object;
-        return process_params(param.fields, value_node);
+    {
+        parameter_list fields;
+        if (!process_params(fields, value_node))
+            return false;
+        value.value_type = value_node.type == syntax_node_type::ListValue ? value_kind::List : value_kind::Object;
+        value.fields_data = fields.begin();
+        value.size = uint32_t(fields.size());
+        return true;
+    }
     default:
         return report_error("value expected at {}", value_node.pos);
     }
     return false;
 }
 
-bool schema_parser_t::process_params(named_collection<parameter_value> &arguments, const syntax_node &node)
+bool schema_parser_t::process_params(parameter_list &arguments, const syntax_node &node)
 {
+    if (!values_arena)
+        return report_error("values storage is not set");
+
+    index_t count = node.children.size();
+    parameter_value *params = values_arena->allocate_array<parameter_value>(count);
+    parameter_list processed{params, 0};
+
     for (const syntax_node *child_node : node.children)
     {
-        parameter_value param{child_node->name, child_node->description};
+        parameter_value &param = params[processed.size()];
 
-        if (child_node->children.size() < 1)
-            return false;
-        syntax_node *value_node = child_node->children[0];
+        // list items are values itself, other nodes are named arguments or object fields
+        const syntax_node *value_node = child_node;
+        if (node.type != syntax_node_type::ListValue)
+        {
+            if (child_node->children.size() < 1)
+                return false;
+            value_node = child_node->children[0];
 
-        if (!process_parameter_value(param, *value_node))
+            if (processed.contains(child_node->name))
+                return report_error(*child_node, "parameter with name '{}' already defined", child_node->name);
+            param.name = values_arena->store(child_node->name);
+        }
+
+        if (!process_parameter_value(param.value, *value_node))
             return false;
 
-        if (!arguments.insert(param).second)
-            return report_error(*child_node, "parameter with name '{}' already defined", child_node->name);
+        processed = parameter_list{params, processed.size() + 1};
     }
+    arguments = processed;
     return true;
 }
 
@@ -410,7 +644,7 @@ bool schema_parser_t::process_arguments(named_collection<input_value> &arguments
         value.index = arguments.size();
 
         if (!process_input_value(value, *child_node))
-            return true;
+            return false;
 
         if (!arguments.insert(std::move(value)).second)
             return report_error(*child_node, "argument with name {} already specified", child_node->name);
@@ -447,8 +681,8 @@ bool schema_parser_t::process_input_value(input_value &value, const syntax_node
 {
     if (!process_filed_type(value, node))
         return false;
-    // handle default value
-    if (node.children.size() > 1u)
+    // handle default value, directives follow it
+    if (node.children.size() > node.directives.size() + 1u)
     {
         const syntax_node *default_value_node = node.children[1];
         if (!process_parameter_value(value.default_value, *default_value_node))
@@ -513,7 +747,7 @@ bool schema_parser_t::process_input_type_def(schema_t &schema, const syntax_node
 
 bool schema_parser_t::process_input_ext(schema_t &schema, const syntax_node &definition)
 {
-    auto res = schema.types.find(definition.name);
+    auto res = schema.types.find(hashed_name{definition.name, definition.name_hash_code});
     if (res == schema.types.end())
         return report_error(definition, "Type {} is not defined", definition.name);
     if (res->kind != type_kind::InputObject)
@@ -538,7 +772,7 @@ bool schema_parser_t::process_input_ext(schema_t &schema, const syntax_node &def
 
 bool schema_parser_t::process_scalar_ext(schema_t &schema, const syntax_node &definition)
 {
-    auto res = schema.types.find(definition.name);
+    auto res = schema.types.find(hashed_name{definition.name, definition.name_hash_code});
     if (res == schema.types.end())
         return report_error(definition, "Type {} is not defined", definition.name);
     if (res->kind != type_kind::Scalar)
@@ -557,7 +791,7 @@ bool schema_parser_t::process_scalar_ext(schema_t &schema, const syntax_node &de
 
 bool schema_parser_t::process_enum_ext(schema_t &schema, const syntax_node &definition)
 {
-    auto res = schema.types.find(definition.name);
+    auto res = schema.types.find(hashed_name{definition.name, definition.name_hash_code});
     if (res == schema.types.end())
         return report_error(definition, "Type {} is not defined", definition.name);
     if (res->kind != type_kind::Enum)
@@ -581,7 +815,7 @@ bool schema_parser_t::process_enum_ext(schema_t &schema, const syntax_node &defi
 
 bool schema_parser_t::process_union_ext(schema_t &schema, const syntax_node &definition)
 {
-    auto res = schema.types.find(definition.name);
+    auto res = schema.types.find(hashed_name{definition.name, definition.name_hash_code});
     if (res == schema.types.end())
         return report_error(definition, "Type {} is not defined", definition.name);
     if (res->kind != type_kind::Union)
@@ -606,7 +840,7 @@ bool schema_parser_t::process_union_ext(schema_t &schema, const syntax_node &def
 
 bool schema_parser_t::process_output_ext(schema_t &schema, const syntax_node &definition, type_kind kind)
 {
-    auto res = schema.types.find(definition.name);
+    auto res = schema.types.find(hashed_name{definition.name, definition.name_hash_code});
     if (res == schema.types.end())
         return report_error(definition, "Type {} is not defined", definition.name);
     if (res->kind != kind)
@@ -0,0 +1,63 @@
+#include <type_system/schema_registry.hpp>
+#include <type_system/schema_parser.hpp>
+#include <type_system/builtin_types.hpp>
+#include <mutex>
+
+namespace blitz_query_cpp
+{
+    bool schema_registry::add(std::string_view name, std::shared_ptr<const schema_t> base, std::string_view schema_string)
+    {
+        auto schema = std::make_shared<schema_t>();
+        schema->base = std::move(base);
+
+        schema_parser_t parser;
+        bool res = schema_string.empty() ? parser.compile(*schema) : parser.parse(*schema, schema_string);
+
+        std::unique_lock lock{mutex};
+        if (!res)
+            return report_error("Failed to build schema '{}': {}", name, parser.get_error_msg());
+        schemas.insert_or_assign(std::string(name), std::move(schema));
+        return true;
+    }
+
+    bool schema_registry::add_schema(std::string_view name, std::string_view schema_string)
+    {
+        return add(name, builtin_schema(), schema_string);
+    }
+
+    bool schema_registry::add_schema(std::string_view name, std::string_view base_name, std::string_view schema_string)
+    {
+        std::shared_ptr<const schema_t> base = find(base_name);
+        if (!base)
+        {
+            std::unique_lock lock{mutex};
+            return report_error("Base schema '{}' is not registered", base_name);
+        }
+        return add(name, std::move(base), schema_string);
+    }
+
+    bool schema_registry::remove_schema(std::string_view name)
+    {
+        std::unique_lock lock{mutex};
+        auto schema = schemas.find(name);
+        if (schema == schemas.end())
+            return false;
+        schemas.erase(schema);
+        return true;
+    }
+
+    std::shared_ptr<const schema_t> schema_registry::find(std::string_view name) const
+    {
+        std::shared_lock lock{mutex};
+        auto schema = schemas.find(name);
+        if (schema == schemas.end())
+            return nullptr;
+        return schema->second;
+    }
+
+    size_t schema_registry::size() const
+    {
+        std::shared_lock lock{mutex};
+        return schemas.size();
+    }
+}
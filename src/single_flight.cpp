@@ -0,0 +1,84 @@
+#include <processing/single_flight.hpp>
+#include <algorithm>
+
+namespace blitz_query_cpp
+{
+    static std::size_t hash_values(const std::vector<std::string_view> &values)
+    {
+        std::size_t res = values.size();
+        for (std::string_view value : values)
+            res = res * 0x9E3779B97F4A7C15ull + std::hash<std::string_view>{}(value);
+        return res;
+    }
+
+    bool single_flight::execute(query_context &context, shared_rows &rows)
+    {
+        const compiled_plan *plan = context.get_plan();
+        if (!plan)
+            return context.report_error("Request has no compiled plan");
+        // every mutation should take effect
+        if (!plan->mutations.empty())
+            return context.report_error("Mutation is not deduplicated, it runs by execute_mutation");
+        flight_key key{plan, hash_values(context.parameter_values)};
+
+        std::unique_lock lock{mutex};
+        auto current = flights.find(key);
+        if (current != flights.end() && std::ranges::equal(*current->second->parameter_values, context.parameter_values))
+        {
+            std::shared_ptr<flight> pending = current->second;
+            deduplicated_count++;
+            pending->done_cv.wait(lock, [&pending]
+                                  { return pending->done; });
+            if (pending->error)
+                std::rethrow_exception(pending->error);
+            if (!pending->rows)
+                return context.report_error("Failed to execute statement");
+            rows = pending->rows;
+            return true;
+        }
+
+        // requests with colliding hash are not deduplicated
+        std::shared_ptr<flight> own;
+        if (current == flights.end())
+        {
+            own = std::make_shared<flight>();
+            own->parameter_values = &context.parameter_values;
+            flights.emplace(key, own);
+        }
+        lock.unlock();
+
+        executed_count++;
+        std::vector<std::string> parameters(context.parameter_values.begin(), context.parameter_values.end());
+        auto result = std::make_shared<std::vector<result_row>>();
+        shared_rows res;
+        std::exception_ptr error;
+        // flight is completed and erased whatever happens, waiting requests would hang otherwise
+        try
+        {
+            if (executor(plan->sql, parameters, *result))
+                res = std::move(result);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        if (own)
+        {
+            lock.lock();
+            own->rows = res;
+            own->error = error;
+            own->done = true;
+            // parameter values of this request are not valid after return
+            flights.erase(key);
+            own->done_cv.notify_all();
+            lock.unlock();
+        }
+        if (error)
+            std::rethrow_exception(error);
+        if (!res)
+            return context.report_error("Failed to execute statement");
+        rows = std::move(res);
+        return true;
+    }
+}
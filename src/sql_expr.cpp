@@ -4,36 +4,118 @@
 
 namespace blitz_query_cpp::sql
 {
-    sql_expr_t &sql_expr_t::add_child(sql_expr_type t, std::string_view val)
+    static thread_local arena_t default_arena;
+    static thread_local arena_t *scope_arena = nullptr;
+
+    arena_scope::arena_scope(arena_t &arena)
+        : previous{scope_arena}
+    {
+        scope_arena = &arena;
+    }
+
+    arena_scope::~arena_scope()
+    {
+        scope_arena = previous;
+    }
+
+    arena_t &current_arena()
     {
-        return children.emplace_back(t, val);
+        return scope_arena ? *scope_arena : default_arena;
     }
 
-    sql_expr_t &create_or_get_child_with_type(sql_expr_t &node, sql_expr_type type, std::string_view val = {})
+    void reset_default_arena()
     {
-        auto res = std::find_if(node.children.rbegin(), node.children.rend(), [type](auto &v)
-                                { return v.type <= type; });
+        default_arena.reset();
+    }
 
-        if (res == node.children.rend() || res->type != type)
+    void sql_node::add_child(sql_node *child, arena_t &arena)
+    {
+        if (children_count == children_capacity)
         {
-            return *node.children.emplace(res.base(), type, val);
+            uint32_t new_capacity = children_capacity ? children_capacity * 2 : 4;
+            sql_node **new_children = arena.allocate_array<sql_node *>(new_capacity);
+            std::copy_n(children, children_count, new_children);
+            children = new_children;
+            children_capacity = new_capacity;
         }
+        children[children_count++] = child;
+    }
 
-        return *res;
+    static sql_node *create_node(arena_t &arena, sql_expr_type t, sql_str val)
+    {
+        sql_node *node = arena.create<sql_node>();
+        node->type = t;
+        node->value = val.is_static ? val.value : arena.store(val.value);
+        return node;
+    }
+
+    sql_expr_t::sql_expr_t(sql_expr_type t, sql_str val)
+        : node{create_node(current_arena(), t, val)}
+    {
+    }
+
+    sql_expr_t::sql_expr_t(sql_expr_type t, sql_str val, sql_expr_t child)
+        : sql_expr_t(t, val)
+    {
+        add_child(child);
+    }
+
+    sql_expr_t sql_expr_t::add_child(sql_expr_type t, sql_str val)
+    {
+        sql_expr_t child{t, val};
+        add_child(child);
+        return child;
+    }
+
+    void sql_expr_t::add_child(sql_expr_t child)
+    {
+        node->add_child(child.node, current_arena());
     }
 
-    sql_expr_t &create_child_with_type(sql_expr_t &node, sql_expr_type type, std::string_view val = {})
+    static sql_expr_type clause_type(select_clause c)
     {
-        auto res = std::find_if(node.children.rbegin(), node.children.rend(), [type](auto &v)
-                                { return v.type <= type; });
+        switch (c)
+        {
+        case select_clause::Columns:
+            return sql_expr_type::SelectColumns;
+        case select_clause::From:
+            return sql_expr_type::From;
+        case select_clause::Where:
+            return sql_expr_type::Where;
+        case select_clause::Group:
+            return sql_expr_type::Group;
+        case select_clause::Having:
+            return sql_expr_type::Having;
+        case select_clause::Order:
+            return sql_expr_type::Order;
+        case select_clause::Offset:
+            return sql_expr_type::Offset;
+        case select_clause::Limit:
+            return sql_expr_type::Limit;
+        default:
+            // joins slot is a plain list of join nodes
+            return sql_expr_type::None;
+        }
+    }
 
-        return *node.children.emplace(res.base(), type, val);
+    sql_expr_t sql_expr_t::clause(select_clause c)
+    {
+        arena_t &arena = current_arena();
+        if (!node->clauses)
+        {
+            node->clauses = arena.allocate_array<sql_node *>(int(select_clause::Count));
+            std::fill_n(node->clauses, int(select_clause::Count), nullptr);
+        }
+        sql_node *&slot = node->clauses[int(c)];
+        if (!slot)
+            slot = create_node(arena, clause_type(c), {});
+        return sql_expr_t{slot};
     }
 
     sql_expr_t select(std::span<const std::string_view> columns)
     {
         sql_expr_t res{sql_expr_type::Select};
-        auto &selection = res.add_child(sql_expr_type::SelectColumns);
+        auto selection = res.clause(select_clause::Columns);
         for (auto col : columns)
         {
             selection.add_child(sql_expr_type::Column, col);
@@ -43,94 +125,117 @@ namespace blitz_query_cpp::sql
 
     sql_expr_t &operator|(sql_expr_t &expr, from_expr_t &&from_expr)
     {
-        auto &res = create_or_get_child_with_type(expr, sql_expr_type::From);
-        res.children.emplace_back(std::move(from_expr.expr));
+        expr.clause(select_clause::From).add_child(from_expr.expr);
         return expr;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, where_expr_t &&cond)
     {
-        sql_expr_t &where_node = create_or_get_child_with_type(expr, sql_expr_type::Where);
-        where_node.children.emplace_back(std::move(cond.expr));
+        expr.clause(select_clause::Where).add_child(cond.expr);
         return expr;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, or_expr_t &&cond)
     {
-        sql_expr_t &where_node = create_or_get_child_with_type(expr, sql_expr_type::Where);
-        sql_expr_t *op_parent_node = &where_node;
+        sql_expr_t where_node = expr.clause(select_clause::Where);
+        sql_expr_t op_parent_node = where_node;
 
-        if (where_node.children.size() > 0)
+        if (where_node.node->children_count > 0)
         {
             sql_expr_t or_op{sql_expr_type::Or};
-            if (where_node.children.size() > 1)
-            {
-                auto &and_node = or_op.add_child(sql_expr_type::And);
-                and_node.children = std::move(where_node.children);
-            }
-            else
-            {
-                or_op.children = std::move(where_node.children);
-            }
-            op_parent_node = &where_node.children.emplace_back(std::move(or_op));
+            sql_node *conditions = or_op.node;
+            if (where_node.node->children_count > 1)
+                conditions = or_op.add_child(sql_expr_type::And).node;
+            // existing conditions are moved under OR
+            std::swap(conditions->children, where_node.node->children);
+            std::swap(conditions->children_count, where_node.node->children_count);
+            std::swap(conditions->children_capacity, where_node.node->children_capacity);
+            where_node.add_child(or_op);
+            op_parent_node = or_op;
         }
 
-        op_parent_node->children.emplace_back(std::move(cond.expr));
+        op_parent_node.add_child(cond.expr);
         return expr;
     }
 
-    sql_expr_t binary_operation(binary_op op, sql_expr_t &&a, sql_expr_t &&b)
+    sql_expr_t binary_operation(sql_expr_t a, binary_op op, sql_expr_t b)
     {
         sql_expr_t res{get_expr_type(op)};
-        res.children.emplace_back(std::move(a));
-        res.children.emplace_back(std::move(b));
+        res.add_child(a);
+        res.add_child(b);
         return res;
     }
 
-    sql_expr_t binary_operation(binary_op op, const sql_expr_t &a, const sql_expr_t &b)
+    sql_expr_t function(sql_str name, std::initializer_list<sql_expr_t> args)
     {
-        sql_expr_t res{get_expr_type(op)};
-        res.children.emplace_back(a);
-        res.children.emplace_back(b);
+        sql_expr_t res{sql_expr_type::Function, name};
+        for (sql_expr_t arg : args)
+            res.add_child(arg);
+        return res;
+    }
+
+    sql_expr_t json_object(std::initializer_list<sql_expr_t> fields)
+    {
+        sql_expr_t res{sql_expr_type::JsonObject};
+        for (sql_expr_t fld : fields)
+            res.add_child(fld);
         return res;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, order_by_t &&param)
     {
-        sql_expr_t &order_node = create_or_get_child_with_type(expr, sql_expr_type::Order);
-        order_node.children.emplace_back(param.ascending ? sql_expr_type::Asc : sql_expr_type::Desc, "", std::move(param.column));
+        expr.clause(select_clause::Order).add_child({param.ascending ? sql_expr_type::Asc : sql_expr_type::Desc, {}, param.column});
         return expr;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, limit_t param)
     {
-        sql_expr_t &node = create_or_get_child_with_type(expr, sql_expr_type::Limit);
-        node.value = std::to_string(param.value);
+        expr.clause(select_clause::Limit).node->value = current_arena().store(std::to_string(param.value));
         return expr;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, offset_t param)
     {
-        sql_expr_t &node = create_or_get_child_with_type(expr, sql_expr_type::Offset);
-        node.value = std::to_string(param.value);
+        expr.clause(select_clause::Offset).node->value = current_arena().store(std::to_string(param.value));
+        return expr;
+    }
+
+    sql_expr_t &operator|(sql_expr_t &expr, limit_expr_t &&param)
+    {
+        expr.clause(select_clause::Limit).add_child(param.expr);
+        return expr;
+    }
+
+    sql_expr_t &operator|(sql_expr_t &expr, offset_expr_t &&param)
+    {
+        expr.clause(select_clause::Offset).add_child(param.expr);
         return expr;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, join_t &&param)
     {
-        sql_expr_t &join_node = create_child_with_type(expr, get_expr_type(param.kind));
-        join_node.children.emplace_back(std::move(param.expr));
-        sql_expr_t &on_node = join_node.add_child(sql_expr_type::On);
-        on_node.children.emplace_back(std::move(param.column1));
-        on_node.children.emplace_back(std::move(param.column2));
+        sql_expr_t join_node{get_expr_type(param.kind), {}, param.expr};
+        join_node.node->to_one = param.to_one;
+        sql_expr_t on_node = join_node.add_child(sql_expr_type::On);
+        on_node.add_child(param.column1);
+        on_node.add_child(param.column2);
+        expr.clause(select_clause::Joins).add_child(join_node);
+        return expr;
+    }
+
+    sql_expr_t &operator|(sql_expr_t &expr, lateral_join_t &&param)
+    {
+        sql_expr_t join_node{sql_expr_type::LeftJoinLateral, {}, param.expr};
+        join_node.node->to_one = param.to_one;
+        join_node.add_child(sql_expr_type::On).add_child(sql_expr_type::BoolLiteral, static_str{"TRUE"});
+        expr.clause(select_clause::Joins).add_child(join_node);
         return expr;
     }
 
     sql_expr_t &operator|(sql_expr_t &expr, column_t &&param)
     {
-        auto &columns = create_or_get_child_with_type(expr, sql_expr_type::SelectColumns);
-        columns.children.emplace_back(std::move(param.expr));
+        expr.clause(select_clause::Columns).add_child(param.expr);
         return expr;
     }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,154 @@
+#include <data/sql/sql_mapping.hpp>
+#include <type_system/type_system_classes.hpp>
+#include <algorithm>
+
+namespace blitz_query_cpp::sql
+{
+    bool pg_need_to_quote(std::string_view identifier)
+    {
+        return !std::all_of(identifier.begin(), identifier.end(), [](char c)
+                            { return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_'; });
+    }
+
+    std::string pg_quote_identifier(std::string_view identifier)
+    {
+        if (!pg_need_to_quote(identifier))
+            return std::string(identifier);
+        std::string res;
+        res.reserve(identifier.size() + 2);
+        res += '"';
+        res += identifier;
+        res += '"';
+        return res;
+    }
+
+    std::string_view pg_scalar_type(std::string_view graphql_type)
+    {
+        static constexpr std::pair<std::string_view, std::string_view> types[] = {
+            {"Int", "integer"}, {"Long", "bigint"}, {"Float", "double precision"}, {"Decimal", "numeric"},
+            {"Boolean", "boolean"}, {"UUID", "uuid"}, {"DateTime", "timestamptz"}, {"String", "text"}};
+        for (auto [name, sql_type] : types)
+        {
+            if (name == graphql_type)
+                return sql_type;
+        }
+        return {};
+    }
+
+    std::string_view pg_type_of(std::string_view graphql_type)
+    {
+        std::string_view res = pg_scalar_type(graphql_type);
+        return res.empty() ? "text" : res;
+    }
+
+    const column_mapping &table_mapping::column(const field &field_decl) const
+    {
+        return columns[field_decl.index];
+    }
+
+    static std::string_view string_param(const directive &dir, std::string_view name)
+    {
+        auto param = dir.parameters.find(name);
+        if (param == dir.parameters.end())
+            return {};
+        return param->value.string_value();
+    }
+
+    // list of strings or single string
+    static std::vector<std::string> string_list_param(const directive &dir, std::string_view name)
+    {
+        std::vector<std::string> res;
+        auto param = dir.parameters.find(name);
+        if (param == dir.parameters.end())
+            return res;
+        if (param->value.value_type != value_kind::List)
+        {
+            res.emplace_back(param->value.string_value());
+            return res;
+        }
+        for (const parameter_value &item : param->value.fields())
+            res.emplace_back(item.value.string_value());
+        return res;
+    }
+
+    // schemas use both true and True enum value for flags
+    static bool is_true(const value_t &value)
+    {
+        if (value.value_type == value_kind::Boolean)
+            return value.bool_value;
+        return value.value_type == value_kind::Enum && value.string_value() == "True";
+    }
+
+    // parameter value or default value of directive argument
+    static bool bool_param(const directive &dir, std::string_view name)
+    {
+        auto param = dir.parameters.find(name);
+        if (param != dir.parameters.end())
+            return is_true(param->value);
+        if (dir.directive_type)
+        {
+            auto arg = dir.directive_type->arguments.find(name);
+            if (arg != dir.directive_type->arguments.end())
+                return is_true(arg->default_value);
+        }
+        return false;
+    }
+
+    bool build_table_mapping(const object_type &type, table_mapping &mapping)
+    {
+        const directive *table_dir = type.find_directive(TableDirective);
+        if (!table_dir)
+            return false;
+
+        mapping.table_name = string_param(*table_dir, "table");
+        mapping.schema_name = string_param(*table_dir, "schema");
+        if (mapping.schema_name.empty())
+            mapping.schema_name = DefaultSchema;
+        mapping.schema_identifier = pg_quote_identifier(mapping.schema_name);
+        mapping.table_identifier = pg_quote_identifier(mapping.table_name);
+
+        mapping.columns.assign(type.fields.size(), column_mapping{});
+        mapping.primary_key.clear();
+        mapping.always_projected.clear();
+        mapping.primary_key_mask = {};
+        mapping.always_projected_mask = {};
+        for (const field &fld : type.fields)
+        {
+            if (fld.index < 0 || index_t(fld.index) >= mapping.columns.size())
+                continue;
+            column_mapping &column = mapping.columns[fld.index];
+            column.field_decl = &fld;
+            column.name = fld.name;
+            if (const directive *column_dir = fld.find_directive(ColumnDirective))
+            {
+                std::string_view name = string_param(*column_dir, "name");
+                if (!name.empty())
+                    column.name = name;
+                column.is_primary_key = bool_param(*column_dir, "IsPK");
+            }
+            column.identifier = pg_quote_identifier(column.name);
+            if (const directive *relation_dir = fld.find_directive(RelationDirective))
+            {
+                column.relation_fields = string_list_param(*relation_dir, "fields");
+                column.relation_references = string_list_param(*relation_dir, "references");
+            }
+
+            if (column.is_primary_key)
+                mapping.primary_key.push_back(fld.index);
+            const directive *projected_dir = fld.find_directive(AlwaysProjectedDirective);
+            if (projected_dir && (!projected_dir->parameters.contains("projected") || bool_param(*projected_dir, "projected")))
+                mapping.always_projected.push_back(fld.index);
+        }
+        std::sort(mapping.primary_key.begin(), mapping.primary_key.end());
+        std::sort(mapping.always_projected.begin(), mapping.always_projected.end());
+
+        if (type.has_field_mask())
+        {
+            for (index_t field_index : mapping.primary_key)
+                mapping.primary_key_mask.set(field_index);
+            for (index_t field_index : mapping.always_projected)
+                mapping.always_projected_mask.set(field_index);
+        }
+        return true;
+    }
+}
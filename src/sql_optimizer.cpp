@@ -0,0 +1,537 @@
+#include "data/sql/sql_optimizer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <vector>
+
+namespace blitz_query_cpp::sql
+{
+    static constexpr std::string_view TrueValue = "TRUE";
+    static constexpr std::string_view FalseValue = "FALSE";
+
+    static bool is_select(const sql_node *node)
+    {
+        return node->type == sql_expr_type::Select || node->type == sql_expr_type::SelectDistinct;
+    }
+
+    static sql_node *bool_node(bool value)
+    {
+        return sql_expr_t{sql_expr_type::BoolLiteral, static_str{value ? TrueValue : FalseValue}}.node;
+    }
+
+    static bool is_bool(const sql_node *node, bool value)
+    {
+        return node->type == sql_expr_type::BoolLiteral && node->value == (value ? TrueValue : FalseValue);
+    }
+
+    // identifiers quoted at schema compile are compared with names used in the query
+    static std::string_view unquote(std::string_view name)
+    {
+        if (name.size() >= 2 && name.front() == '"' && name.back() == '"')
+            return name.substr(1, name.size() - 2);
+        return name;
+    }
+
+    static bool same_expr(const sql_node *a, const sql_node *b)
+    {
+        if (a == b)
+            return true;
+        if (a->type != b->type || a->value != b->value || a->children_count != b->children_count || a->clauses || b->clauses)
+            return false;
+        for (uint32_t i = 0; i < a->children_count; i++)
+        {
+            if (!same_expr(a->children[i], b->children[i]))
+                return false;
+        }
+        return true;
+    }
+
+    static void set_children(sql_node *node, const std::vector<sql_node *> &children)
+    {
+        sql_node **res = current_arena().allocate_array<sql_node *>(children.size());
+        std::copy(children.begin(), children.end(), res);
+        node->children = res;
+        node->children_count = node->children_capacity = uint32_t(children.size());
+    }
+
+    static sql_node *copy_node(const sql_node *node)
+    {
+        return current_arena().create<sql_node>(*node);
+    }
+
+    // column reference like schema.table.column, table.column or column
+    static const sql_node *referenced_column(const sql_node *node)
+    {
+        while ((node->type == sql_expr_type::SchemaName || node->type == sql_expr_type::TableName) && node->children_count == 1)
+            node = node->children[0];
+        return node->type == sql_expr_type::Column ? node : nullptr;
+    }
+
+    struct output_column
+    {
+        std::string_view name;
+        sql_node *value = nullptr;
+    };
+
+    static output_column output_of(sql_node *column)
+    {
+        if (column->type == sql_expr_type::Asias)
+            return {unquote(column->value), column->children_count == 1 ? column->children[0] : nullptr};
+        if (const sql_node *ref = referenced_column(column))
+            return {unquote(ref->value), column};
+        return {};
+    }
+
+    //-----------------------------------
+    // columns
+    //-----------------------------------
+
+    // columns of outer SELECT are read by position, only their aliases are simplified
+    static void deduplicate_columns(sql_node *select, bool keep_positions)
+    {
+        sql_node *columns = select->clause(select_clause::Columns);
+        if (!columns)
+            return;
+        std::vector<sql_node *> res;
+        bool changed = false;
+        for (sql_node *column : columns->get_children())
+        {
+            // alias equal to column name
+            if (column->type == sql_expr_type::Asias && column->children_count == 1)
+            {
+                const sql_node *ref = referenced_column(column->children[0]);
+                if (ref && unquote(ref->value) == unquote(column->value))
+                {
+                    column = column->children[0];
+                    changed = true;
+                }
+            }
+            if (!keep_positions && std::any_of(res.begin(), res.end(), [column](const sql_node *prev)
+                                               { return same_expr(prev, column); }))
+            {
+                changed = true;
+                continue;
+            }
+            res.push_back(column);
+        }
+        if (changed)
+            set_children(columns, res);
+    }
+
+    //-----------------------------------
+    // conditions
+    //-----------------------------------
+
+    // WHERE and HAVING lists are joined with AND
+    static void flatten(sql_node *node)
+    {
+        if (is_select(node))
+            return;
+        for (sql_node *child : node->get_children())
+            flatten(child);
+
+        sql_expr_type merged;
+        switch (node->type)
+        {
+        case sql_expr_type::Or:
+            merged = sql_expr_type::Or;
+            break;
+        case sql_expr_type::And:
+        case sql_expr_type::Where:
+        case sql_expr_type::Having:
+            merged = sql_expr_type::And;
+            break;
+        default:
+            return;
+        }
+        auto children = node->get_children();
+        if (std::none_of(children.begin(), children.end(), [merged](const sql_node *child)
+                         { return child->type == merged; }))
+            return;
+        std::vector<sql_node *> res;
+        for (sql_node *child : children)
+        {
+            if (child->type == merged)
+                res.insert(res.end(), child->children, child->children + child->children_count);
+            else
+                res.push_back(child);
+        }
+        set_children(node, res);
+    }
+
+    static std::optional<double> number_value(const sql_node *node)
+    {
+        if (node->type != sql_expr_type::NumberLiteral)
+            return std::nullopt;
+        double value = 0;
+        auto res = std::from_chars(node->value.data(), node->value.data() + node->value.size(), value);
+        if (res.ec != std::errc{} || res.ptr != node->value.data() + node->value.size())
+            return std::nullopt;
+        return value;
+    }
+
+    // result of comparison of two literals, if it is known
+    static std::optional<bool> compare(sql_expr_type op, const sql_node *a, const sql_node *b)
+    {
+        auto x = number_value(a);
+        auto y = number_value(b);
+        if (x && y)
+        {
+            switch (op)
+            {
+            case sql_expr_type::Eq:
+                return *x == *y;
+            case sql_expr_type::Ne:
+                return *x != *y;
+            case sql_expr_type::Le:
+                return *x < *y;
+            case sql_expr_type::Gt:
+                return *x > *y;
+            case sql_expr_type::Lq:
+                return *x <= *y;
+            case sql_expr_type::Gq:
+                return *x >= *y;
+            default:
+                return std::nullopt;
+            }
+        }
+        // string ordering depends on collation
+        bool literals = (a->type == sql_expr_type::StringLiteral || a->type == sql_expr_type::BoolLiteral) && a->type == b->type;
+        if (literals && op == sql_expr_type::Eq)
+            return a->value == b->value;
+        if (literals && op == sql_expr_type::Ne)
+            return a->value != b->value;
+        return std::nullopt;
+    }
+
+    static sql_node *fold(sql_node *node)
+    {
+        if (is_select(node))
+            return node;
+        for (uint32_t i = 0; i < node->children_count; i++)
+            node->children[i] = fold(node->children[i]);
+
+        switch (node->type)
+        {
+        case sql_expr_type::And:
+        case sql_expr_type::Or:
+        {
+            bool is_and = node->type == sql_expr_type::And;
+            std::vector<sql_node *> res;
+            for (sql_node *child : node->get_children())
+            {
+                if (is_bool(child, !is_and))
+                    return bool_node(!is_and);
+                if (!is_bool(child, is_and))
+                    res.push_back(child);
+            }
+            if (res.empty())
+                return bool_node(is_and);
+            if (res.size() == 1)
+                return res[0];
+            if (res.size() != node->children_count)
+                set_children(node, res);
+            return node;
+        }
+        case sql_expr_type::Not:
+            if (node->children_count == 1 && node->children[0]->type == sql_expr_type::BoolLiteral)
+                return bool_node(is_bool(node->children[0], false));
+            return node;
+        case sql_expr_type::Eq:
+        case sql_expr_type::Ne:
+        case sql_expr_type::Le:
+        case sql_expr_type::Gt:
+        case sql_expr_type::Lq:
+        case sql_expr_type::Gq:
+            if (node->children_count == 2)
+            {
+                if (auto res = compare(node->type, node->children[0], node->children[1]))
+                    return bool_node(*res);
+            }
+            return node;
+        default:
+            return node;
+        }
+    }
+
+    static void fold_conditions(sql_node *select, select_clause c)
+    {
+        sql_node *conditions = select->clause(c);
+        if (!conditions)
+            return;
+        std::vector<sql_node *> res;
+        for (sql_node *child : conditions->get_children())
+        {
+            sql_node *folded = fold(child);
+            if (is_bool(folded, false))
+            {
+                res.assign(1, folded);
+                break;
+            }
+            if (!is_bool(folded, true))
+                res.push_back(folded);
+        }
+        if (res.empty())
+            select->clauses[int(c)] = nullptr;
+        else
+            set_children(conditions, res);
+    }
+
+    //-----------------------------------
+    // predicate pushdown
+    //-----------------------------------
+
+    // condition with references to subquery output replaced by column expressions of subquery,
+    // nullptr if condition uses something else
+    static sql_node *substitute(sql_node *node, std::string_view alias, const sql_node *columns)
+    {
+        if (is_select(node) || node->clauses)
+            return nullptr;
+        if (const sql_node *ref = referenced_column(node))
+        {
+            if (node->type == sql_expr_type::SchemaName)
+                return nullptr;
+            if (node->type == sql_expr_type::TableName && (alias.empty() || unquote(node->value) != unquote(alias)))
+                return nullptr;
+            for (sql_node *column : columns->get_children())
+            {
+                output_column output = output_of(column);
+                if (output.name != unquote(ref->value) || !output.value)
+                    continue;
+                // aggregates and other expressions are not moved to WHERE
+                if (!referenced_column(output.value))
+                    return nullptr;
+                return output.value;
+            }
+            return nullptr;
+        }
+        if (node->children_count == 0)
+            return node;
+
+        std::vector<sql_node *> children;
+        bool changed = false;
+        for (sql_node *child : node->get_children())
+        {
+            sql_node *res = substitute(child, alias, columns);
+            if (!res)
+                return nullptr;
+            changed = changed || res != child;
+            children.push_back(res);
+        }
+        if (!changed)
+            return node;
+        sql_node *res = copy_node(node);
+        set_children(res, children);
+        return res;
+    }
+
+    static bool has_window(const sql_node *node)
+    {
+        if (node->type == sql_expr_type::Window)
+            return true;
+        return std::any_of(node->children, node->children + node->children_count, [](const sql_node *child)
+                           { return has_window(child); });
+    }
+
+    static void push_down_predicates(sql_node *select)
+    {
+        sql_node *from = select->clause(select_clause::From);
+        sql_node *where = select->clause(select_clause::Where);
+        if (!from || !where || from->children_count != 1 || select->clause(select_clause::Joins))
+            return;
+        sql_node *source = from->children[0];
+        sql_node *subquery = source;
+        std::string_view alias;
+        if (source->type == sql_expr_type::Asias && source->children_count == 1)
+        {
+            alias = source->value;
+            subquery = source->children[0];
+        }
+        if (subquery->type != sql_expr_type::Select || !subquery->clauses)
+            return;
+        sql_node *columns = subquery->clause(select_clause::Columns);
+        if (!columns || subquery->clause(select_clause::Group) || subquery->clause(select_clause::Having) ||
+            subquery->clause(select_clause::Offset) || subquery->clause(select_clause::Limit))
+            return;
+        // window functions like count(*) OVER () are computed over rows filtered by WHERE
+        if (has_window(columns))
+            return;
+
+        std::vector<sql_node *> kept, pushed;
+        for (sql_node *condition : where->get_children())
+        {
+            if (sql_node *res = substitute(condition, alias, columns))
+                pushed.push_back(res);
+            else
+                kept.push_back(condition);
+        }
+        if (pushed.empty())
+            return;
+
+        // subquery may be shared with other expressions
+        arena_t &arena = current_arena();
+        sql_node *copy = copy_node(subquery);
+        copy->clauses = arena.allocate_array<sql_node *>(int(select_clause::Count));
+        std::copy_n(subquery->clauses, int(select_clause::Count), copy->clauses);
+        sql_node *&copy_where = copy->clauses[int(select_clause::Where)];
+        if (copy_where)
+        {
+            pushed.insert(pushed.begin(), copy_where->children, copy_where->children + copy_where->children_count);
+            copy_where = copy_node(copy_where);
+        }
+        else
+            copy_where = sql_expr_t{sql_expr_type::Where}.node;
+        set_children(copy_where, pushed);
+
+        if (alias.empty())
+            from->children[0] = copy;
+        else
+        {
+            sql_node *copy_alias = copy_node(source);
+            set_children(copy_alias, {copy});
+            from->children[0] = copy_alias;
+        }
+
+        if (kept.empty())
+            select->clauses[int(select_clause::Where)] = nullptr;
+        else
+            set_children(where, kept);
+    }
+
+    //-----------------------------------
+    // join elimination
+    //-----------------------------------
+
+    static std::string_view joined_name(const sql_node *join)
+    {
+        if (join->children_count == 0)
+            return {};
+        const sql_node *target = join->children[0];
+        if (target->type == sql_expr_type::Asias)
+            return unquote(target->value);
+        while (target->type == sql_expr_type::SchemaName && target->children_count == 1)
+            target = target->children[0];
+        return target->type == sql_expr_type::TableName ? unquote(target->value) : std::string_view{};
+    }
+
+    // unqualified is set when column without table is found, it may belong to any table
+    static bool references_table(const sql_node *node, std::string_view table, bool qualified, bool &unqualified)
+    {
+        if (node->type == sql_expr_type::TableName && node->children_count > 0 && unquote(node->value) == table)
+            return true;
+        if (node->type == sql_expr_type::Column && !qualified)
+            unqualified = true;
+        bool is_table = node->type == sql_expr_type::TableName || node->type == sql_expr_type::SchemaName;
+        for (const sql_node *child : node->get_children())
+        {
+            if (references_table(child, table, is_table, unqualified))
+                return true;
+        }
+        if (node->clauses)
+        {
+            for (int c = 0; c < int(select_clause::Count); c++)
+            {
+                if (node->clauses[c] && references_table(node->clauses[c], table, false, unqualified))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    static bool is_used(const sql_node *select, const sql_node *join, std::string_view table)
+    {
+        bool unqualified = false;
+        for (int c = 0; c < int(select_clause::Count); c++)
+        {
+            const sql_node *clause = select->clauses[c];
+            if (!clause)
+                continue;
+            if (c != int(select_clause::Joins))
+            {
+                if (references_table(clause, table, false, unqualified))
+                    return true;
+                continue;
+            }
+            for (const sql_node *other : clause->get_children())
+            {
+                if (other != join && references_table(other, table, false, unqualified))
+                    return true;
+            }
+        }
+        return unqualified;
+    }
+
+    static void eliminate_joins(sql_node *select)
+    {
+        sql_node *joins = select->clause(select_clause::Joins);
+        if (!joins)
+            return;
+        // removed join may be the only user of another one
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (const sql_node *join : joins->get_children())
+            {
+                std::string_view table = joined_name(join);
+                bool left_join = join->type == sql_expr_type::LeftJoin || join->type == sql_expr_type::LeftJoinLateral;
+                if (!left_join || !join->to_one || table.empty() || is_used(select, join, table))
+                    continue;
+                std::vector<sql_node *> rest;
+                std::copy_if(joins->children, joins->children + joins->children_count, std::back_inserter(rest), [join](const sql_node *other)
+                             { return other != join; });
+                set_children(joins, rest);
+                changed = true;
+                break;
+            }
+        }
+        if (joins->children_count == 0)
+            select->clauses[int(select_clause::Joins)] = nullptr;
+    }
+
+    //-----------------------------------
+
+    static void optimize_select(sql_node *select, optimizer_pass passes, bool is_outer)
+    {
+        if (!select->clauses)
+            return;
+        if (has_all_flags(passes, optimizer_pass::DeduplicateColumns))
+            deduplicate_columns(select, is_outer);
+        for (select_clause c : {select_clause::Where, select_clause::Having})
+        {
+            if (has_all_flags(passes, optimizer_pass::FlattenConditions) && select->clause(c))
+                flatten(select->clause(c));
+            if (has_all_flags(passes, optimizer_pass::FoldConstants))
+                fold_conditions(select, c);
+            if (has_all_flags(passes, optimizer_pass::FlattenConditions) && select->clause(c))
+                flatten(select->clause(c));
+        }
+        if (has_all_flags(passes, optimizer_pass::PushDownPredicates))
+            push_down_predicates(select);
+
+        // subqueries in FROM and JOIN, pushed predicates are optimized here too
+        for (select_clause c : {select_clause::From, select_clause::Joins})
+        {
+            sql_node *clause = select->clause(c);
+            if (!clause)
+                continue;
+            for (sql_node *item : clause->get_children())
+            {
+                if (c == select_clause::Joins && item->children_count > 0)
+                    item = item->children[0];
+                if (item->type == sql_expr_type::Asias && item->children_count == 1)
+                    item = item->children[0];
+                if (is_select(item))
+                    optimize_select(item, passes, false);
+            }
+        }
+
+        if (has_all_flags(passes, optimizer_pass::EliminateJoins))
+            eliminate_joins(select);
+    }
+
+    void optimize(sql_expr_t &expr, optimizer_pass passes)
+    {
+        if (expr.node && is_select(expr.node))
+            optimize_select(expr.node, passes, true);
+    }
+}
@@ -0,0 +1,17 @@
+#include <processing/sql_query_optimizer.hpp>
+
+namespace blitz_query_cpp
+{
+    bool sql_query_optimizer::process(query_context &context)
+    {
+        sql::sql_expr_t *expr = std::get_if<sql::sql_expr_t>(&context.result);
+        if (!expr)
+            return true;
+        sql::arena_scope scope{context.arena};
+        if (expr->node)
+            sql::optimize(*expr, passes);
+        for (sql::sql_expr_t &batch_query : context.batch_queries)
+            sql::optimize(batch_query, passes);
+        return true;
+    }
+}
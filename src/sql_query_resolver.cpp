@@ -1,16 +1,37 @@
 #include "processing/sql_query_resolver.hpp"
 #include "data/sql/sql_expr.hpp"
+#include "util/cursor.hpp"
+#include "data/sql/pg_copy_writer.hpp"
 #include <algorithm>
+#include <iterator>
 #include <ranges>
 
 using namespace blitz_query_cpp;
 using namespace blitz_query_cpp::sql;
 
+// collection segment convention: { items pageInfo } and paging arguments
+static constexpr std::string_view ItemsField = "items";
+static constexpr std::string_view TotalCountField = "totalCount";
+static constexpr std::string_view SkipArgument = "skip";
+static constexpr std::string_view TakeArgument = "take";
+static constexpr std::string_view OrderArgument = "order";
+static constexpr std::string_view AfterArgument = "after";
+static constexpr std::string_view WhereArgument = "where";
+
+// mutation fields are add_<type>, update_<type> and delete_<type> of table type
+static constexpr std::string_view InsertOperation = "insert";
+static constexpr std::string_view UpdateOperation = "update";
+static constexpr std::string_view DeleteOperation = "delete";
+static constexpr std::pair<std::string_view, std::string_view> MutationPrefixes[] = {
+    {"add_", InsertOperation}, {"update_", UpdateOperation}, {"delete_", DeleteOperation}};
+// field of mutation result object, changed rows are counted
+static constexpr std::string_view CountObjectsModifiedField = "countObjectsModified";
+
 namespace ranges = std::ranges;
 
 bool sql_query_resolver::process(query_context &context)
 {
-    if (context.data.contains(Key))
+    if (context.data.contains(Key) || context.is_resolved())
         return true;
     auto operationIter = ranges::find_if(
         context.document.children,
@@ -33,19 +54,779 @@ bool sql_query_resolver::process(query_context &context)
     return true;
 }
 
-bool sql_query_resolver::process_field(query_context &, const field &field_decl)
+column_t sql_query_resolver::level_column(selection_level &level, std::string_view identifier)
+{
+    // outer query sees only output columns of subquery
+    if (level.subquery.node && std::find(level.columns.begin(), level.columns.end(), identifier) == level.columns.end())
+    {
+        level.columns.push_back(identifier);
+        level.subquery |= column(level.alias, static_str{identifier});
+    }
+    return column(level.alias, static_str{identifier});
+}
+
+int sql_query_resolver::find_output_column(const selection_level &level, const sql::column_mapping &column_map)
+{
+    for (auto [output_column, index] : level.output)
+    {
+        if (output_column == &column_map)
+            return int(index);
+    }
+    return -1;
+}
+
+// field selected under several response keys is output once, its shape entries share the column
+bool sql_query_resolver::process_field(query_context &, selection_level &level, const sql::column_mapping &column_map, std::string_view response_key)
+{
+    result_shape &shape = *level.shape;
+    if (std::find(shape.fields.begin(), shape.fields.end(), response_key) != shape.fields.end())
+        return true;
+    int column_index = find_output_column(level, column_map);
+    if (column_index < 0)
+    {
+        _query |= level_column(level, column_map.identifier);
+        column_index = columns_count++;
+        level.output.emplace_back(&column_map, column_index);
+    }
+    shape.fields.emplace_back(response_key);
+    shape.field_columns.push_back(index_t(column_index));
+    return true;
+}
+
+// types shared with base schema refer to base versions of types changed by the schema
+static const object_type *type_of(const schema_t &schema, const input_value &value)
+{
+    return schema.current_type(value.field_type.type);
+}
+
+static bool is_relation(const field &field_decl)
+{
+    return field_decl.field_type.type && field_decl.field_type.type->sql_mapping;
+}
+
+// tables of other schemas are not joined, they may live in other database
+static bool is_batched(const sql::table_mapping &parent_mapping, const field &field_decl)
+{
+    return field_decl.field_type.type->sql_mapping->schema_identifier != parent_mapping.schema_identifier;
+}
+
+static bool has_relations(const object_type &type, syntax_node *selection_set)
+{
+    return std::any_of(selection_set->children.begin(), selection_set->children.end(), [&type](syntax_node *field_node)
+                       {
+                           auto field_decl = type.find_field(field_node->name_symbol, {field_node->name, field_node->name_hash_code});
+                           return field_decl && is_relation(*field_decl); });
+}
+
+static syntax_node *find_argument(syntax_node *field_node, std::string_view name)
+{
+    for (syntax_node *argument : field_node->arguments)
+    {
+        if (argument->name == name && !argument->children.empty())
+            return argument->children[0];
+    }
+    return nullptr;
+}
+
+static std::string_view variable_name(const syntax_node *value)
+{
+    std::string_view name = value->name;
+    if (name.starts_with('$'))
+        name.remove_prefix(1);
+    return name;
+}
+
+// n-ary AND or OR, empty conditions are skipped and nested ones of the same type are merged
+static sql_expr_t combine_conditions(sql_expr_type type, const std::vector<sql_expr_t> &conditions)
+{
+    std::vector<sql_expr_t> res;
+    std::copy_if(conditions.begin(), conditions.end(), std::back_inserter(res), [](sql_expr_t cond)
+                 { return cond.node != nullptr; });
+    if (res.size() == 1)
+        return res[0];
+    sql_expr_t op;
+    if (res.empty())
+        return op;
+    op = sql_expr_t{type};
+    for (sql_expr_t cond : res)
+    {
+        if (cond.type() != type)
+        {
+            op.add_child(cond);
+            continue;
+        }
+        for (sql_node *child : cond.children())
+            op.add_child(sql_expr_t{child});
+    }
+    return op;
+}
+
+// values of filter are parameters, literals become parameters at rendering
+static bool filter_value(query_context &context, syntax_node *value, sql_expr_t &res)
+{
+    if (value->of_type(syntax_node_type::Variable))
+        res = sql_expr_t{sql_expr_type::Parameter, variable_name(value)};
+    else if (value->of_type(syntax_node_type::StringValue | syntax_node_type::EnumValue))
+        res = sql_expr_t{sql_expr_type::StringLiteral, value->content};
+    else if (value->of_type(syntax_node_type::IntValue | syntax_node_type::FloatValue))
+        res = sql_expr_t{sql_expr_type::NumberLiteral, value->content};
+    else if (value->of_type(syntax_node_type::BoolValue))
+        res = sql_expr_t{sql_expr_type::StringLiteral, static_str{value->boolValue ? "true" : "false"}};
+    else
+        return context.report_error("Value '{}' should be a scalar", value->content);
+    return true;
+}
+
+// LIKE pattern is computed from literal now and from variable at bind
+static bool like_value(query_context &context, syntax_node *value, sql::like_match match, sql_expr_t &res)
+{
+    if (value->of_type(syntax_node_type::Variable))
+        res = sql_expr_t{sql_expr_type::Parameter, like_parameter_name(variable_name(value), match)};
+    else if (value->of_type(syntax_node_type::StringValue))
+        res = sql_expr_t{sql_expr_type::StringLiteral, sql::pg_like_pattern(value->content, match)};
+    else
+        return context.report_error("Filter value '{}' should be a String", value->content);
+    return true;
+}
+
+// list is one array parameter, so column = ANY($n) uses index; array of list variable is computed at bind
+static bool array_value(query_context &context, syntax_node *value, sql_expr_t &res)
+{
+    if (value->of_type(syntax_node_type::Variable))
+    {
+        res = sql_expr_t{sql_expr_type::Parameter, list_parameter_name(variable_name(value))};
+        return true;
+    }
+    if (!value->of_type(syntax_node_type::ListValue))
+        return context.report_error("Filter value '{}' should be a list", value->content);
+    std::vector<std::string_view> items;
+    for (syntax_node *item : value->children)
+    {
+        if (!item->of_type(syntax_node_type::StringValue | syntax_node_type::EnumValue | syntax_node_type::IntValue | syntax_node_type::FloatValue))
+            return context.report_error("Item '{}' of filter list should be a literal", item->content);
+        items.push_back(item->content);
+    }
+    res = sql_expr_t{sql_expr_type::StringLiteral, sql::pg_array_literal(items)};
+    return true;
+}
+
+static node_span list_items(syntax_node *&value)
+{
+    // single object is coerced to list
+    return value->of_type(syntax_node_type::ListValue) ? value->children : node_span(&value, 1);
+}
+
+// operation input like StringOperationFilterInput of one column
+static bool process_operations_filter(query_context &context, sql_expr_t col, syntax_node *operations, sql_expr_t &condition)
+{
+    if (!operations->of_type(syntax_node_type::ObjectValue))
+        return context.report_error("Filter of '{}' should be an object", operations->content);
+    std::vector<sql_expr_t> conditions;
+    for (syntax_node *operation : operations->children)
+    {
+        if (operation->children.empty())
+            continue;
+        std::string_view op = operation->name;
+        syntax_node *value = operation->children[0];
+        sql_expr_t cond, operand;
+        bool negate = op.starts_with('n') && op != "neq";
+        if (op == "and" || op == "or")
+        {
+            std::vector<sql_expr_t> items;
+            for (syntax_node *item : list_items(value))
+            {
+                if (!process_operations_filter(context, col, item, items.emplace_back()))
+                    return false;
+            }
+            cond = combine_conditions(op == "and" ? sql_expr_type::And : sql_expr_type::Or, items);
+        }
+        else if ((op == "eq" || op == "neq") && value->of_type(syntax_node_type::NullValue))
+            cond = sql_expr_t{op == "eq" ? sql_expr_type::IsNull : sql_expr_type::IsNotNull, {}, col};
+        else if (op == "in" || op == "nin")
+        {
+            if (!array_value(context, value, operand))
+                return false;
+            sql_expr_t quantifier = function(static_str{op == "in" ? "ANY" : "ALL"}, {operand});
+            cond = binary_operation(col, op == "in" ? binary_op::Eq : binary_op::Ne, quantifier);
+        }
+        else if (op == "startsWith" || op == "nstartsWith" || op == "endsWith" || op == "nendsWith" || op == "contains" || op == "ncontains")
+        {
+            sql::like_match match = op.ends_with("tartsWith") ? sql::like_match::Prefix : op.ends_with("ndsWith") ? sql::like_match::Suffix : sql::like_match::Contains;
+            if (!like_value(context, value, match, operand))
+                return false;
+            cond = binary_operation(col, binary_op::Like, operand);
+            if (negate)
+                cond = sql_expr_t{sql_expr_type::Not, {}, cond};
+        }
+        else
+        {
+            // ngt is <= and so on, rows with null are not matched either way
+            static constexpr std::pair<std::string_view, binary_op> comparisons[] = {
+                {"eq", binary_op::Eq}, {"neq", binary_op::Ne}, {"gt", binary_op::Gt}, {"gte", binary_op::Gq}, {"lt", binary_op::Le}, {"lte", binary_op::Lq},
+                {"ngt", binary_op::Lq}, {"ngte", binary_op::Le}, {"nlt", binary_op::Gq}, {"nlte", binary_op::Gt}};
+            auto comparison = std::find_if(std::begin(comparisons), std::end(comparisons), [op](auto &c)
+                                           { return c.first == op; });
+            if (comparison == std::end(comparisons))
+                return context.report_error("Filter operation '{}' is not supported", op);
+            if (!filter_value(context, value, operand))
+                return false;
+            cond = binary_operation(col, comparison->second, operand);
+        }
+        conditions.push_back(cond);
+    }
+    condition = combine_conditions(sql_expr_type::And, conditions);
+    return true;
+}
+
+// filter input like fileFilterInput: fields, and, or
+static bool process_filter(query_context &context, const sql::table_mapping &mapping, const std::string &alias_name, const object_type &type,
+                           syntax_node *filter, sql_expr_t &condition)
+{
+    // structure of filter makes SQL of the plan, so it can't come from variable
+    if (filter->of_type(syntax_node_type::Variable))
+        return context.report_error("Filter of '{}' should be a literal object, variable '{}' is not supported", type.name, filter->name);
+    if (!filter->of_type(syntax_node_type::ObjectValue))
+        return context.report_error("Filter of '{}' should be a literal object", type.name);
+    std::vector<sql_expr_t> conditions;
+    for (syntax_node *filter_field : filter->children)
+    {
+        if (filter_field->children.empty())
+            continue;
+        syntax_node *value = filter_field->children[0];
+        if (filter_field->name == "and" || filter_field->name == "or")
+        {
+            std::vector<sql_expr_t> items;
+            for (syntax_node *item : list_items(value))
+            {
+                if (!process_filter(context, mapping, alias_name, type, item, items.emplace_back()))
+                    return false;
+            }
+            conditions.push_back(combine_conditions(filter_field->name == "and" ? sql_expr_type::And : sql_expr_type::Or, items));
+            continue;
+        }
+        auto field_decl = type.find_field(filter_field->name_symbol, {filter_field->name, filter_field->name_hash_code});
+        if (field_decl == nullptr)
+            return context.report_error("Field '{}' to filter by is not found in object '{}'", filter_field->name, type.name);
+        if (is_relation(*field_decl))
+            return context.report_error("Filter by relation '{}' is not supported", filter_field->name);
+        if (!process_operations_filter(context, column(alias_name, static_str{mapping.column(*field_decl).identifier}), value, conditions.emplace_back()))
+            return false;
+    }
+    condition = combine_conditions(sql_expr_type::And, conditions);
+    return true;
+}
+
+// where argument of field becomes WHERE of query which selects its rows
+static bool add_where_argument(query_context &context, const sql::table_mapping &mapping, const std::string &alias_name, const object_type &type,
+                               syntax_node *field_node, sql_expr_t &query)
+{
+    syntax_node *filter = find_argument(field_node, WhereArgument);
+    if (!filter || filter->of_type(syntax_node_type::NullValue))
+        return true;
+    sql_expr_t condition;
+    if (!process_filter(context, mapping, alias_name, type, filter, condition))
+        return false;
+    if (condition.node)
+        query = query | where(condition);
+    return true;
+}
+
+index_t sql_query_resolver::output_column(selection_level &level, const sql::column_mapping &column_map)
 {
-    std::string_view column_name = field_decl.name;
-    if (auto column_dir = field_decl.find_directive(ColumnDirective))
+    int column_index = find_output_column(level, column_map);
+    if (column_index >= 0)
+        return index_t(column_index);
+    _query |= level_column(level, column_map.identifier);
+    level.shape->hidden_columns++;
+    level.output.emplace_back(&column_map, columns_count);
+    return columns_count++;
+}
+
+bool sql_query_resolver::process_selection(query_context &context, selection_level &level, const object_type &type, syntax_node *selection_set, field_mask &selected)
+{
+    const sql::table_mapping *mapping = level.mapping;
+    std::vector<std::pair<const field *, syntax_node *>> relations;
+    bool use_mask = type.has_field_mask();
+    for (auto field_node : selection_set->children)
     {
-        auto column_param = column_dir->parameters.find("name");
-        if (column_param != column_dir->parameters.end())
-            column_name = column_param->string_value;
+        auto field_decl = type.find_field(field_node->name_symbol, {field_node->name, field_node->name_hash_code});
+        if (field_decl == nullptr)
+            return context.report_error("Field '{}' is not found in object '{}'", field_node->name, type.name);
+        // nested selections follow columns of this level
+        if (is_relation(*field_decl))
+        {
+            relations.emplace_back(field_decl, field_node);
+            continue;
+        }
+        // duplicates of a field share its column, every response key gets shape entry
+        if (use_mask)
+            selected.set(field_decl->index);
+        if (!process_field(context, level, mapping->column(*field_decl), field_node->alias))
+            return false;
+    }
+
+    if (use_mask)
+    {
+        // always projected fields which are not selected explicitly
+        field_mask projected = mapping->always_projected_mask - selected;
+        bool res = true;
+        projected.for_each([&](index_t field_index)
+                           { res = res && process_field(context, level, mapping->columns[field_index], mapping->columns[field_index].field_decl->name); });
+        if (!res)
+            return false;
+        selected |= projected;
     }
-    if(current_selection_alias.empty())
-        _query |= column(_schema_name, _table_name, column_name);
     else
-        _query |= column(current_selection_alias, column_name);
+    {
+        for (index_t field_index : mapping->always_projected)
+        {
+            const sql::column_mapping &column_map = mapping->columns[field_index];
+            if (find_output_column(level, column_map) < 0 && !process_field(context, level, column_map, column_map.field_decl->name))
+                return false;
+        }
+    }
+
+    // rows of nested lists repeat the object, primary key tells them apart
+    if (need_keys)
+    {
+        for (index_t field_index : mapping->primary_key)
+            level.shape->key_columns.push_back(output_column(level, mapping->columns[field_index]));
+    }
+
+    for (const sql::column_mapping *key : level.sort_keys)
+        level.shape->cursor_columns.push_back(output_column(level, *key));
+
+    // batched selections add parent key columns before columns of joined selections
+    for (auto [field_decl, field_node] : relations)
+    {
+        if (is_batched(*mapping, *field_decl) && !process_batched_relation(context, level, *field_decl, field_node))
+            return false;
+    }
+    for (auto [field_decl, field_node] : relations)
+    {
+        if (!is_batched(*mapping, *field_decl) && !process_relation(context, level, *field_decl, field_node))
+            return false;
+    }
+    return true;
+}
+
+using relation_columns_t = std::vector<std::pair<const sql::column_mapping *, const sql::column_mapping *>>;
+
+// pairs of parent and child columns from @relation
+static bool get_relation_columns(query_context &context, const sql::table_mapping &parent_mapping, const object_type &parent_type,
+                                 const field &field_decl, syntax_node *field_node, relation_columns_t &columns)
+{
+    const object_type &type = *type_of(*context.schema, field_decl);
+    const sql::column_mapping &relation = parent_mapping.column(field_decl);
+    if (relation.relation_fields.empty() || relation.relation_fields.size() != relation.relation_references.size())
+        return context.report_error("Field '{}' of type '{}' has no valid @relation directive", field_decl.name, parent_type.name);
+    if (field_node->selection_set == nullptr)
+        return context.report_error("Field '{}' should have selection set", field_node->name);
+    for (index_t i = 0; i < relation.relation_fields.size(); i++)
+    {
+        auto parent_field = parent_type.fields.find(relation.relation_fields[i]);
+        if (parent_field == parent_type.fields.end())
+            return context.report_error("Field '{}' in @relation of '{}' is not found in type '{}'", relation.relation_fields[i], field_decl.name, parent_type.name);
+        auto child_field = type.fields.find(relation.relation_references[i]);
+        if (child_field == type.fields.end())
+            return context.report_error("Field '{}' in @relation of '{}' is not found in type '{}'", relation.relation_references[i], field_decl.name, type.name);
+        columns.emplace_back(&parent_mapping.column(*parent_field), &type.sql_mapping->column(*child_field));
+    }
+    return true;
+}
+
+// relation by primary key of related table joins at most one row
+static bool references_primary_key(const sql::table_mapping &mapping, const relation_columns_t &columns)
+{
+    if (mapping.primary_key.empty() || mapping.primary_key.size() != columns.size())
+        return false;
+    return std::all_of(mapping.primary_key.begin(), mapping.primary_key.end(), [&](index_t field_index)
+                       { return std::any_of(columns.begin(), columns.end(), [&](auto pair)
+                                            { return pair.second == &mapping.columns[field_index]; }); });
+}
+
+static sql_expr_t relation_table(const sql::table_mapping &mapping, syntax_node *field_node, const std::string &alias_name)
+{
+    sql_str table_name = mapping.table_identifier.empty() ? sql_str{field_node->name} : sql_str{static_str{mapping.table_identifier}};
+    return alias(table(static_str{mapping.schema_identifier}, table_name), alias_name);
+}
+
+bool sql_query_resolver::process_relation(query_context &context, selection_level &parent, const field &field_decl, syntax_node *field_node)
+{
+    const object_type &type = *type_of(*context.schema, field_decl);
+    relation_columns_t relation_columns;
+    if (!get_relation_columns(context, *parent.mapping, *parent.shape->type, field_decl, field_node, relation_columns))
+        return false;
+
+    selection_level level;
+    level.mapping = type.sql_mapping.get();
+    level.alias = next_alias_name();
+    level.subquery = select();
+    level.shape = &parent.shape->children.emplace_back();
+    level.shape->type = &type;
+    level.shape->root_field = field_node->alias;
+    level.shape->is_list = field_decl.list_nesting_depth > 0;
+    level.shape->first_column = columns_count;
+
+    level.subquery |= from(relation_table(*level.mapping, field_node, level.alias));
+    for (auto [parent_column, child_column] : relation_columns)
+    {
+        level.subquery = level.subquery | where(binary_operation(column(level.alias, static_str{child_column->identifier}),
+                                                 binary_op::Eq, level_column(parent, parent_column->identifier)));
+    }
+    if (!add_where_argument(context, *level.mapping, level.alias, type, field_node, level.subquery))
+        return false;
+    // joined before joins of nested selections which refer to it
+    _query |= lateral_join(alias(level.subquery, level.alias), references_primary_key(*level.mapping, relation_columns));
+
+    field_mask selected;
+    return process_selection(context, level, type, field_node->selection_set, selected);
+}
+
+bool sql_query_resolver::process_batched_relation(query_context &context, selection_level &parent, const field &field_decl, syntax_node *field_node)
+{
+    const object_type &type = *type_of(*context.schema, field_decl);
+    relation_columns_t relation_columns;
+    if (!get_relation_columns(context, *parent.mapping, *parent.shape->type, field_decl, field_node, relation_columns))
+        return false;
+    if (relation_columns.size() != 1)
+        return context.report_error("Field '{}' is loaded by separate query, its @relation should have one field", field_decl.name);
+    auto [parent_column, child_column] = relation_columns[0];
+
+    // batches of nested selections are added while this one is processed
+    size_t batch_index = context.batches.size();
+    context.batches.emplace_back();
+    context.batches[batch_index].parent_key_column = output_column(parent, *parent_column);
+
+    selection_level level;
+    level.mapping = type.sql_mapping.get();
+    level.alias = next_alias_name();
+    level.shape = &parent.shape->children.emplace_back();
+    level.shape->type = &type;
+    level.shape->root_field = field_node->alias;
+    level.shape->is_list = field_decl.list_nesting_depth > 0;
+    level.shape->batch = int(batch_index);
+    level.shape->first_column = 1;
+
+    // separate statement, key column goes first
+    sql_expr_t parent_query = _query;
+    int parent_columns_count = columns_count;
+    bool parent_need_keys = need_keys;
+    sql_expr_t keys = function(static_str{"ANY"}, {sql_expr_t{sql_expr_type::Parameter, static_str{"1"}}});
+    _query = select() | column(level.alias, static_str{child_column->identifier}) |
+             from(relation_table(*level.mapping, field_node, level.alias)) |
+             where(binary_operation(column(level.alias, static_str{child_column->identifier}), binary_op::Eq, keys));
+    columns_count = 1;
+    need_keys = has_relations(type, field_node->selection_set);
+    // selected key field reads the key column
+    level.output.emplace_back(child_column, 0);
+
+    field_mask selected;
+    bool res = add_where_argument(context, *level.mapping, level.alias, type, field_node, _query) &&
+               process_selection(context, level, type, field_node->selection_set, selected);
+    context.batch_queries.resize(context.batches.size());
+    context.batch_queries[batch_index] = _query;
+
+    _query = parent_query;
+    columns_count = parent_columns_count;
+    need_keys = parent_need_keys;
+    return res;
+}
+
+// rows after cursor: (k1, k2) > (v1, v2) if keys have the same direction,
+// k1 > v1 OR (k1 = v1 AND k2 < v2) otherwise
+static sql_expr_t keyset_condition(const std::string &alias_name, const std::vector<const sql::column_mapping *> &keys,
+                                   const std::vector<bool> &ascending, const std::vector<sql_expr_t> &values)
+{
+    auto key_column = [&](size_t i) -> sql_expr_t
+    { return column(alias_name, static_str{keys[i]->identifier}); };
+    auto after_op = [&](size_t i)
+    { return ascending[i] ? binary_op::Gt : binary_op::Le; };
+
+    if (std::all_of(ascending.begin(), ascending.end(), [&](bool asc)
+                    { return asc == ascending[0]; }))
+    {
+        sql_expr_t key_row{sql_expr_type::Row};
+        sql_expr_t value_row{sql_expr_type::Row};
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            key_row.add_child(key_column(i));
+            value_row.add_child(values[i]);
+        }
+        return binary_operation(key_row, after_op(0), value_row);
+    }
+    sql_expr_t res{sql_expr_type::Or};
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        sql_expr_t cond = binary_operation(key_column(i), after_op(i), values[i]);
+        if (i > 0)
+        {
+            sql_expr_t same_prefix{sql_expr_type::And};
+            for (size_t k = 0; k < i; k++)
+                same_prefix.add_child(binary_operation(key_column(k), binary_op::Eq, values[k]));
+            same_prefix.add_child(cond);
+            cond = same_prefix;
+        }
+        res.add_child(cond);
+    }
+    return res;
+}
+
+// cursor of segment, null when it is not given. Variable which is null or not
+// given is a different plan, see document_signature
+static syntax_node *find_cursor(const query_context &context, syntax_node *segment)
+{
+    syntax_node *after = find_argument(segment, AfterArgument);
+    if (!after || after->of_type(syntax_node_type::NullValue))
+        return nullptr;
+    if (after->of_type(syntax_node_type::Variable))
+    {
+        auto variable = context.variables.find(std::string{variable_name(after)});
+        if (variable == context.variables.end() || variable->second == "null")
+            return nullptr;
+    }
+    return after;
+}
+
+// order, skip, take and cursor of collection segment; sort keys are extended
+// by primary key, so cursor points to exactly one row
+bool sql_query_resolver::process_paging(query_context &context, selection_level &level, const object_type &type, syntax_node *segment, sql_expr_t &page)
+{
+    const sql::table_mapping &mapping = *level.mapping;
+    std::vector<bool> ascending;
+    if (syntax_node *order = find_argument(segment, OrderArgument))
+    {
+        if (!order->of_type(syntax_node_type::ListValue | syntax_node_type::ObjectValue))
+            return context.report_error("Argument '{}' of '{}' should be a literal list", OrderArgument, segment->name);
+        // single object is coerced to list
+        node_span items = order->of_type(syntax_node_type::ListValue) ? order->children : node_span(&order, 1);
+        for (syntax_node *item : items)
+        {
+            for (syntax_node *field_order : item->children)
+            {
+                auto field_decl = type.find_field(field_order->name_symbol, {field_order->name, field_order->name_hash_code});
+                if (field_decl == nullptr || is_relation(*field_decl))
+                    return context.report_error("Field '{}' to order by is not found in object '{}'", field_order->name, type.name);
+                if (field_order->children.empty() || (field_order->children[0]->content != "ASC" && field_order->children[0]->content != "DESC"))
+                    return context.report_error("Order of field '{}' should be ASC or DESC", field_order->name);
+                level.sort_keys.push_back(&mapping.column(*field_decl));
+                ascending.push_back(field_order->children[0]->content == "ASC");
+            }
+        }
+    }
+    for (index_t field_index : mapping.primary_key)
+    {
+        const sql::column_mapping *key = &mapping.columns[field_index];
+        if (std::find(level.sort_keys.begin(), level.sort_keys.end(), key) != level.sort_keys.end())
+            continue;
+        level.sort_keys.push_back(key);
+        ascending.push_back(true);
+    }
+
+    if (syntax_node *after = find_cursor(context, segment))
+    {
+        if (level.sort_keys.empty())
+            return context.report_error("Cursor of '{}' needs order or primary key", segment->name);
+        // cursor is a position in keyset, offset from it would skip rows of the next page
+        if (find_argument(segment, SkipArgument))
+            return context.report_error("Arguments '{}' and '{}' of '{}' can't be used together", SkipArgument, AfterArgument, segment->name);
+        // NULL is neither greater nor less than cursor value, rows with it would be lost
+        for (const sql::column_mapping *key : level.sort_keys)
+        {
+            const field &key_field = *key->field_decl;
+            if (!key->is_primary_key && (key_field.field_type_nullability & (1u << key_field.list_nesting_depth)) != 0)
+                return context.report_error("Field '{}' is nullable, cursor of '{}' can't follow it", key_field.name, segment->name);
+        }
+        std::vector<sql_expr_t> values;
+        if (after->of_type(syntax_node_type::Variable))
+        {
+            for (index_t i = 0; i < level.sort_keys.size(); i++)
+                values.emplace_back(sql_expr_type::Parameter, cursor_parameter_name(variable_name(after), i));
+        }
+        else
+        {
+            std::vector<std::string> cursor;
+            if (!after->of_type(syntax_node_type::StringValue) || !decode_cursor(after->content, cursor) || cursor.size() != level.sort_keys.size())
+                return context.report_error("Argument '{}' of '{}' is not a valid cursor", AfterArgument, segment->name);
+            for (const std::string &value : cursor)
+                values.emplace_back(sql_expr_type::StringLiteral, value);
+        }
+        page = page | where(keyset_condition(level.alias, level.sort_keys, ascending, values));
+    }
+    // rows of page taken in subquery keep its order after joins
+    for (size_t i = 0; i < level.sort_keys.size(); i++)
+    {
+        page = page | order_by(column(level.alias, static_str{level.sort_keys[i]->identifier}), ascending[i]);
+        if (page.node != _query.node)
+            _query = _query | order_by(column(level.alias, static_str{level.sort_keys[i]->identifier}), ascending[i]);
+    }
+
+    if (syntax_node *skip = find_argument(segment, SkipArgument))
+    {
+        if (skip->of_type(syntax_node_type::Variable))
+            page = page | offset(sql_expr_t{sql_expr_type::Parameter, variable_name(skip)});
+        else if (skip->of_type(syntax_node_type::IntValue) && skip->intValue >= 0)
+            page = page | offset(int(skip->intValue));
+        else
+            return context.report_error("Argument '{}' of '{}' should be non negative Int", SkipArgument, segment->name);
+    }
+    if (syntax_node *take = find_argument(segment, TakeArgument))
+    {
+        // one more row tells that the next page exists
+        if (take->of_type(syntax_node_type::Variable))
+        {
+            level.shape->page_size_variable = variable_name(take);
+            page = page | limit(binary_operation(sql_expr_t{sql_expr_type::Parameter, variable_name(take)}, binary_op::Plus,
+                                                     sql_expr_t{sql_expr_type::NumberLiteral, static_str{"1"}}));
+        }
+        else if (take->of_type(syntax_node_type::IntValue) && take->intValue >= 0)
+        {
+            level.shape->page_size = index_t(take->intValue);
+            page = page | limit(int(take->intValue + 1));
+        }
+        else
+            return context.report_error("Argument '{}' of '{}' should be non negative Int", TakeArgument, segment->name);
+    }
+    return true;
+}
+
+static bool is_count_estimate(const directive *dir)
+{
+    if (dir == nullptr)
+        return false;
+    auto mode = dir->parameters.find("mode");
+    return mode != dir->parameters.end() && mode->value.string_value() == "estimate";
+}
+
+// nested lists joined to rows multiply them, like joins_lists of shape which is not built yet
+static bool selects_joined_lists(const schema_t &schema, const object_type &type, syntax_node *selection_set)
+{
+    const sql::table_mapping &mapping = *type.sql_mapping;
+    return std::any_of(selection_set->children.begin(), selection_set->children.end(), [&](syntax_node *field_node)
+                       {
+                           auto field_decl = type.find_field(field_node->name_symbol, {field_node->name, field_node->name_hash_code});
+                           if (!field_decl || !is_relation(*field_decl) || is_batched(mapping, *field_decl))
+                               return false;
+                           return field_decl->list_nesting_depth > 0 ||
+                                  (field_node->selection_set && selects_joined_lists(schema, *type_of(schema, *field_decl), field_node->selection_set)); });
+}
+
+// nested lists joined to rows of segment multiply them
+static bool joins_lists(const result_shape &shape)
+{
+    return std::any_of(shape.children.begin(), shape.children.end(), [](const result_shape &child)
+                       { return child.batch < 0 && (child.is_list || joins_lists(child)); });
+}
+
+// totalCount is a column of the page query, so it costs no extra round trip and
+// nothing is counted when it is not selected
+bool sql_query_resolver::process_total_count(query_context &context, selection_level &level, const object_type &type, const field &segment_field, syntax_node *segment)
+{
+    bool selected = std::any_of(segment->selection_set->children.begin(), segment->selection_set->children.end(), [](syntax_node *field_node)
+                                { return field_node->name == TotalCountField; });
+    if (!selected)
+        return true;
+
+    const sql::table_mapping &mapping = *level.mapping;
+    sql_expr_t count;
+    if (is_count_estimate(segment_field.find_directive(CountModeDirective)) ||
+        is_count_estimate(type_of(*context.schema, segment_field)->find_directive(CountModeDirective)))
+    {
+        // reltuples is -1 for tables which were never analyzed
+        std::string table_name = std::string{_schema_name} + "." + std::string{_table_name};
+        sql_expr_t tuples = function(static_str{"greatest"}, {sql_expr_t{sql_expr_type::Column, static_str{"reltuples"}},
+                                                              sql_expr_t{sql_expr_type::NumberLiteral, static_str{"0"}}});
+        count = select() | column_t{cast(tuples, static_str{"bigint"})} | from(table(static_str{"pg_class"})) |
+                where(binary_operation(sql_expr_t{sql_expr_type::Column, static_str{"oid"}}, binary_op::Eq,
+                                       cast(sql_expr_t{sql_expr_type::StringLiteral, table_name}, static_str{"regclass"})));
+    }
+    else if (find_cursor(context, segment) || joins_lists(*level.shape))
+    {
+        // window would count only rows after cursor or joined rows of nested lists
+        std::string alias_name = next_alias_name();
+        count = select() | column_t{count_all()} | from(relation_table(mapping, segment, alias_name));
+        if (!add_where_argument(context, mapping, alias_name, type, segment, count))
+            return false;
+    }
+    else
+        count = window(count_all());
+
+    level.shape->total_count_column = columns_count++;
+    _query |= column_t{alias(count, static_str{"total_count"})};
+    return true;
+}
+
+// list is aggregated to json array, empty list is [] rather than null
+static sql_expr_t json_aggregate(sql_expr_t object, bool is_list)
+{
+    if (is_list)
+        return function(static_str{"coalesce"}, {function(static_str{"json_agg"}, {object}), json_literal(static_str{"[]"})});
+    return json_element(function(static_str{"json_agg"}, {object}), 0);
+}
+
+bool sql_query_resolver::process_json_selection(query_context &context, const sql::table_mapping &mapping, const std::string &alias_name, const object_type &type,
+                                                syntax_node *selection_set, sql_expr_t &query, sql_expr_t &object, field_mask &selected)
+{
+    object = sql_expr_t{sql_expr_type::JsonObject};
+    bool use_mask = type.has_field_mask();
+    std::vector<std::string_view> keys;
+    for (auto field_node : selection_set->children)
+    {
+        auto field_decl = type.find_field(field_node->name_symbol, {field_node->name, field_node->name_hash_code});
+        if (field_decl == nullptr)
+            return context.report_error("Field '{}' is not found in object '{}'", field_node->name, type.name);
+        // fields with the same response key are merged
+        if (std::find(keys.begin(), keys.end(), field_node->alias) != keys.end())
+            continue;
+        keys.push_back(field_node->alias);
+        if (is_relation(*field_decl))
+        {
+            sql_expr_t value;
+            if (!process_json_relation(context, mapping, alias_name, type, *field_decl, field_node, query, value))
+                return false;
+            object.add_child(json_field(field_node->alias, value));
+            continue;
+        }
+        if (use_mask)
+            selected.set(field_decl->index);
+        object.add_child(json_field(field_node->alias, column(alias_name, static_str{mapping.column(*field_decl).identifier})));
+    }
+    return true;
+}
+
+bool sql_query_resolver::process_json_relation(query_context &context, const sql::table_mapping &parent_mapping, const std::string &parent_alias, const object_type &parent_type,
+                                               const field &field_decl, syntax_node *field_node, sql_expr_t &query, sql_expr_t &value)
+{
+    const object_type &type = *type_of(*context.schema, field_decl);
+    relation_columns_t relation_columns;
+    if (!get_relation_columns(context, parent_mapping, parent_type, field_decl, field_node, relation_columns))
+        return false;
+
+    // subquery returns one row with data column, nested selections are joined inside it
+    const sql::table_mapping &mapping = *type.sql_mapping;
+    std::string alias_name = next_alias_name();
+    sql_expr_t subquery = select() | from(relation_table(mapping, field_node, alias_name));
+    for (auto [parent_column, child_column] : relation_columns)
+    {
+        subquery = subquery | where(binary_operation(column(alias_name, static_str{child_column->identifier}),
+                                                     binary_op::Eq, column(parent_alias, static_str{parent_column->identifier})));
+    }
+
+    if (!add_where_argument(context, mapping, alias_name, type, field_node, subquery))
+        return false;
+
+    sql_expr_t object;
+    field_mask selected;
+    if (!process_json_selection(context, mapping, alias_name, type, field_node->selection_set, subquery, object, selected))
+        return false;
+    bool is_list = field_decl.list_nesting_depth > 0;
+    if (is_list)
+        subquery |= column_t{alias(json_aggregate(object, true), static_str{"data"})};
+    else
+        subquery = subquery | column_t{alias(object, static_str{"data"})} | limit(1);
+
+    query |= lateral_join(alias(subquery, alias_name), true);
+    value = column(alias_name, static_str{"data"});
     return true;
 }
 
@@ -53,74 +834,641 @@ bool sql_query_resolver::process_query(query_context &context)
 {
     if (_operation->selection_set->children.size() != 1)
         return context.report_error("Query should have only one selection set");
-    auto &object = _operation->selection_set->children[0];
+    syntax_node *object = _operation->selection_set->children[0];
 
     auto query_type = context.schema->get_query_type();
     if (!query_type)
         return context.report_error("Query type is not defined in schema");
 
-    auto root_selection_field = query_type->fields.find(object->name);
-    if (root_selection_field == query_type->fields.end())
+    auto root_selection_field = query_type->find_field(object->name_symbol, {object->name, object->name_hash_code});
+    if (root_selection_field == nullptr)
         return context.report_error("Field '{}' is not declared in type '{}'", object->name, query_type->name);
 
-    const auto type = root_selection_field->field_type.type;
+    const object_type *type = type_of(*context.schema, *root_selection_field);
     if (type == nullptr)
         return context.report_error("Type of field '{}' in object '{}' is not defined", object->name, query_type->name);
 
-    auto table_schema_dir = type->find_directive(TableDirective);
+    const sql::table_mapping *mapping = type->sql_mapping.get();
+    auto selection_set = object->selection_set;
+    bool is_list = root_selection_field->list_nesting_depth > 0;
+
+    // collection segment, rows are its items
+    syntax_node *segment = nullptr;
+    auto items_field = type->fields.find(ItemsField);
+    const object_type *items_type = items_field != type->fields.end() ? type_of(*context.schema, *items_field) : nullptr;
+    if (!mapping && items_type && items_type->sql_mapping)
+    {
+        if (format == result_format::Json)
+            return context.report_error("Collection segment '{}' is not supported in JSON format", object->name);
+        auto items_node = std::find_if(selection_set->children.begin(), selection_set->children.end(), [](syntax_node *field_node)
+                                       { return field_node->name == ItemsField; });
+        if (items_node == selection_set->children.end() || (*items_node)->selection_set == nullptr)
+            return context.report_error("Field '{}' should have selection of '{}'", object->name, ItemsField);
+        segment = object;
+        object = *items_node;
+        selection_set = object->selection_set;
+        type = items_type;
+        mapping = type->sql_mapping.get();
+        is_list = true;
+    }
 
     // not SQL type, handle else where
-    if (!table_schema_dir)
+    if (!mapping)
         return true;
 
-    auto table_param = table_schema_dir->parameters.find("table");
-    if (table_param != table_schema_dir->parameters.end())
-        _table_name = table_param->string_value;
+    _table_name = mapping->table_identifier;
     if (_table_name.empty())
-        _table_name = object->name;
-
-    auto schema_param = table_schema_dir->parameters.find("schema");
-    if (schema_param != table_schema_dir->parameters.end())
-        _schema_name = schema_param->string_value;
-    if (_schema_name.empty())
-        _schema_name = DefaultSchama;
+        _table_name = segment ? segment->name : object->name;
+    _schema_name = mapping->schema_identifier;
 
+    arena_scope scope{context.arena};
     _query = select();
-    auto selection_set = object->selection_set;
 
     current_selection_alias = next_alias_name();
     context.data[type->name] = current_selection_alias;
 
-    for (auto field_node : selection_set->children)
+    need_keys = has_relations(*type, selection_set);
+    // page of segment is counted in rows of root table, so with joined nested
+    // lists it is taken in subquery before the joins
+    sql_expr_t root_table = alias(table(_schema_name, _table_name), current_selection_alias);
+    sql_expr_t page = _query;
+    if (segment && selects_joined_lists(*context.schema, *type, selection_set))
+        page = select() | column_t{sql_expr_t{sql_expr_type::TableName, current_selection_alias, sql_expr_t{sql_expr_type::Star}}} | from(root_table);
+    if (!add_where_argument(context, *mapping, current_selection_alias, *type, segment ? segment : object, page))
+        return false;
+
+    _selection = selection_key{type, {}};
+    context.shape = result_shape{};
+    context.shape.type = type;
+    context.shape.root_field = object->alias;
+    context.shape.is_list = is_list;
+    if (segment)
+        context.shape.segment_field = segment->alias;
+
+    if (format == result_format::Json)
     {
-        auto field_decl = type->fields.find(field_node->name);
-        if (field_decl == type->fields.end())
-            return context.report_error("Field '{}' is not found in object '{}'", field_node->name, object->name);
-        if (!process_field(context, *field_decl))
+        // SELECT json_build_object('root', <aggregate of objects>) as data FROM ...
+        context.shape.is_json = true;
+        sql_expr_t json;
+        if (!process_json_selection(context, *mapping, current_selection_alias, *type, selection_set, _query, json, _selection.fields))
             return false;
+        _query = _query | column_t{alias(json_object({json_field(object->alias, json_aggregate(json, context.shape.is_list))}), static_str{"data"})} |
+                 from(alias(table(_schema_name, _table_name), current_selection_alias));
+        context.result = _query;
+        return true;
+    }
+
+    selection_level level;
+    level.mapping = mapping;
+    level.alias = current_selection_alias;
+    level.shape = &context.shape;
+    if (segment && !process_paging(context, level, *type, segment, page))
+        return false;
+    if (!process_selection(context, level, *type, selection_set, _selection.fields))
+        return false;
+    if (segment && !process_total_count(context, level, *type, *root_selection_field, segment))
+        return false;
+
+    _query |= from(page.node == _query.node ? root_table : alias(page, current_selection_alias));
+
+    context.result = _query;
+
+    return true;
+}
+
+// value of input object field, null is NULL
+static bool data_value(query_context &context, syntax_node *value, sql_expr_t &res)
+{
+    if (value->of_type(syntax_node_type::NullValue))
+    {
+        res = sql_expr_t{sql_expr_type::Null};
+        return true;
     }
+    return filter_value(context, value, res);
+}
 
-    for (auto &field_decl : type->fields)
+static syntax_node *object_field_value(syntax_node *object, std::string_view name)
+{
+    for (syntax_node *object_field : object->children)
     {
-        if (auto projected_dir = field_decl.find_directive(IsProjected))
+        if (object_field->name == name && !object_field->children.empty())
+            return object_field->children[0];
+    }
+    return nullptr;
+}
+
+// fields of input object in order of columns
+static bool input_columns(query_context &context, const object_type &type, syntax_node *object, std::vector<const field *> &columns)
+{
+    for (syntax_node *object_field : object->children)
+    {
+        auto field_decl = type.find_field(object_field->name_symbol, {object_field->name, object_field->name_hash_code});
+        if (field_decl == nullptr || is_relation(*field_decl))
+            return context.report_error("Field '{}' of input is not a column of '{}'", object_field->name, type.name);
+        columns.push_back(field_decl);
+    }
+    std::sort(columns.begin(), columns.end(), [](const field *a, const field *b)
+              { return a->index < b->index; });
+    return true;
+}
+
+// columns of list variable of input objects are all fields of its input type,
+// fields missing in objects are null
+static bool input_type_columns(query_context &context, const object_type &type, const object_type &input_type, std::vector<const field *> &columns)
+{
+    for (const field &input_field : input_type.fields)
+    {
+        auto field_decl = type.fields.find(input_field.name);
+        if (field_decl == type.fields.end() || is_relation(*field_decl))
+            return context.report_error("Field '{}' of input is not a column of '{}'", input_field.name, type.name);
+        columns.push_back(&*field_decl);
+    }
+    std::sort(columns.begin(), columns.end(), [](const field *a, const field *b)
+              { return a->index < b->index; });
+    return true;
+}
+
+// value of {Id: {eq: value}} filter by primary key
+static syntax_node *key_filter_value(const field &key_field, syntax_node *filter)
+{
+    if (!filter || !filter->of_type(syntax_node_type::ObjectValue) || filter->children.size() != 1)
+        return nullptr;
+    syntax_node *filter_field = filter->children[0];
+    if (filter_field->name != key_field.name || filter_field->children.empty())
+        return nullptr;
+    syntax_node *operations = filter_field->children[0];
+    if (!operations->of_type(syntax_node_type::ObjectValue) || operations->children.size() != 1)
+        return nullptr;
+    syntax_node *operation = operations->children[0];
+    if (operation->name != "eq" || operation->children.empty() || operation->children[0]->of_type(syntax_node_type::NullValue))
+        return nullptr;
+    return operation->children[0];
+}
+
+bool sql_query_resolver::parse_mutation_call(query_context &context, syntax_node *field_node, mutation_call &call)
+{
+    std::string_view name = field_node->name;
+    auto prefix = std::find_if(std::begin(MutationPrefixes), std::end(MutationPrefixes), [name](auto &p)
+                               { return name.starts_with(p.first); });
+    if (prefix == std::end(MutationPrefixes))
+        return context.report_error("Mutation '{}' should be add_, update_ or delete_ of table type", name);
+    call.field_node = field_node;
+    call.operation = prefix->second;
+    call.type = context.schema->find_type(name.substr(prefix->first.size()));
+    if (!call.type || !call.type->sql_mapping)
+        return context.report_error("Type of mutation '{}' is not a table", name);
+
+    // result is changed rows of table type or object with their count
+    bool returns_rows = type_of(*context.schema, *call.field_decl) == call.type;
+    std::vector<std::string_view> keys;
+    node_span selection;
+    if (field_node->selection_set)
+        selection = field_node->selection_set->children;
+    for (syntax_node *selected : selection)
+    {
+        if (std::find(keys.begin(), keys.end(), selected->alias) != keys.end())
+            continue;
+        keys.push_back(selected->alias);
+        if (!returns_rows && selected->name == CountObjectsModifiedField)
+        {
+            call.selection.emplace_back(selected->alias, nullptr);
+            continue;
+        }
+        const field *selected_field = returns_rows ? call.type->find_field(selected->name_symbol, {selected->name, selected->name_hash_code}) : nullptr;
+        if (!selected_field || is_relation(*selected_field))
+            return context.report_error("Field '{}' of mutation '{}' should be a column of '{}' or {}", selected->name, name, call.type->name, CountObjectsModifiedField);
+        call.selection.emplace_back(selected->alias, selected_field);
+    }
+
+    // argument other than where is input object or list of them
+    syntax_node *data = nullptr;
+    const object_type *input_type = nullptr;
+    for (syntax_node *argument : field_node->arguments)
+    {
+        if (argument->children.empty() || argument->children[0]->of_type(syntax_node_type::NullValue))
+            continue;
+        if (argument->name == WhereArgument)
+            call.filter = argument->children[0];
+        else
         {
-            auto projected = projected_dir->parameters.find("projected");
-            if (projected == projected_dir->parameters.end() || projected->bool_value == true)
+            data = argument->children[0];
+            auto argument_decl = call.field_decl->arguments.find(argument->name);
+            input_type = argument_decl == call.field_decl->arguments.end() ? nullptr : type_of(*context.schema, *argument_decl);
+        }
+    }
+    // inserted rows of list variable are a bulk load, its values are not in document
+    if (data && data->of_type(syntax_node_type::Variable) && call.operation == InsertOperation)
+    {
+        if (!input_type)
+            return context.report_error("Input type of '{}' is not found", name);
+        call.rows_variable = data;
+        if (!input_type_columns(context, *call.type, *input_type, call.columns))
+            return false;
+    }
+    else if (data)
+    {
+        for (syntax_node *item : list_items(data))
+        {
+            if (!item->of_type(syntax_node_type::ObjectValue))
+                return context.report_error("Input of '{}' should be literal objects, their fields may be variables", name);
+            std::vector<const field *> columns;
+            if (!input_columns(context, *call.type, item, columns))
+                return false;
+            if (!call.rows.empty() && columns != call.columns)
+                return context.report_error("Input objects of '{}' should have the same fields", name);
+            call.columns = std::move(columns);
+            call.rows.push_back(item);
+        }
+    }
+    if (call.operation == InsertOperation)
+    {
+        if (call.columns.empty())
+            return context.report_error("Mutation '{}' should have input object with fields", name);
+        return true;
+    }
+
+    // rows of single column primary key are found by key, so calls can be merged
+    const sql::table_mapping &mapping = *call.type->sql_mapping;
+    bool is_update = call.operation == UpdateOperation;
+    // key in data of rows found by filter would be either dropped or set to all of them
+    if (is_update && call.filter)
+    {
+        for (const field *column_field : call.columns)
+        {
+            if (mapping.column(*column_field).is_primary_key)
+                return context.report_error("Mutation '{}' finds rows by filter, its input can't set key field '{}'", name, column_field->name);
+        }
+    }
+    if (mapping.primary_key.size() == 1)
+    {
+        const field *key_field = mapping.columns[mapping.primary_key[0]].field_decl;
+        bool key_in_rows = std::find(call.columns.begin(), call.columns.end(), key_field) != call.columns.end();
+        syntax_node *filter_key = key_filter_value(*key_field, call.filter);
+        if (filter_key && call.rows.size() == (is_update ? 1u : 0u))
+        {
+            call.keys.push_back(filter_key);
+            call.filter = nullptr;
+        }
+        else if (!call.filter && key_in_rows && (is_update || call.columns.size() == 1))
+        {
+            for (syntax_node *row : call.rows)
+                call.keys.push_back(object_field_value(row, key_field->name));
+        }
+        // key is not updated
+        if (!call.keys.empty() && is_update)
+        {
+            std::erase(call.columns, key_field);
+            if (call.columns.empty())
+                return context.report_error("Mutation '{}' has no fields to update", name);
+        }
+    }
+    // rows found by filter get values of one input object
+    if (call.keys.empty() && call.rows.size() > 1)
+        return context.report_error("Mutation '{}' finds rows by filter with one input object, {} given", name, call.rows.size());
+    return true;
+}
+
+bool sql_query_resolver::can_merge(const mutation_call &a, const mutation_call &b)
+{
+    if (a.field_node->name != b.field_node->name || a.columns != b.columns || a.selection != b.selection || a.rows_variable || b.rows_variable)
+        return false;
+    return a.operation == InsertOperation || (!a.keys.empty() && !b.keys.empty());
+}
+
+static sql_expr_t returning_keys(const sql::table_mapping &mapping, const std::string &alias_name)
+{
+    sql_expr_t res{sql_expr_type::Returning};
+    for (index_t field_index : mapping.primary_key)
+    {
+        std::string_view identifier = mapping.columns[field_index].identifier;
+        if (alias_name.empty())
+            res.add_child(sql_expr_type::Column, static_str{identifier});
+        else
+            res.add_child(column(alias_name, static_str{identifier}));
+    }
+    if (mapping.primary_key.empty())
+        res.add_child(sql_expr_type::BoolLiteral, static_str{"TRUE"});
+    return res;
+}
+
+// RETURNING ordinal of VALUES row if any, then columns of selected fields.
+// Keys are returned when only count is selected, rows are counted then.
+sql_expr_t sql_query_resolver::returning(const mutation_call &call, const std::string &alias_name, sql_expr_t ordinal, mutation_statement &statement)
+{
+    const sql::table_mapping &mapping = *call.type->sql_mapping;
+    sql_expr_t res{sql_expr_type::Returning};
+    if (ordinal.node)
+        res.add_child(ordinal);
+    result_shape &shape = statement.shape;
+    shape.type = call.type;
+    shape.is_list = call.field_decl->list_nesting_depth > 0;
+    shape.first_column = index_t(res.children().size());
+    std::vector<const field *> returned;
+    for (auto [response_key, field_decl] : call.selection)
+    {
+        if (!field_decl)
+        {
+            statement.count_fields.emplace_back(response_key);
+            continue;
+        }
+        auto pos = std::find(returned.begin(), returned.end(), field_decl);
+        if (pos == returned.end())
+        {
+            std::string_view identifier = mapping.column(*field_decl).identifier;
+            if (alias_name.empty())
+                res.add_child(sql_expr_type::Column, static_str{identifier});
+            else
+                res.add_child(column(alias_name, static_str{identifier}));
+            pos = returned.insert(pos, field_decl);
+        }
+        shape.fields.emplace_back(response_key);
+        shape.field_columns.push_back(shape.first_column + index_t(pos - returned.begin()));
+    }
+    if (res.children().empty())
+        return returning_keys(mapping, alias_name);
+    return res;
+}
+
+static sql_expr_t where_clause(sql_expr_t condition)
+{
+    return {sql_expr_type::Where, {}, condition};
+}
+
+// rows are updated when input has their key, otherwise conflicting rows are skipped
+static sql_expr_t on_conflict(const sql::table_mapping &mapping, const std::vector<const field *> &columns)
+{
+    sql_expr_t res{sql_expr_type::OnConflict};
+    auto has_column = [&columns](const field *field_decl)
+    {
+        return std::find(columns.begin(), columns.end(), field_decl) != columns.end();
+    };
+    if (mapping.primary_key.empty() || columns.size() == mapping.primary_key.size())
+        return res;
+    sql_expr_t keys{sql_expr_type::Row};
+    for (index_t field_index : mapping.primary_key)
+    {
+        if (!has_column(mapping.columns[field_index].field_decl))
+            return res;
+        keys.add_child(sql_expr_type::Column, static_str{mapping.columns[field_index].identifier});
+    }
+    sql_expr_t set{sql_expr_type::Set};
+    for (const field *field_decl : columns)
+    {
+        const sql::column_mapping &column_map = mapping.column(*field_decl);
+        if (column_map.is_primary_key)
+            continue;
+        set.add_child(binary_operation(sql_expr_t{sql_expr_type::Column, static_str{column_map.identifier}}, binary_op::Eq,
+                                       column(static_str{"excluded"}, static_str{column_map.identifier})));
+    }
+    res.add_child(keys);
+    res.add_child(set);
+    return res;
+}
+
+// Rows go to temporary table by COPY, or by INSERT without copy executor. Its
+// columns have types which are encoded in binary and text for others, which
+// are cast when rows are selected in order of input by serial _row column.
+// Values of rows are kept in plan, variables are taken at execution. Rows of
+// list variable are taken from it at bind, see bulk_load::rows_variable.
+static bool add_bulk_load(query_context &context, const sql::table_mapping &mapping, const std::vector<const field *> &columns,
+                          const std::vector<syntax_node *> &rows, bulk_load &bulk, sql_expr_t &select_rows)
+{
+    std::string table_name = "_bulk" + std::to_string(context.mutations.size() + 1);
+    std::string column_list;
+    bulk.create_sql = "CREATE TEMP TABLE " + table_name + " (_row serial, ";
+    select_rows = select() | from(table(table_name));
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        const std::string &identifier = mapping.column(*columns[i]).identifier;
+        std::string_view sql_type = sql::pg_type_of(columns[i]->field_type.name);
+        bool encoded = sql::copy_type_of(sql_type) != sql::copy_type::Text;
+        std::string_view column_type = encoded ? sql_type : "text";
+        bulk.column_types.emplace_back(column_type);
+        if (i > 0)
+        {
+            bulk.create_sql.append(", ");
+            column_list.append(", ");
+        }
+        bulk.create_sql.append(identifier).append(1, ' ').append(column_type);
+        column_list.append(identifier);
+        sql_expr_t col{sql_expr_type::Column, static_str{identifier}};
+        select_rows |= column_t{encoded || sql_type == "text" ? col : cast(col, static_str{sql_type})};
+    }
+    select_rows = select_rows | order_by(column_t{sql_expr_t{sql_expr_type::Column, static_str{"_row"}}});
+    bulk.create_sql.append(") ON COMMIT DROP");
+    bulk.copy_sql = "COPY " + table_name + " (" + column_list + ") FROM STDIN (FORMAT binary)";
+    bulk.insert_sql = "INSERT INTO " + table_name + " (" + column_list + ") VALUES ";
+
+    bulk.values.reserve(rows.size() * columns.size());
+    for (syntax_node *row : rows)
+    {
+        for (const field *field_decl : columns)
+        {
+            syntax_node *value = object_field_value(row, field_decl->name);
+            bulk_value &res = bulk.values.emplace_back();
+            if (value->of_type(syntax_node_type::Variable))
             {
-                if (!process_field(context, field_decl))
-                    return false;
+                res.value = variable_name(value);
+                res.is_variable = true;
             }
+            else if (value->of_type(syntax_node_type::NullValue))
+                res.is_null = true;
+            else if (value->of_type(syntax_node_type::BoolValue))
+                res.value = value->boolValue ? "true" : "false";
+            else if (value->of_type(syntax_node_type::StringValue | syntax_node_type::EnumValue | syntax_node_type::IntValue | syntax_node_type::FloatValue))
+                res.value = value->content;
+            else
+                return context.report_error("Value '{}' should be a scalar", value->content);
         }
     }
+    return true;
+}
 
-    _query |= from(alias(table(_schema_name, _table_name), current_selection_alias));
+bool sql_query_resolver::add_mutation_statement(query_context &context, std::span<const mutation_call> calls)
+{
+    const mutation_call &call = calls[0];
+    const sql::table_mapping &mapping = *call.type->sql_mapping;
+    sql_str table_name = mapping.table_identifier.empty() ? sql_str{static_str{call.type->name}} : sql_str{static_str{mapping.table_identifier}};
+    sql_expr_t target = table(static_str{mapping.schema_identifier}, table_name);
 
-    context.result = std::move(_query);
+    mutation_statement statement;
+    statement.operation = call.operation;
+    statement.object_name = call.type->name;
+    index_t rows_count = 0;
+    for (const mutation_call &c : calls)
+    {
+        index_t call_rows = c.rows_variable ? 1 : c.operation == InsertOperation ? c.rows.size() : c.keys.empty() ? 1 : c.keys.size();
+        statement.row_fields.insert(statement.row_fields.end(), call_rows, std::string{c.field_node->alias});
+        rows_count += call_rows;
+    }
 
+    sql_expr_t query;
+    if (call.operation == InsertOperation)
+    {
+        // INSERT INTO t (a, b) VALUES (...), (...) RETURNING key, or SELECT of bulk load
+        sql_expr_t columns{sql_expr_type::Row};
+        for (const field *field_decl : call.columns)
+            columns.add_child(sql_expr_type::Column, static_str{mapping.column(*field_decl).identifier});
+        std::vector<syntax_node *> rows;
+        for (const mutation_call &c : calls)
+            rows.insert(rows.end(), c.rows.begin(), c.rows.end());
+        bool bulk = call.rows_variable || (bulk_threshold > 0 && rows.size() >= bulk_threshold) ||
+                    std::any_of(calls.begin(), calls.end(), [](const mutation_call &c)
+                                { return c.field_decl->find_directive(BulkDirective) != nullptr; });
+        sql_expr_t source;
+        if (bulk && !add_bulk_load(context, mapping, call.columns, rows, statement.bulk, source))
+            return false;
+        if (call.rows_variable)
+        {
+            statement.bulk.rows_variable = variable_name(call.rows_variable);
+            for (const field *field_decl : call.columns)
+                statement.bulk.input_fields.push_back(field_decl->name);
+        }
+        if (!bulk)
+        {
+            source = sql_expr_t{sql_expr_type::Values};
+            for (syntax_node *row : rows)
+            {
+                sql_expr_t row_values = source.add_child(sql_expr_type::Row);
+                for (const field *field_decl : call.columns)
+                {
+                    sql_expr_t value;
+                    if (!data_value(context, object_field_value(row, field_decl->name), value))
+                        return false;
+                    row_values.add_child(value);
+                }
+            }
+        }
+        query = sql_expr_t{sql_expr_type::Insert, {}, target};
+        query.add_child(columns);
+        query.add_child(source);
+        if (bulk)
+            query.add_child(on_conflict(mapping, call.columns));
+        query.add_child(returning(call, {}, {}, statement));
+    }
+    else if (rows_count > 1)
+    {
+        // rows are joined to VALUES (ordinal, key, new values...) by key, returned ordinal
+        // tells the call. First row has casts, other rows take types of its columns.
+        std::string alias_name = next_alias_name();
+        std::string values_alias = next_alias_name();
+        const sql::column_mapping &key = mapping.columns[mapping.primary_key[0]];
+        auto values_column = [&values_alias](size_t index)
+        {
+            return column(values_alias, "column" + std::to_string(index + 1));
+        };
+        sql_expr_t values{sql_expr_type::Values};
+        int ordinal = 0;
+        for (const mutation_call &c : calls)
+        {
+            for (size_t r = 0; r < c.keys.size(); r++)
+            {
+                bool first = values.children().empty();
+                sql_expr_t row_values = values.add_child(sql_expr_type::Row);
+                sql_expr_t value{sql_expr_type::NumberLiteral, std::to_string(++ordinal)};
+                row_values.add_child(first ? cast(value, static_str{"integer"}) : value);
+                if (!data_value(context, c.keys[r], value))
+                    return false;
+                row_values.add_child(first ? cast(value, sql::pg_type_of(key.field_decl->field_type.name)) : value);
+                if (c.operation != UpdateOperation)
+                    continue;
+                for (const field *field_decl : call.columns)
+                {
+                    if (!data_value(context, object_field_value(c.rows[r], field_decl->name), value))
+                        return false;
+                    row_values.add_child(first ? cast(value, sql::pg_type_of(field_decl->field_type.name)) : value);
+                }
+            }
+        }
+        query = sql_expr_t{call.operation == UpdateOperation ? sql_expr_type::Update : sql_expr_type::Delete, {}, alias(target, alias_name)};
+        if (call.operation == UpdateOperation)
+        {
+            sql_expr_t set = query.add_child(sql_expr_type::Set);
+            for (size_t i = 0; i < call.columns.size(); i++)
+                set.add_child(binary_operation(sql_expr_t{sql_expr_type::Column, static_str{mapping.column(*call.columns[i]).identifier}}, binary_op::Eq, values_column(i + 2)));
+        }
+        query.add_child(sql_expr_t{call.operation == UpdateOperation ? sql_expr_type::From : sql_expr_type::Using, {}, alias(values, values_alias)});
+        query.add_child(where_clause(binary_operation(column(alias_name, static_str{key.identifier}), binary_op::Eq, values_column(1))));
+        query.add_child(returning(call, alias_name, values_column(0), statement));
+        statement.ordinal_column = true;
+    }
+    else
+    {
+        // single call, rows are found by where, by key or by fields of input object of delete
+        std::string alias_name = next_alias_name();
+        std::vector<sql_expr_t> conditions;
+        if (call.filter && !process_filter(context, mapping, alias_name, *call.type, call.filter, conditions.emplace_back()))
+            return false;
+        if (!call.keys.empty())
+        {
+            sql_expr_t value;
+            if (!data_value(context, call.keys[0], value))
+                return false;
+            conditions.push_back(binary_operation(column(alias_name, static_str{mapping.columns[mapping.primary_key[0]].identifier}), binary_op::Eq, value));
+        }
+        sql_expr_t set{sql_expr_type::Set};
+        for (syntax_node *row : call.rows)
+        {
+            for (const field *field_decl : call.columns)
+            {
+                syntax_node *value_node = object_field_value(row, field_decl->name);
+                std::string_view identifier = mapping.column(*field_decl).identifier;
+                sql_expr_t value;
+                if (!data_value(context, value_node, value))
+                    return false;
+                if (call.operation == UpdateOperation)
+                    set.add_child(binary_operation(sql_expr_t{sql_expr_type::Column, static_str{identifier}}, binary_op::Eq, value));
+                else if (value_node->of_type(syntax_node_type::NullValue))
+                    conditions.push_back(sql_expr_t{sql_expr_type::IsNull, {}, column(alias_name, static_str{identifier})});
+                else
+                    conditions.push_back(binary_operation(column(alias_name, static_str{identifier}), binary_op::Eq, value));
+            }
+        }
+        sql_expr_t condition = combine_conditions(sql_expr_type::And, conditions);
+        // whole table is never changed by mistake
+        if (!condition.node)
+            return context.report_error("Mutation '{}' should have where filter or primary key", call.field_node->name);
+        if (call.operation == UpdateOperation && set.children().empty())
+            return context.report_error("Mutation '{}' has no fields to update", call.field_node->name);
+        query = sql_expr_t{call.operation == UpdateOperation ? sql_expr_type::Update : sql_expr_type::Delete, {}, alias(target, alias_name)};
+        if (call.operation == UpdateOperation)
+            query.add_child(set);
+        query.add_child(where_clause(condition));
+        query.add_child(returning(call, alias_name, {}, statement));
+    }
+    context.mutations.push_back(std::move(statement));
+    context.mutation_queries.push_back(query);
     return true;
 }
 
-bool sql_query_resolver::process_mutation(query_context &)
+// Mutation fields run in order in one transaction. Adjacent calls of the same
+// field are one statement, so bulk mutation costs one statement.
+bool sql_query_resolver::process_mutation(query_context &context)
 {
+    auto mutation_type = context.schema->get_mutation_type();
+    if (!mutation_type)
+        return context.report_error("Mutation type is not defined in schema");
+
+    arena_scope scope{context.arena};
+    std::vector<mutation_call> calls;
+    for (syntax_node *field_node : _operation->selection_set->children)
+    {
+        auto field_decl = mutation_type->find_field(field_node->name_symbol, {field_node->name, field_node->name_hash_code});
+        if (field_decl == nullptr)
+            return context.report_error("Field '{}' is not declared in type '{}'", field_node->name, mutation_type->name);
+        mutation_call &call = calls.emplace_back();
+        call.field_decl = field_decl;
+        if (!parse_mutation_call(context, field_node, call))
+            return false;
+    }
+    for (size_t first = 0; first < calls.size();)
+    {
+        size_t last = first + 1;
+        while (last < calls.size() && can_merge(calls[first], calls[last]))
+            last++;
+        if (!add_mutation_statement(context, std::span<const mutation_call>(calls).subspan(first, last - first)))
+            return false;
+        first = last;
+    }
     return true;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <parser/tokenizer.hpp>
+#include <util/name_table.hpp>
 
 using namespace blitz_query_cpp;
 
@@ -126,7 +127,9 @@ token_t tokenizer_t::handle_dot()
 token_t tokenizer_t::read_name(index_t skipChars, token_type type)
 {
     index_t start_pos = current_pos;
-    current_pos += skipChars;
+    uint64_t hash = NameHashInit;
+    for (index_t i = 0; i < skipChars; i++)
+        hash = name_hash_update(hash, query[current_pos++]);
     if (current_pos < query.size())
     {
         char ch = query[current_pos];
@@ -134,6 +137,7 @@ token_t tokenizer_t::read_name(index_t skipChars, token_type type)
         {
             return token_t(query.substr(current_pos, 1), current_pos, 1, token_type::InvalidToken);
         }
+        hash = name_hash_update(hash, ch);
         current_pos++;
     }
 
@@ -144,10 +148,15 @@ token_t tokenizer_t::read_name(index_t skipChars, token_type type)
         {
             break;
         }
+        hash = name_hash_update(hash, ch);
         current_pos++;
     }
     index_t len = current_pos - start_pos;
-    return token_t(query.substr(start_pos, len), start_pos, len, type);
+    token_t token(query.substr(start_pos, len), start_pos, len, type);
+    token.hash = hash;
+    if (type != token_type::ParameterLiteral)
+        token.symbol = names->find(token.value, hash);
+    return token;
 }
 
 token_t tokenizer_t::read_comment()
@@ -0,0 +1,99 @@
+#include <type_system/schema.hpp>
+#include <type_system/schema_parser.hpp>
+#include <parser/parser.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace blitz_query_cpp;
+
+// Compiles synthetic schema with 10k object types using different number of threads.
+
+constexpr int TypesCount = 10000;
+constexpr int FieldsPerType = 12;
+constexpr int Iterations = 5;
+
+std::string generate_schema()
+{
+    std::string scm = "schema { query: T0 }\n"
+                      "directive @table(table: String schema: String) on OBJECT\n"
+                      "directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION\n"
+                      "scalar Int\nscalar String\nscalar Boolean\n";
+    for (int i = 0; i < TypesCount; i++)
+    {
+        scm += "type T" + std::to_string(i) + " @table(table: \"t" + std::to_string(i) + "\" schema: \"bench\") {\n";
+        for (int f = 0; f < FieldsPerType; f++)
+        {
+            std::string name = "f" + std::to_string(f);
+            switch (f % 4)
+            {
+            case 0:
+                scm += "  " + name + ": Int @column(name: \"" + name + "\" IsPK: True)\n";
+                break;
+            case 1:
+                scm += "  " + name + ": String @column(name: \"" + name + "\")\n";
+                break;
+            case 2:
+                scm += "  " + name + "(skip: Int take: Int): [T" + std::to_string((i * 7 + f) % TypesCount) + "!]\n";
+                break;
+            default:
+                scm += "  " + name + ": T" + std::to_string((i + f) % TypesCount) + "\n";
+                break;
+            }
+        }
+        scm += "}\n";
+    }
+    return scm;
+}
+
+int main()
+{
+    document_t doc{generate_schema()};
+    parser_t parser{doc};
+    if (!parser.parse())
+    {
+        std::cerr << "Failed to parse schema: " << parser.get_error_msg() << std::endl;
+        return 1;
+    }
+
+    schema_t schema;
+    if (!schema_parser_t{}.process_doc(schema, doc))
+    {
+        std::cerr << "Failed to process schema" << std::endl;
+        return 1;
+    }
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    double serial_time = 0;
+    std::cout << "types: " << schema.types.size() << ", fields per type: " << FieldsPerType << std::endl;
+    std::cout << "threads\tbest ms\tspeedup" << std::endl;
+    // powers of two below hardware concurrency followed by hardware concurrency itself
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2)
+        thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+    for (unsigned threads : thread_counts)
+    {
+        schema_parser_t schema_parser{schema_compile_options{.threads = threads}};
+        double best = 0;
+        for (int i = 0; i < Iterations; i++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            if (!schema_parser.compile(schema))
+            {
+                std::cerr << "Failed to compile schema: " << schema_parser.get_error_msg() << std::endl;
+                return 1;
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 || elapsed.count() < best)
+                best = elapsed.count();
+        }
+        if (threads == 1)
+            serial_time = best;
+        std::cout << threads << "\t" << best << "\t" << serial_time / best << std::endl;
+    }
+    return 0;
+}
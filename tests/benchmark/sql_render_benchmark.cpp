@@ -0,0 +1,478 @@
+#include <data/sql/sql_expr.hpp>
+#include <data/sql/postgresql_renderer.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <ranges>
+#include <string>
+#include <vector>
+
+using namespace blitz_query_cpp;
+using namespace blitz_query_cpp::sql;
+
+// Compares recursive renderer with the former stack based one on queries like
+// produced by sql_query_resolver.
+
+constexpr int Iterations = 200000;
+
+namespace blitz_query_cpp::sql
+{
+    bool pg_need_to_qoute(std::string_view value);
+}
+
+// former renderer, kept as baseline
+struct expr_node
+{
+    expr_node(const sql_node *exp, std::string_view val = {})
+        : expr{exp}, value{val}
+    {
+    }
+
+    const sql_node *expr;
+    const std::string value;
+};
+
+class stack_renderer
+{
+    std::vector<expr_node> node_stack;
+    std::string buffer;
+    bool handle_binary_op(expr_node &current, std::string_view op);
+    bool handle_join(expr_node &current, std::string_view join_type);
+    void visit_children(expr_node &node, std::string_view separator = {}, std::string_view end = {});
+    void visit_clauses(expr_node &node);
+    void write_quoted_value(expr_node &node);
+    void push_value(std::string_view value);
+    void push_node(const sql_node *node);
+
+public:
+    bool render(const sql_expr_t &expr);
+    const std::string &get_string() const { return buffer; }
+};
+
+void stack_renderer::visit_children(expr_node &node, std::string_view separator, std::string_view end)
+{
+    bool last = true;
+    for (const sql_node *child : std::ranges::reverse_view(node.expr->get_children()))
+    {
+        if (last)
+        {
+            if (!end.empty())
+                node_stack.emplace_back(nullptr, end);
+        }
+        else
+        {
+            if (!separator.empty())
+                node_stack.emplace_back(nullptr, separator);
+        }
+        node_stack.emplace_back(child);
+        last = false;
+    }
+}
+
+void stack_renderer::push_value(std::string_view value)
+{
+    node_stack.emplace_back(nullptr, value);
+}
+
+void stack_renderer::push_node(const sql_node *node)
+{
+    node_stack.emplace_back(node);
+}
+
+void stack_renderer::visit_clauses(expr_node &node)
+{
+    if (!node.expr->clauses)
+        return visit_children(node);
+    for (int c = int(select_clause::Count) - 1; c >= 0; c--)
+    {
+        const sql_node *clause = node.expr->clauses[c];
+        if (!clause)
+            continue;
+        if (c == int(select_clause::Joins))
+        {
+            expr_node joins{clause};
+            visit_children(joins);
+        }
+        else
+            push_node(clause);
+    }
+}
+
+bool stack_renderer::handle_binary_op(expr_node &current, std::string_view op)
+{
+    if (current.expr->children_count < 2)
+        return false;
+    bool need_paren = current.expr->children[0]->children_count > 0 || current.expr->children[1]->children_count > 0;
+    if (need_paren)
+        push_value(")");
+    push_node(current.expr->children[1]);
+    push_value(op);
+    push_node(current.expr->children[0]);
+    if (need_paren)
+        buffer.append(1, '(');
+
+    return true;
+}
+
+bool stack_renderer::handle_join(expr_node &current, std::string_view join_type)
+{
+    buffer.append(join_type);
+    visit_children(current);
+    return true;
+}
+
+
+void stack_renderer::write_quoted_value(expr_node &current)
+{
+    bool quote = pg_need_to_qoute(current.expr->value);
+    if (quote)
+        buffer.append(1, '"');
+    buffer.append(current.expr->value);
+    if (quote)
+        buffer.append(1, '"');
+}
+
+bool stack_renderer::render(const sql_expr_t &expr)
+{
+    buffer.clear();
+    if (!expr.node)
+        return false;
+    push_node(expr.node);
+
+    while (!node_stack.empty())
+    {
+        expr_node current = node_stack.back();
+        node_stack.pop_back();
+        if (current.expr == nullptr)
+        {
+            buffer.append(current.value);
+            continue;
+        }
+
+        switch (current.expr->type)
+        {
+        case sql_expr_type::Column:
+            write_quoted_value(current);
+            break;
+        case sql_expr_type::TableName:
+            write_quoted_value(current);
+            // write column ref if any
+            if (current.expr->children_count > 0)
+            {
+                buffer.append(1, '.');
+                push_node(current.expr->children[0]);
+            }
+            break;
+        case sql_expr_type::SchemaName:
+        {
+            bool quote = pg_need_to_qoute(current.expr->value);
+            if (quote)
+                buffer.append(1, '"');
+            buffer.append(current.expr->value);
+            if (quote)
+                buffer.append(1, '"');
+            buffer.append(1, '.');
+            if (current.expr->children_count == 0)
+                return false;
+            push_node(current.expr->children[0]);
+        }
+        break;
+        case sql_expr_type::Function:
+            buffer.append(current.expr->value);
+            buffer.append(1, '(');
+            visit_children(current, ", ", ")");
+            break;
+        case sql_expr_type::StringLiteral:
+            buffer.append(1, '\'');
+            buffer.append(current.expr->value);
+            buffer.append(1, '\'');
+            break;
+        case sql_expr_type::NumberLiteral:
+            buffer.append(current.expr->value);
+            break;
+        case sql_expr_type::Parameter:
+            buffer.append(1, '$');
+            buffer.append(current.expr->value);
+            break;
+        case sql_expr_type::Asias:
+        {
+            std::string alias;
+            alias.reserve(current.expr->value.size() + 8);
+            if (current.expr->children_count > 1)
+            {
+                alias.append(")");
+                buffer.append("(");
+            }
+            alias.append(" as ");
+            bool quote = pg_need_to_qoute(current.expr->value);
+            if (quote)
+                alias.append(1, '"');
+            alias.append(current.expr->value);
+            if (quote)
+                alias.append(1, '"');
+            visit_children(current, ", ", alias);
+        }
+        break;
+        case sql_expr_type::Plus:
+            if (!handle_binary_op(current, " + "))
+                return false;
+            break;
+        case sql_expr_type::Minus:
+            if (!handle_binary_op(current, " - "))
+                return false;
+            break;
+        case sql_expr_type::Multiply:
+            if (!handle_binary_op(current, " * "))
+                return false;
+            break;
+        case sql_expr_type::Divide:
+            if (!handle_binary_op(current, " / "))
+                return false;
+            break;
+        case sql_expr_type::And:
+            if (!handle_binary_op(current, " AND "))
+                return false;
+            break;
+        case sql_expr_type::Or:
+            if (!handle_binary_op(current, " OR "))
+                return false;
+            break;
+        case sql_expr_type::Eq: // =
+            if (!handle_binary_op(current, " = "))
+                return false;
+            break;
+        case sql_expr_type::Ne: // <>
+            if (!handle_binary_op(current, " <> "))
+                return false;
+            break;
+        case sql_expr_type::Le: // <
+            if (!handle_binary_op(current, " < "))
+                return false;
+            break;
+        case sql_expr_type::Gt: // >
+            if (!handle_binary_op(current, " > "))
+                return false;
+            break;
+        case sql_expr_type::Lq: // <=
+            if (!handle_binary_op(current, " <= "))
+                return false;
+            break;
+        case sql_expr_type::Gq: // >=
+            if (!handle_binary_op(current, " >= "))
+                return false;
+            break;
+        case sql_expr_type::Like:
+            if (!handle_binary_op(current, " LIKE "))
+                return false;
+            break;
+
+        case sql_expr_type::Select:
+            buffer.append("SELECT ");
+            visit_clauses(current);
+            break;
+        case sql_expr_type::SelectDistinct:
+            buffer.append("SELECT DISTINCT ");
+            visit_clauses(current);
+            break;
+        case sql_expr_type::From:
+            buffer.append(" FROM ");
+            if (current.expr->children_count == 0)
+            {
+                buffer.append(1, '"');
+                buffer.append(current.expr->value);
+                buffer.append(1, '"');
+            }
+            else
+            {
+                std::string_view end, sep = ", ";
+                if (current.expr->children[0]->type == sql_expr_type::Select || current.expr->children[0]->type == sql_expr_type::SelectDistinct)
+                {
+                    buffer.append(1, '(');
+                    end = ")";
+                    sep = "), (";
+                }
+                visit_children(current, sep, end);
+            }
+            break;
+        case sql_expr_type::Insert:
+            break;
+        case sql_expr_type::Update:
+            break;
+        case sql_expr_type::Delete:
+            break;
+        case sql_expr_type::SelectColumns:
+            visit_children(current, ", ");
+            break;
+        case sql_expr_type::Where:
+            buffer.append(" WHERE ");
+            visit_children(current, " AND ");
+            break;
+        case sql_expr_type::Having:
+            visit_children(current, " AND ");
+            break;
+        case sql_expr_type::Group:
+            buffer.append(" GROUP BY ");
+            visit_children(current, ", ");
+            break;
+        case sql_expr_type::Order:
+            buffer.append(" ORDER BY ");
+            visit_children(current, ", ");
+            break;
+        case sql_expr_type::InnerJoin:
+            if (!handle_join(current, " INNER JOIN "))
+                return false;
+            break;
+        case sql_expr_type::LeftJoin:
+            if (!handle_join(current, " LEFT JOIN "))
+                return false;
+            break;
+        case sql_expr_type::RightJoin:
+            if (!handle_join(current, " RIGHT JOIN "))
+                return false;
+            break;
+        case sql_expr_type::OuterJoin:
+            if (!handle_join(current, " FULL OUTER JOIN "))
+                return false;
+            break;
+        case sql_expr_type::On:
+            if (current.expr->children_count != 2)
+                return false;
+            buffer.append(" ON ");
+            push_node(current.expr->children[1]);
+            push_value(" = ");
+            push_node(current.expr->children[0]);
+            break;
+        case sql_expr_type::Values:
+            break;
+        case sql_expr_type::All:
+            break;
+        case sql_expr_type::Any:
+            break;
+        case sql_expr_type::Beetween:
+            buffer.append("BEETWEEN ");
+            if (current.expr->children_count != 2)
+                return false;
+            visit_children(current, " AND ");
+            break;
+        case sql_expr_type::Exists:
+            buffer.append("EXISTS(");
+            if (current.expr->children_count != 1)
+                return false;
+            visit_children(current, "", ") ");
+            break;
+        case sql_expr_type::In:
+            buffer.append("IN( ");
+            visit_children(current, ", ", ") ");
+            break;
+        case sql_expr_type::IsNull:
+            buffer.append(" IS NULL");
+            break;
+        case sql_expr_type::IsNotNull:
+            buffer.append(" NOT IS NULL");
+            break;
+        case sql_expr_type::Limit:
+            buffer.append(" LIMIT ");
+            buffer.append(current.expr->value);
+            break;
+        case sql_expr_type::Asc:
+            if (current.expr->children_count == 0)
+            {
+                buffer.append(1, '"');
+                buffer.append(current.expr->value);
+                buffer.append(1, '"');
+                buffer.append(" ASC");
+            }
+            else
+            {
+                push_value(" ASC");
+                visit_children(current);
+            }
+            break;
+        case sql_expr_type::Desc:
+            if (current.expr->children_count == 0)
+            {
+                buffer.append(1, '"');
+                buffer.append(current.expr->value);
+                buffer.append(1, '"');
+                buffer.append(" DESC");
+            }
+            else
+            {
+                push_value(" DESC");
+                visit_children(current);
+            }
+            break;
+        case sql_expr_type::Not:
+            buffer.append(" NOT ");
+            if (current.expr->children_count != 1)
+                return false;
+            push_node(current.expr->children[0]);
+            break;
+        case sql_expr_type::Set:
+            break;
+        case sql_expr_type::Union:
+            break;
+        case sql_expr_type::UnionAll:
+            break;
+        case sql_expr_type::Offset:
+            buffer.append(" OFFSET ");
+            buffer.append(current.expr->value);
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+sql_expr_t make_query()
+{
+    static const char *columns[] = {"id", "name", "age", "email", "created_at", "updated_at", "AccountId", "status", "role", "city", "country", "zip"};
+    auto query = select();
+    for (const char *col : columns)
+        query |= column("_a1", static_str{col});
+    query |= from(alias(table("test", "user"), "_a1"));
+    query = query | where(binary_operation("age", binary_op::Gt, 18)) | or_else(binary_operation("name", binary_op::Like, "M%")) |
+            join(alias(table("test", "account"), "_a2"), join_kind::LeftJoin, column("_a1", "AccountId"), column("_a2", "id")) |
+            order_by(column("_a1", "name"), false) | offset(10) | limit(20);
+    return query;
+}
+
+template <class Renderer>
+double run(const sql_expr_t &query, std::string &result)
+{
+    Renderer renderer;
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; i++)
+    {
+        renderer.render(query);
+        total += renderer.get_string().size();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    result = renderer.get_string();
+    return total ? elapsed.count() / Iterations : 0;
+}
+
+int main()
+{
+    arena_t arena;
+    arena_scope scope{arena};
+    sql_expr_t query = make_query();
+
+    std::string stack_result, recursive_result;
+    double stack_ns = run<stack_renderer>(query, stack_result);
+    double recursive_ns = run<postgresql_renderer>(query, recursive_result);
+    if (stack_result != recursive_result)
+    {
+        std::cerr << "Renderers output differs:\n"
+                  << stack_result << "\n"
+                  << recursive_result << std::endl;
+        return 1;
+    }
+    std::cout << "query length: " << recursive_result.size() << std::endl;
+    std::cout << "renderer\tns per query\tspeedup" << std::endl;
+    std::cout << "stack\t" << stack_ns << "\t1" << std::endl;
+    std::cout << "recursive\t" << recursive_ns << "\t" << stack_ns / recursive_ns << std::endl;
+    return 0;
+}
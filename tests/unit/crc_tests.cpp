@@ -1,4 +1,5 @@
 #include <util/crc_hash.hpp>
+#include <util/name_hash.hpp>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -12,4 +13,12 @@ TEST(Hash, Crc32)
 
     res = hash_crc32(Crc32WithTable::CheckMessage());
     EXPECT_EQ(res, Crc32WithTable::Check);
-}
\ No newline at end of file
+}
+
+TEST(Hash, NameHash)
+{
+    // FNV-1a 64 reference values
+    EXPECT_EQ(hash_name(""), 0xcbf29ce484222325ull);
+    EXPECT_EQ(hash_name("a"), 0xaf63dc4c8601ec8cull);
+    EXPECT_EQ("foobar"_name_hash, 0x85944171f73967e8ull);
+}
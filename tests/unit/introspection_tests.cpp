@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <type_system/schema.hpp>
+#include <type_system/schema_parser.hpp>
+#include <type_system/builtin_types.hpp>
+#include <processing/introspection_resolver.hpp>
+#include <processing/parse_document.hpp>
+#include <parser/document_signature.hpp>
+#include <string>
+
+using namespace blitz_query_cpp;
+
+TEST(Introspection, DocumentSignature)
+{
+   uint64_t signature = document_signature("query Foo { users { id name } }");
+   EXPECT_NE(signature, 0u);
+   EXPECT_EQ(signature, document_signature("query Bar {\n  users {\n    id,\n    name # comment\n  }\n}"));
+   EXPECT_NE(signature, document_signature("query Foo { users { id } }"));
+   EXPECT_NE(signature, document_signature("query Foo { usersid name }"));
+   EXPECT_NE(signature, document_signature("mutation Foo { users { id name } }"));
+}
+
+TEST(Introspection, CachedResponse)
+{
+   std::string scm = R""""(
+        schema { query: Query }
+        type Query
+        {
+           Users(take: Int = 10): [User!]!
+        }
+        "User of the system"
+        type User
+        {
+           Id: Int!
+           Name: String @deprecated
+           Role: Role
+        }
+        enum Role { ADMIN GUEST }
+        )"""";
+
+   schema_t my_schema;
+   ASSERT_TRUE(add_introspection_types(my_schema));
+   schema_parser_t parser;
+   ASSERT_TRUE(parser.parse(my_schema, scm));
+
+   introspection_cache cache;
+   introspection_resolver resolver{cache};
+   parse_document doc_parser;
+
+   query_context context(&my_schema, "# sent by IDE\n" + introspection_query({}));
+   EXPECT_TRUE(resolver.process(context));
+   EXPECT_TRUE(doc_parser.process(context));
+   ASSERT_TRUE(context.has_response());
+   const std::string &response = std::get<json_response>(context.result).data;
+   EXPECT_TRUE(response.starts_with(R"({"data":{"__schema":{"queryType":{"name":"Query"},"mutationType":null,"subscriptionType":null,"types":[)"));
+   EXPECT_THAT(response, testing::HasSubstr(R"({"kind":"OBJECT","name":"User","description":"User of the system","fields":[{"name":"Id","description":null,"args":[],"type":{"kind":"NON_NULL","name":null,"ofType":{"kind":"SCALAR","name":"Int","ofType":null}},"isDeprecated":false,"deprecationReason":null},{"name":"Name","description":null,"args":[],"type":{"kind":"SCALAR","name":"String","ofType":null},"isDeprecated":true,"deprecationReason":"No longer supported"})"));
+   EXPECT_THAT(response, testing::HasSubstr(R"("args":[{"name":"take","description":null,"type":{"kind":"SCALAR","name":"Int","ofType":null},"defaultValue":"10"}],"type":{"kind":"NON_NULL","name":null,"ofType":{"kind":"LIST","name":null,"ofType":{"kind":"NON_NULL","name":null,"ofType":{"kind":"OBJECT","name":"User","ofType":null}}}})"));
+   EXPECT_THAT(response, testing::HasSubstr(R"("enumValues":[{"name":"ADMIN","description":null,"isDeprecated":false,"deprecationReason":null},{"name":"GUEST")"));
+   EXPECT_THAT(response, testing::HasSubstr(R"({"name":"skip","description":null,"locations":["FIELD","FRAGMENT_SPREAD","INLINE_FRAGMENT"],"args":[)"));
+
+   // same schema version is served from cache
+   EXPECT_EQ(cache.get_response(my_schema, {}), cache.get_response(my_schema, {}));
+   auto old_response = cache.get_response(my_schema, {});
+   ASSERT_TRUE(parser.extend(my_schema, "extend type User { Age: Int }"));
+   auto new_response = cache.get_response(my_schema, {});
+   EXPECT_NE(old_response, new_response);
+   EXPECT_THAT(*new_response, testing::HasSubstr(R"("name":"Age")"));
+
+   query_context regular_query(&my_schema, "{ Users { Id } }");
+   EXPECT_TRUE(resolver.process(regular_query));
+   EXPECT_FALSE(regular_query.has_response());
+}
+
+TEST(Introspection, OptionVariants)
+{
+   std::string scm = R""""(
+        schema { query: Query }
+        type Query
+        {
+           Users(take: Int, limit: Int @deprecated(reason: "use take")): [User]
+        }
+        type User { Id: Int }
+        )"""";
+
+   schema_t my_schema;
+   ASSERT_TRUE(add_introspection_types(my_schema));
+   schema_parser_t parser;
+   ASSERT_TRUE(parser.parse(my_schema, scm));
+
+   introspection_cache cache;
+   for (unsigned key = 0; key < introspection_options::VariantsCount; key++)
+   {
+      auto options = cache.find_query(introspection_query(introspection_options::of_key(key)));
+      ASSERT_TRUE(options.has_value());
+      EXPECT_EQ(options->key(), key);
+   }
+   EXPECT_FALSE(cache.find_query("{ __schema { types { name } } }").has_value());
+
+   auto response = cache.get_response(my_schema, {});
+   EXPECT_THAT(*response, testing::HasSubstr(R"("args":[{"name":"take")"));
+   EXPECT_THAT(*response, testing::Not(testing::HasSubstr(R"("name":"limit")")));
+
+   introspection_options deprecation;
+   deprecation.input_value_deprecation = true;
+   response = cache.get_response(my_schema, deprecation);
+   EXPECT_THAT(*response, testing::HasSubstr(R"({"name":"limit","description":null,"type":{"kind":"SCALAR","name":"Int","ofType":null},"defaultValue":null,"isDeprecated":true,"deprecationReason":"use take"})"));
+}
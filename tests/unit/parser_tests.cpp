@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "parser/parser.hpp"
+#include "util/name_table.hpp"
 #include <format>
 
 using namespace blitz_query_cpp;
@@ -93,6 +94,36 @@ TEST(Parser_t, ParseField)
   ASSERT_EQ(doc.children[0]->selection_set->children.size(), 2u);
 }
 
+TEST(Parser_t, FieldNameSymbols)
+{
+  // interned names are visible to readers once the table is frozen; global
+  // table may already have any name, so it is checked on a table of its own
+  name_table names;
+  symbol_t own = names.intern("@include");
+  EXPECT_EQ(names.find("@include"), NoSymbol);
+  names.freeze();
+  EXPECT_EQ(names.find("@include"), own);
+
+  symbol_t picture = name_table::global().intern("picture");
+  symbol_t include = name_table::global().intern("@include");
+  name_table::global().freeze();
+  EXPECT_EQ(name_table::global().find("@include"), include);
+  document_t doc("my_pic : picture @include(if:$foo) not_interned_field_name");
+  doc.all_nodes.reserve(20);
+  parser_t parser(doc);
+  EXPECT_TRUE(parser.parse_field());
+  EXPECT_TRUE(parser.parse_field());
+  ASSERT_EQ(doc.children.size(), 2u);
+  EXPECT_EQ(doc.children[0]->name, "picture");
+  EXPECT_EQ(doc.children[0]->alias, "my_pic");
+  EXPECT_EQ(doc.children[0]->name_symbol, picture);
+  EXPECT_EQ(doc.children[0]->name_hash_code, hash_name("picture"));
+  ASSERT_EQ(doc.children[0]->directives.size(), 1u);
+  EXPECT_EQ(doc.children[0]->directives[0]->name_symbol, include);
+  EXPECT_EQ(doc.children[1]->name_symbol, NoSymbol);
+  EXPECT_EQ(doc.children[1]->name_hash_code, hash_name("not_interned_field_name"));
+}
+
 TEST(Parser_t, ShortQuery)
 {
   document_t doc("{file(skip:0,take:10){items{name Id}totalCount}}");
@@ -4,6 +4,7 @@
 #include <type_system/schema.hpp>
 #include <type_system/schema_parser.hpp>
 #include <type_system/builtin_types.hpp>
+#include <type_system/schema_registry.hpp>
 
 #include <filesystem>
 #include <fstream>
@@ -225,6 +226,25 @@ TEST(Schema, SchemaIntrospectionTypes)
    schema_t my_schema;
    bool res = add_introspection_types(my_schema);
    ASSERT_EQ(res, true);
+
+   const object_type *schema_type = my_schema.find_type("__Schema");
+   ASSERT_NE(schema_type, nullptr);
+   auto types_field = schema_type->fields.find("types");
+   ASSERT_NE(types_field, schema_type->fields.end());
+   EXPECT_EQ(types_field->field_type.type, my_schema.find_type("__Type"));
+   EXPECT_EQ(types_field->field_type_nullability, 0u);
+   EXPECT_EQ(types_field->list_nesting_depth, 1);
+   EXPECT_NE(my_schema.find_directive_type("@deprecated"), nullptr);
+
+   // built-in types are shared, not copied
+   schema_t other_schema;
+   ASSERT_TRUE(add_introspection_types(other_schema));
+   EXPECT_EQ(other_schema.find_type("__Schema"), schema_type);
+   EXPECT_TRUE(my_schema.types.empty());
+
+   schema_parser_t parser;
+   ASSERT_TRUE(parser.parse(my_schema, "type Query { Name: String }"));
+   EXPECT_EQ(my_schema.find_type("Query")->fields.find("Name")->field_type.type, my_schema.find_type("String"));
 }
 
 
@@ -237,4 +257,149 @@ TEST(Schema, ParseObjectExt)
    EXPECT_EQ(parser.get_error_msg(), "");
    ASSERT_EQ(res, true);
 
-}
\ No newline at end of file
+}
+TEST(Schema, ExtendIncremental)
+{
+   std::string scm = "schema { query: Query } type Query { foo: Foo bar: Bar } type Foo { id: Int } type Bar { name: String }";
+   schema_t my_schema;
+   schema_parser_t parser;
+   ASSERT_EQ(parser.parse(my_schema, scm), true);
+   EXPECT_EQ(my_schema.type_dependents["Foo"].contains("Query"), true);
+
+   bool res = parser.extend(my_schema, "extend type Foo { bar: Bar }");
+   EXPECT_EQ(parser.get_error_msg(), "");
+   ASSERT_EQ(res, true);
+
+   const object_type *foo = my_schema.find_type("Foo");
+   ASSERT_NE(foo, nullptr);
+   EXPECT_EQ(foo->fields.size(), 2u);
+   EXPECT_EQ(foo->fields.find("bar")->field_type.type, my_schema.find_type("Bar"));
+   EXPECT_EQ(my_schema.type_dependents["Bar"].contains("Foo"), true);
+
+   // dependent type is resolved to extended type instance
+   ASSERT_NE(my_schema.get_query_type(), nullptr);
+   EXPECT_EQ(my_schema.get_query_type()->fields.find("foo")->field_type.type, foo);
+}
+
+TEST(Schema, ParallelCompile)
+{
+   std::string scm = readFile("test_data/schema.graphql");
+   schema_t serial_schema;
+   schema_parser_t serial_parser;
+   ASSERT_EQ(serial_parser.parse(serial_schema, scm), true);
+
+   schema_t parallel_schema;
+   schema_parser_t parallel_parser{schema_compile_options{.threads = 4, .grain_size = 1}};
+   ASSERT_EQ(parallel_parser.parse(parallel_schema, scm), true);
+
+   ASSERT_EQ(parallel_schema.types.size(), serial_schema.types.size());
+   EXPECT_EQ(parallel_schema.type_dependents, serial_schema.type_dependents);
+   for (auto &type : serial_schema.types)
+   {
+      const object_type *parallel_type = parallel_schema.find_type(type.name);
+      ASSERT_NE(parallel_type, nullptr);
+      for (auto &fld : type.fields)
+      {
+         auto parallel_field = parallel_type->fields.find(fld.name);
+         ASSERT_NE(parallel_field, parallel_type->fields.end());
+         EXPECT_EQ(parallel_field->declaring_type.type, parallel_type);
+         ASSERT_EQ(parallel_field->field_type.type != nullptr, fld.field_type.type != nullptr);
+         if (fld.field_type.type)
+         {
+            EXPECT_EQ(parallel_field->field_type.type, parallel_schema.find_type(fld.field_type.type->name));
+         }
+      }
+   }
+
+   // field of undefined type does not fail compile, it is left unresolved
+   schema_t partial_schema;
+   ASSERT_EQ(parallel_parser.parse(partial_schema, "schema { query: Query } type Query { foo: Missing bar: Int } scalar Int"), true);
+   EXPECT_EQ(partial_schema.get_query_type()->fields.find("foo")->field_type.type, nullptr);
+}
+
+TEST(Schema, DirectiveParameterValues)
+{
+   std::string scm = "scalar UUID @foo(url: \"https://tools.ietf.org\" obj: {bar: 1 baz: false} list: [1.5 2.5] kind: BAR nothing: null)";
+   schema_t my_schema;
+   schema_parser_t parser;
+   bool res = parser.parse(my_schema, scm);
+   EXPECT_EQ(parser.get_error_msg(), "");
+   ASSERT_EQ(res, true);
+   auto &params = my_schema.types.begin()->directives[0].parameters;
+   ASSERT_EQ(params.size(), 5u);
+
+   auto url = params.find("url");
+   ASSERT_NE(url, params.end());
+   EXPECT_EQ(url->value.value_type, value_kind::String);
+   EXPECT_EQ(url->value.string_value(), "https://tools.ietf.org");
+
+   auto obj = params.find("obj");
+   ASSERT_NE(obj, params.end());
+   EXPECT_EQ(obj->value.value_type, value_kind::Object);
+   ASSERT_EQ(obj->value.fields().size(), 2u);
+   EXPECT_EQ(obj->value.fields().find("bar")->value.int_value, 1);
+   EXPECT_EQ(obj->value.fields().find("baz")->value.bool_value, false);
+
+   auto list = params.find("list");
+   ASSERT_NE(list, params.end());
+   EXPECT_EQ(list->value.value_type, value_kind::List);
+   ASSERT_EQ(list->value.fields().size(), 2u);
+   EXPECT_EQ(list->value.fields()[1].value.float_value, 2.5);
+
+   EXPECT_EQ(params.find("kind")->value.string_value(), "BAR");
+   EXPECT_EQ(params.find("nothing")->value.value_type, value_kind::Null);
+}
+
+TEST(Schema, RegistryStructuralSharing)
+{
+   std::string scm = R""""(
+        schema { query: Query }
+        type Query { Users: [User] Orders: [Order] }
+        type User { Id: Int Name: String Address: Address }
+        type Address { City: String }
+        type Order { Id: Int }
+        )"""";
+
+   schema_registry registry;
+   ASSERT_TRUE(registry.add_schema("base", scm));
+   ASSERT_TRUE(registry.add_schema("tenant_a", "base", "extend type User { Age: Int }"));
+   ASSERT_TRUE(registry.add_schema("tenant_b", "base", ""));
+   EXPECT_FALSE(registry.add_schema("tenant_c", "missing", ""));
+   EXPECT_EQ(registry.size(), 3u);
+
+   auto base = registry.find("base");
+   auto tenant_a = registry.find("tenant_a");
+   auto tenant_b = registry.find("tenant_b");
+   ASSERT_TRUE(base && tenant_a && tenant_b);
+
+   // extended type and types referencing it are copied, other types are shared
+   EXPECT_EQ(tenant_a->types.size(), 2u);
+   const object_type *user = tenant_a->find_type("User");
+   ASSERT_NE(user, nullptr);
+   EXPECT_TRUE(user->fields.contains("Age"));
+   EXPECT_FALSE(base->find_type("User")->fields.contains("Age"));
+   EXPECT_EQ(tenant_a->get_query_type()->fields.find("Users")->field_type.type, user);
+   EXPECT_EQ(tenant_a->find_type("Order"), base->find_type("Order"));
+   EXPECT_EQ(tenant_a->find_type("Int"), base->find_type("Int"));
+
+   EXPECT_TRUE(tenant_b->types.empty());
+   EXPECT_EQ(tenant_b->get_query_type(), base->get_query_type());
+
+   // only direct owners of extended type are copied, shared types reach it through current_type
+   ASSERT_TRUE(registry.add_schema("tenant_d", "base", "extend type Address { Zip: String }"));
+   auto tenant_d = registry.find("tenant_d");
+   ASSERT_TRUE(tenant_d);
+   EXPECT_EQ(tenant_d->types.size(), 2u);
+   EXPECT_EQ(tenant_d->get_query_type(), base->get_query_type());
+   const object_type *shared_user = tenant_d->get_query_type()->fields.find("Users")->field_type.type;
+   const object_type *copied_user = tenant_d->current_type(shared_user);
+   ASSERT_NE(copied_user, shared_user);
+   const object_type *address = copied_user->fields.find("Address")->field_type.type;
+   EXPECT_EQ(address, tenant_d->find_type("Address"));
+   EXPECT_TRUE(address->fields.contains("Zip"));
+   EXPECT_EQ(tenant_d->current_type(base->find_type("Order")), base->find_type("Order"));
+
+   EXPECT_TRUE(registry.remove_schema("base"));
+   EXPECT_EQ(registry.find("base"), nullptr);
+   EXPECT_EQ(tenant_a->base, base);
+}
@@ -5,10 +5,51 @@
 #include <processing/sql_query_resolver.hpp>
 #include <processing/parse_document.hpp>
 #include <data/sql/postgresql_renderer.hpp>
+#include <processing/query_plan_cache.hpp>
+#include <processing/batch_loader.hpp>
+#include <processing/micro_batcher.hpp>
+#include <processing/single_flight.hpp>
+#include <processing/mutation_executor.hpp>
+#include <util/cursor.hpp>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
 #include <string>
+#include <thread>
 
 using namespace blitz_query_cpp;
 
+// tables shared by resolver tests, they run in tests/unit like schema tests
+static bool load_sql_schema(schema_t &schema)
+{
+    std::ifstream file("test_data/sql_schema.graphql", std::ios::in | std::ios::binary);
+    std::string scm{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    return !scm.empty() && schema_parser_t{}.parse(schema, scm);
+}
+
+// parses operation of context and resolves it to SQL, errors are in context.error_msgs
+static bool resolve(query_context &context, index_t bulk_threshold = sql_query_resolver::DefaultBulkThreshold)
+{
+    EXPECT_TRUE(parse_document{}.process(context));
+    return sql_query_resolver(result_format::Rows, bulk_threshold).process(context);
+}
+
+// resolved operation with compiled plan, see context.get_plan
+static bool compile(query_context &context, query_plan_cache &cache, index_t bulk_threshold = sql_query_resolver::DefaultBulkThreshold)
+{
+    return resolve(context, bulk_threshold) && query_plan_builder{cache}.process(context);
+}
+
+// SQL of resolved query, empty if it is not rendered
+static std::string render_query(const query_context &context)
+{
+    sql::postgresql_renderer renderer;
+    const sql::sql_expr_t *query = std::get_if<sql::sql_expr_t>(&context.result);
+    if (!query || !renderer.render(*query))
+        return {};
+    return renderer.get_string();
+}
+
 TEST(SqlResolver, SimpleSelect)
 {
     std::string scm = R""""(
@@ -59,4 +100,920 @@ TEST(SqlResolver, SimpleSelect)
         std::string sql = renderer.get_string();
         EXPECT_EQ(sql, "SELECT _a1.name, _a1.age, _a1.id, _a1.\"AccountId\" FROM test.user as _a1");
     }
+}
+TEST(SqlResolver, TableMapping)
+{
+    std::string scm = R""""(
+        type User @table(table: "user" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           Name: String @column(name: "name")
+           AccountId :Int @always_projected
+           Hidden :Int @always_projected(projected: False)
+        }
+        type Address { City: String }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        directive @always_projected(projected: Boolean = True) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+    EXPECT_EQ(my_schema.find_type("Address")->sql_mapping, nullptr);
+
+    const object_type *user = my_schema.find_type("User");
+    ASSERT_NE(user->sql_mapping, nullptr);
+    const sql::table_mapping &mapping = *user->sql_mapping;
+    EXPECT_EQ(mapping.schema_name, "test");
+    EXPECT_EQ(mapping.table_identifier, "user");
+    ASSERT_EQ(mapping.columns.size(), 4u);
+    EXPECT_EQ(mapping.column(*user->fields.find("Name")).identifier, "name");
+    EXPECT_EQ(mapping.column(*user->fields.find("AccountId")).identifier, "\"AccountId\"");
+    EXPECT_THAT(mapping.primary_key, testing::ElementsAre(0));
+    EXPECT_THAT(mapping.always_projected, testing::ElementsAre(2));
+}
+
+TEST(SqlResolver, DuplicateFieldsMerged)
+{
+    std::string scm = R""""(
+        schema { query: Query }
+        type Query { Users :[User] }
+        type User @table(table: "user" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           Name: String @column(name: "name")
+           Age: Int  @column(name: "age")
+           AccountId :Int @always_projected
+        }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        directive @always_projected(projected: Boolean = True) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+
+    query_context context(&my_schema, "{ Users { Name Id Name AccountId } }");
+    parse_document doc_parser;
+    sql_query_resolver resolver;
+    EXPECT_TRUE(doc_parser.process(context));
+    EXPECT_TRUE(resolver.process(context));
+
+    sql::postgresql_renderer renderer;
+    renderer.render(std::get<sql::sql_expr_t>(context.result));
+    EXPECT_EQ(renderer.get_string(), "SELECT _a1.name, _a1.id, _a1.\"AccountId\" FROM test.user as _a1");
+
+    const selection_key &selection = resolver.get_selection();
+    EXPECT_EQ(selection.type, my_schema.find_type("User"));
+    field_mask expected;
+    expected.set(0);
+    expected.set(1);
+    expected.set(3);
+    EXPECT_EQ(selection.fields, expected);
+    EXPECT_EQ((selection.fields - my_schema.find_type("User")->sql_mapping->primary_key_mask).count(), 2u);
+
+    // differently aliased selections of one field share its column, every response key is in the shape
+    query_context aliased(&my_schema, "{ x: Users { a: Name b: Name Id a: Name } }");
+    EXPECT_TRUE(doc_parser.process(aliased));
+    EXPECT_TRUE(sql_query_resolver{}.process(aliased));
+    sql::postgresql_renderer aliased_renderer;
+    aliased_renderer.render(std::get<sql::sql_expr_t>(aliased.result));
+    EXPECT_EQ(aliased_renderer.get_string(), "SELECT _a1.name, _a1.id, _a1.\"AccountId\" FROM test.user as _a1");
+    EXPECT_EQ(aliased.shape.root_field, "x");
+    EXPECT_THAT(aliased.shape.fields, testing::ElementsAre("a", "b", "Id", "AccountId"));
+    EXPECT_THAT(aliased.shape.field_columns, testing::ElementsAre(0, 0, 1, 2));
+}
+
+TEST(SqlResolver, PlanCache)
+{
+    std::string scm = R""""(
+        schema { query: Query }
+        type Query
+        {
+           Users :[User]
+        }
+        type User @table(table: "user" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           Name: String @column(name: "name")
+        }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+
+    query_plan_cache cache;
+    auto run = [&](std::string query, bool hide)
+    {
+        auto context = std::make_unique<query_context>(&my_schema, query);
+        context->variables["hide"] = hide ? "true" : "false";
+        EXPECT_TRUE(query_plan_resolver{cache}.process(*context));
+        EXPECT_TRUE(parse_document{}.process(*context));
+        EXPECT_TRUE(sql_query_resolver{}.process(*context));
+        EXPECT_TRUE(query_plan_builder{cache}.process(*context));
+        return context;
+    };
+
+    auto first = run("query A { Users { Id Name @skip(if: $hide) } }", false);
+    const compiled_plan *plan = first->get_plan();
+    ASSERT_NE(plan, nullptr);
+    EXPECT_EQ(plan->sql, "SELECT _a1.id, _a1.name FROM test.user as _a1");
+    EXPECT_THAT(plan->shape.fields, testing::ElementsAre("Id", "Name"));
+    EXPECT_EQ(cache.size(), 1u);
+
+    // same shape is served from cache without parsing
+    auto second = run("query B {\n Users { Id, Name @skip(if: $hide) }\n}", false);
+    EXPECT_EQ(second->get_plan(), plan);
+    EXPECT_TRUE(second->document.children.empty());
+
+    // other value of condition variable gets own plan
+    auto third = run("query A { Users { Id Name @skip(if: $hide) } }", true);
+    EXPECT_NE(third->get_plan(), plan);
+    EXPECT_EQ(cache.size(), 2u);
+
+    // signature hit of other document is a miss
+    plan_key collision = first->plan_cache_key;
+    collision.tokens.push_back('x');
+    EXPECT_EQ(cache.find(collision), nullptr);
+
+    // least recently used plan is evicted from full cache
+    query_plan_cache small{2};
+    plan_key keys[3] = {first->plan_cache_key, first->plan_cache_key, first->plan_cache_key};
+    keys[1].conditions = 1;
+    keys[2].conditions = 2;
+    auto plan_of = std::make_shared<const compiled_plan>();
+    small.insert(keys[0], plan_of);
+    small.insert(keys[1], plan_of);
+    EXPECT_EQ(small.find(keys[0]), plan_of);
+    small.insert(keys[2], plan_of);
+    EXPECT_EQ(small.size(), 2u);
+    EXPECT_EQ(small.find(keys[0]), plan_of);
+    EXPECT_EQ(small.find(keys[1]), nullptr);
+    EXPECT_EQ(small.find(keys[2]), plan_of);
+}
+
+TEST(SqlResolver, NestedSelection)
+{
+    std::string scm = R""""(
+        schema { query: Query }
+        type Query { Users :[User] }
+        type User @table(table: "user" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           Name: String @column(name: "name")
+           Orders: [Order!] @relation(fields: ["Id"], references: ["UserId"])
+        }
+        type Order @table(table: "order" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           UserId: Int @column(name: "user_id")
+           Total: Float @column(name: "total")
+           Items: [Item!] @relation(fields: ["Id"], references: ["OrderId"])
+           Owner: User @relation(fields: ["UserId"], references: ["Id"])
+        }
+        type Item @table(table: "item" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           OrderId: Int @column(name: "order_id")
+           Qty: Int @column(name: "qty")
+        }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        directive @relation(fields: [String!]! references: [String!]!) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+
+    query_context context(&my_schema, "{ Users { Name Orders { Total Items { Qty } } } }");
+    EXPECT_TRUE(parse_document{}.process(context));
+    EXPECT_TRUE(sql_query_resolver{}.process(context));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+
+    sql::postgresql_renderer renderer;
+    ASSERT_TRUE(renderer.render(std::get<sql::sql_expr_t>(context.result)));
+    EXPECT_EQ(renderer.get_string(), "SELECT _a1.name, _a1.id, _a2.total, _a2.id, _a3.qty, _a3.id FROM test.user as _a1"
+                                     " LEFT JOIN LATERAL (SELECT _a2.total, _a2.id FROM test.order as _a2 WHERE _a2.user_id = _a1.id) as _a2 ON TRUE"
+                                     " LEFT JOIN LATERAL (SELECT _a3.qty, _a3.id FROM test.item as _a3 WHERE _a3.order_id = _a2.id) as _a3 ON TRUE");
+
+    const result_shape &shape = context.shape;
+    EXPECT_THAT(shape.fields, testing::ElementsAre("Name"));
+    EXPECT_THAT(shape.key_columns, testing::ElementsAre(1));
+    ASSERT_EQ(shape.children.size(), 1u);
+    const result_shape &orders = shape.children[0];
+    EXPECT_EQ(orders.root_field, "Orders");
+    EXPECT_TRUE(orders.is_list);
+    EXPECT_EQ(orders.first_column, 2);
+    EXPECT_THAT(orders.key_columns, testing::ElementsAre(3));
+    ASSERT_EQ(orders.children.size(), 1u);
+    EXPECT_EQ(orders.children[0].first_column, 4);
+
+    // join by primary key of related table is to one row
+    query_context owner(&my_schema, "{ Users { Name Orders { Owner { Name } } } }");
+    EXPECT_TRUE(parse_document{}.process(owner));
+    EXPECT_TRUE(sql_query_resolver{}.process(owner));
+    const sql::sql_node *joins = std::get<sql::sql_expr_t>(owner.result).node->clause(sql::select_clause::Joins);
+    ASSERT_NE(joins, nullptr);
+    ASSERT_EQ(joins->children_count, 2u);
+    EXPECT_FALSE(joins->children[0]->to_one);
+    EXPECT_TRUE(joins->children[1]->to_one);
+
+    // shape is keyed by response keys
+    query_context aliased(&my_schema, "{ u: Users { n: Name o: Orders { Total } } }");
+    EXPECT_TRUE(parse_document{}.process(aliased));
+    EXPECT_TRUE(sql_query_resolver{}.process(aliased));
+    EXPECT_EQ(aliased.shape.root_field, "u");
+    EXPECT_THAT(aliased.shape.fields, testing::ElementsAre("n"));
+    EXPECT_THAT(aliased.shape.field_columns, testing::ElementsAre(0));
+    ASSERT_EQ(aliased.shape.children.size(), 1u);
+    EXPECT_EQ(aliased.shape.children[0].root_field, "o");
+
+    query_context wrong(&my_schema, "{ Users { Name Orders } }");
+    EXPECT_TRUE(parse_document{}.process(wrong));
+    EXPECT_FALSE(sql_query_resolver{}.process(wrong));
+}
+
+TEST(SqlResolver, JsonResult)
+{
+    std::string scm = R""""(
+        schema { query: Query }
+        type Query { Users :[User] }
+        type User @table(table: "user" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           Name: String @column(name: "name")
+           Orders: [Order!] @relation(fields: ["Id"], references: ["UserId"])
+        }
+        type Order @table(table: "order" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           UserId: Int @column(name: "user_id")
+           Total: Float @column(name: "total")
+           Owner: User @relation(fields: ["UserId"], references: ["Id"])
+        }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        directive @relation(fields: [String!]! references: [String!]!) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+
+    query_context context(&my_schema, "{ people: Users { userName: Name Orders { Total Owner { Name } } } }");
+    EXPECT_TRUE(parse_document{}.process(context));
+    EXPECT_TRUE(sql_query_resolver{result_format::Json}.process(context));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    EXPECT_TRUE(context.shape.is_json);
+    EXPECT_EQ(context.shape.root_field, "people");
+
+    sql::postgresql_renderer renderer;
+    ASSERT_TRUE(renderer.render(std::get<sql::sql_expr_t>(context.result)));
+    EXPECT_EQ(renderer.get_string(), "SELECT json_build_object('people', coalesce(json_agg(json_build_object('userName', _a1.name, 'Orders', _a2.data)), '[]'::json)) as data"
+                                     " FROM test.user as _a1"
+                                     " LEFT JOIN LATERAL (SELECT coalesce(json_agg(json_build_object('Total', _a2.total, 'Owner', _a3.data)), '[]'::json) as data"
+                                     " FROM test.order as _a2"
+                                     " LEFT JOIN LATERAL (SELECT json_build_object('Name', _a3.name) as data FROM test.user as _a3 WHERE _a3.id = _a2.user_id LIMIT 1) as _a3 ON TRUE"
+                                     " WHERE _a2.user_id = _a1.id) as _a2 ON TRUE");
+
+    EXPECT_EQ(json_data_response("{\"people\":[]}").data, "{\"data\":{\"people\":[]}}");
+}
+
+TEST(SqlResolver, BatchedRelation)
+{
+    std::string scm = R""""(
+        schema { query: Query }
+        type Query { Users :[User] }
+        type User @table(table: "user" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           Name: String @column(name: "name")
+           Orders(where: OrderFilterInput): [Order!] @relation(fields: ["Id"], references: ["UserId"])
+        }
+        type Order @table(table: "order" schema: "sales")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           UserId: Int @column(name: "user_id")
+           Total: Float @column(name: "total")
+        }
+        input FloatOperationFilterInput { gt: Float }
+        input OrderFilterInput { Total: FloatOperationFilterInput }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        directive @relation(fields: [String!]! references: [String!]!) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+
+    query_plan_cache cache;
+    query_context context(&my_schema, "{ Users { Name Orders { Total } } }");
+    EXPECT_TRUE(parse_document{}.process(context));
+    EXPECT_TRUE(sql_query_resolver{}.process(context));
+    EXPECT_TRUE(query_plan_builder{cache}.process(context));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+
+    // two queries for any number of users
+    const compiled_plan *plan = context.get_plan();
+    ASSERT_NE(plan, nullptr);
+    EXPECT_EQ(plan->sql, "SELECT _a1.name, _a1.id FROM test.user as _a1");
+    ASSERT_EQ(plan->batches.size(), 1u);
+    EXPECT_EQ(plan->batches[0].sql, "SELECT _a2.user_id, _a2.total FROM sales.order as _a2 WHERE _a2.user_id = ANY($1)");
+    EXPECT_EQ(plan->batches[0].parent_key_column, 1);
+    EXPECT_EQ(plan->batches[0].key_column, 0);
+    ASSERT_EQ(plan->shape.children.size(), 1u);
+    EXPECT_EQ(plan->shape.children[0].batch, 0);
+    EXPECT_EQ(plan->shape.children[0].first_column, 1);
+
+    batch_loader loader;
+    std::vector<std::string> user_ids;
+    for (int i = 0; i < 500; i++)
+        user_ids.push_back(std::to_string(i % 250));
+    for (const std::string &id : user_ids)
+        loader.add_key(id);
+    EXPECT_EQ(loader.keys_count(), 250u);
+    EXPECT_TRUE(loader.get_keys_parameter().starts_with("{\"0\",\"1\",\"2\""));
+
+    std::vector<std::string> order_user_ids = {"7", "3", "7", "1000"};
+    for (index_t row = 0; row < index_t(order_user_ids.size()); row++)
+        loader.add_row(order_user_ids[row], row);
+    auto rows = [&loader](std::string_view key)
+    {
+        auto res = loader.get_rows(key);
+        return std::vector<index_t>(res.begin(), res.end());
+    };
+    EXPECT_THAT(rows("7"), testing::ElementsAre(0, 2));
+    EXPECT_THAT(rows("3"), testing::ElementsAre(1));
+    EXPECT_TRUE(loader.get_rows("4").empty());
+    EXPECT_TRUE(loader.get_rows("1000").empty());
+
+    // parameters of filter of batched selection follow keys
+    query_context filtered(&my_schema, "query q($min: Float) { Users { Name Orders(where: {Total: {gt: $min}}) { Total } } }");
+    filtered.variables["min"] = "12.5";
+    EXPECT_TRUE(parse_document{}.process(filtered));
+    EXPECT_TRUE(sql_query_resolver{}.process(filtered));
+    EXPECT_TRUE(query_plan_builder{cache}.process(filtered));
+    ASSERT_TRUE(filtered.error_msgs.empty()) << filtered.error_msgs[0];
+    ASSERT_EQ(filtered.get_plan()->batches.size(), 1u);
+    const batch_load &batch = filtered.get_plan()->batches[0];
+    EXPECT_EQ(batch.sql, "SELECT _a2.user_id, _a2.total FROM sales.order as _a2 WHERE _a2.user_id = ANY($1) AND _a2.total > $2");
+    ASSERT_EQ(batch.parameters.size(), 1u);
+    EXPECT_EQ(batch.parameters[0].sql_type, "double precision");
+    ASSERT_EQ(filtered.batch_parameter_values.size(), 1u);
+    batch_loader filtered_loader;
+    filtered_loader.add_key("7");
+    EXPECT_THAT(filtered_loader.get_parameters(filtered.batch_parameter_values[0]), testing::ElementsAre("{\"7\"}", "12.5"));
+
+    query_context literal(&my_schema, "{ Users { Name Orders(where: {Total: {gt: 5}}) { Total } } }");
+    EXPECT_TRUE(parse_document{}.process(literal));
+    EXPECT_TRUE(sql_query_resolver{}.process(literal));
+    EXPECT_TRUE(query_plan_builder{cache}.process(literal));
+    ASSERT_NE(literal.get_plan(), nullptr);
+    EXPECT_TRUE(literal.get_plan()->batches[0].sql.ends_with("WHERE _a2.user_id = ANY($1) AND _a2.total > $2"));
+    EXPECT_THAT(filtered_loader.get_parameters(literal.batch_parameter_values[0]), testing::ElementsAre("{\"7\"}", "5"));
+
+    // selected key field reads the key column, which is not repeated
+    query_context with_key(&my_schema, "{ Users { Name Orders { UserId Total } } }");
+    EXPECT_TRUE(parse_document{}.process(with_key));
+    EXPECT_TRUE(sql_query_resolver{}.process(with_key));
+    EXPECT_TRUE(query_plan_builder{cache}.process(with_key));
+    ASSERT_TRUE(with_key.error_msgs.empty()) << with_key.error_msgs[0];
+    EXPECT_EQ(with_key.get_plan()->batches[0].sql, "SELECT _a2.user_id, _a2.total FROM sales.order as _a2 WHERE _a2.user_id = ANY($1)");
+    const result_shape &orders = with_key.get_plan()->shape.children.at(0);
+    EXPECT_THAT(orders.fields, testing::ElementsAre("UserId", "Total"));
+    EXPECT_THAT(orders.field_columns, testing::ElementsAre(0, 1));
+}
+
+TEST(SqlResolver, MicroBatching)
+{
+    schema_t my_schema;
+    ASSERT_TRUE(load_sql_schema(my_schema));
+
+    query_plan_cache cache;
+    std::string query = "query q($id: Int) { files(where: {Id: {eq: $id} name: {neq: \"$1\"}}) { name } }";
+    query_context context(&my_schema, query);
+    context.variables["id"] = "1";
+    // plan is cached for requests below
+    EXPECT_TRUE(query_plan_resolver{cache}.process(context));
+    EXPECT_TRUE(compile(context, cache));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    std::shared_ptr<const compiled_plan> plan = std::get<std::shared_ptr<const compiled_plan>>(context.result);
+    EXPECT_EQ(merge_plan_sql(*plan), "SELECT _b.ord, _q.* FROM unnest($1::integer[]) WITH ORDINALITY as _b(p1, ord)"
+                                     " CROSS JOIN LATERAL (SELECT _a1.name FROM test.file as _a1 WHERE _a1.id = _b.p1 AND _a1.name <> $2) as _q");
+
+    // type of column compared to ID is not known, derived parameters have no declared type
+    // and batch queries take keys of all rows
+    query_context id(&my_schema, "query q($id: ID) { files(where: {Id: {eq: $id}}) { name } }");
+    id.variables["id"] = "1";
+    EXPECT_TRUE(compile(id, cache));
+    ASSERT_NE(id.get_plan(), nullptr);
+    EXPECT_FALSE(can_merge_plan(*id.get_plan()));
+    EXPECT_EQ(merge_plan_sql(*id.get_plan()), "");
+    query_context pattern(&my_schema, "query q($part: String) { files(where: {name: {contains: $part}}) { name } }");
+    pattern.variables["part"] = "a";
+    EXPECT_TRUE(compile(pattern, cache));
+    ASSERT_NE(pattern.get_plan(), nullptr);
+    EXPECT_FALSE(can_merge_plan(*pattern.get_plan()));
+    compiled_plan batched = *plan;
+    batched.batches.emplace_back();
+    EXPECT_FALSE(can_merge_plan(batched));
+
+    // echoes every id of merged statement as a row of its request
+    int executed = 0;
+    micro_batcher batcher{[&executed](const std::string &sql, const std::vector<std::string> &parameters, std::vector<result_row> &rows)
+                          {
+                              executed++;
+                              if (!sql.starts_with("SELECT _b.ord") || parameters.size() != 2 || parameters[1] != "$1")
+                                  return false;
+                              std::string_view ids = parameters[0];
+                              ids = ids.substr(1, ids.size() - 2);
+                              for (int ordinal = 1; !ids.empty(); ordinal++)
+                              {
+                                  size_t end = std::min(ids.find(','), ids.size());
+                                  rows.push_back({std::to_string(ordinal), std::string{ids.substr(1, end - 2)}});
+                                  ids.remove_prefix(std::min(end + 1, ids.size()));
+                              }
+                              return true;
+                          },
+                          std::chrono::seconds{10}, 4};
+
+    constexpr int RequestsCount = 4;
+    std::vector<std::unique_ptr<query_context>> contexts;
+    std::vector<std::vector<result_row>> results(RequestsCount);
+    std::vector<bool> succeeded(RequestsCount);
+    for (int i = 0; i < RequestsCount; i++)
+    {
+        contexts.push_back(std::make_unique<query_context>(&my_schema, query));
+        contexts[i]->variables["id"] = std::to_string(100 + i);
+        EXPECT_TRUE(query_plan_resolver{cache}.process(*contexts[i]));
+        ASSERT_EQ(contexts[i]->get_plan(), plan.get());
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < RequestsCount; i++)
+        threads.emplace_back([&, i]
+                             { succeeded[i] = batcher.execute(*contexts[i], results[i]); });
+    for (std::thread &thread : threads)
+        thread.join();
+
+    // full batch runs without waiting for the window
+    EXPECT_EQ(executed, 1);
+    EXPECT_EQ(batcher.get_statements_count(), 1u);
+    for (int i = 0; i < RequestsCount; i++)
+    {
+        ASSERT_TRUE(succeeded[i]);
+        ASSERT_EQ(results[i].size(), 1u);
+        EXPECT_THAT(results[i][0], testing::ElementsAre(std::to_string(100 + i)));
+    }
+
+    // exception of executor reaches every request of the batch
+    micro_batcher failing{[](const std::string &, const std::vector<std::string> &, std::vector<result_row> &) -> bool
+                          { throw std::runtime_error("connection lost"); },
+                          std::chrono::seconds{10}, RequestsCount};
+    threads.clear();
+    for (int i = 0; i < RequestsCount; i++)
+        threads.emplace_back([&, i]
+                             { EXPECT_THROW(failing.execute(*contexts[i], results[i]), std::runtime_error); });
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+TEST(SqlResolver, SingleFlight)
+{
+    auto plan = std::make_shared<compiled_plan>();
+    plan->sql = "SELECT _a1.name FROM test.user as _a1 WHERE _a1.id = $1";
+    plan->parameters = {{sql::parameter_type::Variable, "id", "integer"}};
+
+    constexpr int RequestsCount = 8;
+    std::unique_ptr<single_flight> flights;
+    // first execution is held until all identical requests are attached
+    flights = std::make_unique<single_flight>([&flights](const std::string &, const std::vector<std::string> &parameters, std::vector<result_row> &rows)
+                                              {
+                                                  if (parameters[0] == "1")
+                                                  {
+                                                      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+                                                      while (flights->get_deduplicated_count() < RequestsCount - 1 && std::chrono::steady_clock::now() < deadline)
+                                                          std::this_thread::yield();
+                                                  }
+                                                  rows.push_back({"user" + parameters[0]});
+                                                  return true;
+                                              });
+
+    std::vector<std::unique_ptr<query_context>> contexts;
+    std::vector<shared_rows> results(RequestsCount + 1);
+    for (int i = 0; i <= RequestsCount; i++)
+    {
+        contexts.push_back(std::make_unique<query_context>(nullptr, ""));
+        contexts[i]->variables["id"] = i < RequestsCount ? "1" : "2";
+        contexts[i]->result = std::shared_ptr<const compiled_plan>{plan};
+        ASSERT_TRUE(plan->bind(*contexts[i]));
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < RequestsCount; i++)
+        threads.emplace_back([&, i]
+                             { EXPECT_TRUE(flights->execute(*contexts[i], results[i])); });
+    for (std::thread &thread : threads)
+        thread.join();
+    EXPECT_TRUE(flights->execute(*contexts[RequestsCount], results[RequestsCount]));
+
+    EXPECT_EQ(flights->get_executed_count(), 2u);
+    EXPECT_EQ(flights->get_deduplicated_count(), size_t(RequestsCount - 1));
+    for (int i = 0; i < RequestsCount; i++)
+    {
+        ASSERT_TRUE(results[i]);
+        EXPECT_EQ(results[i], results[0]);
+    }
+    EXPECT_THAT((*results[0])[0], testing::ElementsAre("user1"));
+    EXPECT_THAT((*results[RequestsCount])[0], testing::ElementsAre("user2"));
+
+    // exception of executor reaches identical requests, flight is not left behind
+    std::unique_ptr<single_flight> failing;
+    failing = std::make_unique<single_flight>([&failing](const std::string &, const std::vector<std::string> &, std::vector<result_row> &) -> bool
+                                              {
+                                                  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+                                                  while (failing->get_deduplicated_count() < RequestsCount - 1 && std::chrono::steady_clock::now() < deadline)
+                                                      std::this_thread::yield();
+                                                  throw std::runtime_error("connection lost");
+                                              });
+    threads.clear();
+    for (int i = 0; i < RequestsCount; i++)
+        threads.emplace_back([&, i]
+                             { EXPECT_THROW(failing->execute(*contexts[i], results[i]), std::runtime_error); });
+    for (std::thread &thread : threads)
+        thread.join();
+    EXPECT_THROW(failing->execute(*contexts[0], results[0]), std::runtime_error);
+    EXPECT_EQ(failing->get_executed_count(), 2u);
+}
+
+TEST(SqlResolver, CursorPagination)
+{
+    std::string scm = R""""(
+        schema { query: Query }
+        type Query { files(skip: Int take: Int after: String order: [fileSortInput!]): fileCollectionSegment }
+        type CollectionSegmentInfo { hasNextPage: Boolean! hasPreviousPage: Boolean! }
+        type fileCollectionSegment { pageInfo: CollectionSegmentInfo! items: [file] }
+        type file @table(table: "file" schema: "test")
+        {
+           Id: Int @column(name: "id" IsPK: True)
+           name: String! @column(name: "name")
+           size: Int! @column(name: "size")
+           note: String @column(name: "note")
+        }
+        enum SortEnumType { ASC DESC }
+        input fileSortInput { name: SortEnumType size: SortEnumType Id: SortEnumType note: SortEnumType }
+
+        directive @table(table: String schema: String) on OBJECT
+        directive @column(name: String IsPK: Boolean = False) on FIELD_DEFINITION
+        )"""";
+
+    schema_t my_schema;
+    schema_parser_t parser;
+    ASSERT_TRUE(parser.parse(my_schema, scm));
+
+    std::vector<std::string_view> key = {"it's", "7"};
+    std::string cursor = encode_cursor(key);
+    std::vector<std::string> decoded;
+    ASSERT_TRUE(decode_cursor(cursor, decoded));
+    EXPECT_THAT(decoded, testing::ElementsAre("it's", "7"));
+    decoded.clear();
+    EXPECT_FALSE(decode_cursor("bm90IGEgY3Vyc29y", decoded));
+
+    query_context context(&my_schema, "{ files(take: 10 after: \"" + cursor + "\" order: [{name: ASC}]) { items { name } pageInfo { hasNextPage } } }");
+    EXPECT_TRUE(parse_document{}.process(context));
+    EXPECT_TRUE(sql_query_resolver{}.process(context));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    sql::postgresql_renderer renderer;
+    ASSERT_TRUE(renderer.render(std::get<sql::sql_expr_t>(context.result)));
+    EXPECT_EQ(renderer.get_string(), "SELECT _a1.name, _a1.id FROM test.file as _a1 WHERE (_a1.name, _a1.id) > ('it''s', '7')"
+                                     " ORDER BY _a1.name ASC, _a1.id ASC LIMIT 11");
+    EXPECT_EQ(context.shape.segment_field, "files");
+    EXPECT_EQ(context.shape.root_field, "items");
+    EXPECT_EQ(context.shape.page_size, 10u);
+    EXPECT_THAT(context.shape.cursor_columns, testing::ElementsAre(0, 1));
+
+    // cursor variable is bound to plan parameters, mixed directions are expanded
+    query_plan_cache cache;
+    query_context next(&my_schema, "query next($after: String $take: Int) { files(take: $take after: $after order: {size: DESC}) { items { name } } }");
+    next.variables["after"] = encode_cursor(std::vector<std::string_view>{"100", "7"});
+    next.variables["take"] = "20";
+    EXPECT_TRUE(parse_document{}.process(next));
+    EXPECT_TRUE(sql_query_resolver{}.process(next));
+    EXPECT_TRUE(query_plan_builder{cache}.process(next));
+    ASSERT_TRUE(next.error_msgs.empty()) << next.error_msgs[0];
+    ASSERT_NE(next.get_plan(), nullptr);
+    EXPECT_EQ(next.get_plan()->sql, "SELECT _a1.name, _a1.size, _a1.id FROM test.file as _a1"
+                                    " WHERE (_a1.size < $1 OR (_a1.size = $2 AND _a1.id > $3))"
+                                    " ORDER BY _a1.size DESC, _a1.id ASC LIMIT $4 + $5");
+    EXPECT_THAT(next.parameter_values, testing::ElementsAre("100", "100", "7", "20", "1"));
+    EXPECT_EQ(next.get_plan()->shape.page_size_variable, "take");
+
+    // first page has no cursor, its plan is cached apart from plan with cursor
+    std::string next_query = "query next($after: String) { files(take: 5 after: $after) { items { name } } }";
+    query_context first(&my_schema, next_query);
+    EXPECT_TRUE(query_plan_resolver{cache}.process(first));
+    EXPECT_TRUE(parse_document{}.process(first));
+    EXPECT_TRUE(sql_query_resolver{}.process(first));
+    EXPECT_TRUE(query_plan_builder{cache}.process(first));
+    ASSERT_TRUE(first.error_msgs.empty()) << first.error_msgs[0];
+    EXPECT_EQ(first.get_plan()->sql, "SELECT _a1.name, _a1.id FROM test.file as _a1 ORDER BY _a1.id ASC LIMIT $1");
+    query_context second(&my_schema, next_query);
+    second.variables["after"] = encode_cursor(std::vector<std::string_view>{"7"});
+    EXPECT_TRUE(query_plan_resolver{cache}.process(second));
+    EXPECT_FALSE(second.is_resolved());
+    query_context null_cursor(&my_schema, next_query);
+    null_cursor.variables["after"] = "null";
+    EXPECT_TRUE(query_plan_resolver{cache}.process(null_cursor));
+    ASSERT_TRUE(null_cursor.is_resolved());
+    EXPECT_EQ(null_cursor.get_plan(), first.get_plan());
+
+    // cursor of other sort keys is rejected at bind
+    query_context other_keys(&my_schema, "query next($after: String) { files(take: 5 after: $after order: {size: DESC}) { items { name } } }");
+    other_keys.variables["after"] = encode_cursor(std::vector<std::string_view>{"7"});
+    EXPECT_TRUE(parse_document{}.process(other_keys));
+    EXPECT_TRUE(sql_query_resolver{}.process(other_keys));
+    EXPECT_FALSE(query_plan_builder{cache}.process(other_keys));
+
+    query_context wrong(&my_schema, "{ files(after: \"xyz\") { items { name } } }");
+    EXPECT_TRUE(parse_document{}.process(wrong));
+    EXPECT_FALSE(sql_query_resolver{}.process(wrong));
+
+    // offset from cursor and cursor after nullable sort key are rejected
+    query_context skip_after(&my_schema, "{ files(skip: 5 after: \"" + cursor + "\" order: [{name: ASC}]) { items { name } } }");
+    EXPECT_TRUE(parse_document{}.process(skip_after));
+    EXPECT_FALSE(sql_query_resolver{}.process(skip_after));
+    query_context nullable(&my_schema, "{ files(after: \"" + cursor + "\" order: [{note: ASC}]) { items { name } } }");
+    EXPECT_TRUE(parse_document{}.process(nullable));
+    EXPECT_FALSE(sql_query_resolver{}.process(nullable));
+    EXPECT_THAT(nullable.error_msgs, testing::Contains(testing::HasSubstr("'note' is nullable")));
+}
+
+TEST(SqlResolver, FilterArgument)
+{
+    schema_t my_schema;
+    ASSERT_TRUE(load_sql_schema(my_schema));
+
+    query_plan_cache cache;
+    query_context context(&my_schema, "query q($min: Int $part: String) { files(where: {name: {startsWith: \"re_p\" ncontains: $part}"
+                                      " deleted: {eq: false} or: [{size: {gt: $min}}, {Id: {in: [1, 2, 3]}}, {name: {eq: null}}]}) { name } }");
+    context.variables["min"] = "10";
+    context.variables["part"] = "50%";
+    EXPECT_TRUE(compile(context, cache));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    ASSERT_NE(context.get_plan(), nullptr);
+    EXPECT_EQ(context.get_plan()->sql, "SELECT _a1.name FROM test.file as _a1"
+                                       " WHERE _a1.name LIKE $1 AND NOT (_a1.name LIKE $2) AND _a1.deleted = $3"
+                                       " AND (_a1.size > $4 OR _a1.id = ANY($5) OR _a1.name IS NULL)");
+    EXPECT_THAT(context.parameter_values, testing::ElementsAre("re\\_p%", "%50\\%%", "false", "10", "{\"1\",\"2\",\"3\"}"));
+
+    // OR of operands which are not comparisons keeps its parens next to sibling conditions
+    query_context nulls(&my_schema, "{ files(where: {or: [{name: {eq: null}}, {size: {eq: null}}], deleted: {eq: true}}) { name } }");
+    EXPECT_TRUE(compile(nulls, cache));
+    ASSERT_TRUE(nulls.error_msgs.empty()) << nulls.error_msgs[0];
+    EXPECT_EQ(nulls.get_plan()->sql, "SELECT _a1.name FROM test.file as _a1 WHERE (_a1.name IS NULL OR _a1.size IS NULL) AND _a1.deleted = $1");
+    query_context excluded(&my_schema, "{ files(where: {or: [{name: {ncontains: \"a\"}}, {name: {ncontains: \"b\"}}], size: {eq: 1}}) { name } }");
+    EXPECT_TRUE(compile(excluded, cache));
+    ASSERT_TRUE(excluded.error_msgs.empty()) << excluded.error_msgs[0];
+    EXPECT_EQ(excluded.get_plan()->sql, "SELECT _a1.name FROM test.file as _a1 WHERE (NOT (_a1.name LIKE $1) OR NOT (_a1.name LIKE $2)) AND _a1.size = $3");
+
+    // list variable is bound as array, filter object variable is rejected
+    query_context list(&my_schema, "query q($ids: [Int!]) { files(where: {Id: {in: $ids}}) { name } }");
+    list.variables["ids"] = "[4, 5 \"6\"]";
+    EXPECT_TRUE(compile(list, cache));
+    ASSERT_TRUE(list.error_msgs.empty()) << list.error_msgs[0];
+    EXPECT_EQ(list.get_plan()->sql, "SELECT _a1.name FROM test.file as _a1 WHERE _a1.id = ANY($1)");
+    EXPECT_THAT(list.parameter_values, testing::ElementsAre("{\"4\",\"5\",\"6\"}"));
+    query_context bad_list(&my_schema, "query q($ids: [Int!]) { files(where: {Id: {in: $ids}}) { name } }");
+    bad_list.variables["ids"] = "[[4]]";
+    EXPECT_TRUE(resolve(bad_list));
+    EXPECT_FALSE(query_plan_builder{cache}.process(bad_list));
+
+    query_context object_variable(&my_schema, "query q($f: fileFilterInput) { files(where: $f) { name } }");
+    EXPECT_FALSE(resolve(object_variable));
+
+    query_context wrong(&my_schema, "{ files(where: {size: {near: 1}}) { name } }");
+    EXPECT_FALSE(resolve(wrong));
+}
+
+TEST(SqlResolver, TotalCount)
+{
+    schema_t my_schema;
+    ASSERT_TRUE(load_sql_schema(my_schema));
+
+    query_plan_cache cache;
+    query_context context(&my_schema, "{ filePages(take: 10) { items { name } totalCount } }");
+    EXPECT_TRUE(compile(context, cache));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    ASSERT_NE(context.get_plan(), nullptr);
+    EXPECT_EQ(context.get_plan()->sql, "SELECT _a1.name, _a1.id, count(*) OVER () as total_count FROM test.file as _a1 ORDER BY _a1.id ASC LIMIT $1");
+    EXPECT_EQ(context.get_plan()->shape.total_count_column, 2);
+
+    // not selected, not counted
+    query_context page(&my_schema, "{ filePages(take: 10) { items { name } } }");
+    EXPECT_TRUE(resolve(page));
+    EXPECT_EQ(render_query(page), "SELECT _a1.name, _a1.id FROM test.file as _a1 ORDER BY _a1.id ASC LIMIT 11");
+    EXPECT_EQ(page.shape.total_count_column, -1);
+
+    // page is taken from files before their versions are joined
+    query_context nested(&my_schema, "{ filePages(take: 10) { items { name versions { number } } totalCount } }");
+    EXPECT_TRUE(resolve(nested));
+    ASSERT_TRUE(nested.error_msgs.empty()) << nested.error_msgs[0];
+    EXPECT_EQ(render_query(nested), "SELECT _a1.name, _a1.id, _a2.number, _a2.id, (SELECT count(*) FROM test.file as _a3) as total_count"
+                                    " FROM (SELECT _a1.* FROM test.file as _a1 ORDER BY _a1.id ASC LIMIT 11) as _a1"
+                                    " LEFT JOIN LATERAL (SELECT _a2.number, _a2.id FROM test.file_version as _a2 WHERE _a2.file_id = _a1.id) as _a2 ON TRUE"
+                                    " ORDER BY _a1.id ASC");
+
+    // rows after cursor are not all rows
+    std::string cursor = encode_cursor(std::vector<std::string_view>{"7"});
+    query_context next(&my_schema, "{ filePages(take: 10 after: \"" + cursor + "\") { items { name } totalCount } }");
+    EXPECT_TRUE(resolve(next));
+    EXPECT_EQ(render_query(next), "SELECT _a1.name, _a1.id, (SELECT count(*) FROM test.file as _a2) as total_count FROM test.file as _a1"
+                                  " WHERE (_a1.id) > ('7') ORDER BY _a1.id ASC LIMIT 11");
+
+    query_context estimated(&my_schema, "{ estimatedFiles { totalCount items { Id } } }");
+    EXPECT_TRUE(resolve(estimated));
+    ASSERT_TRUE(estimated.error_msgs.empty()) << estimated.error_msgs[0];
+    EXPECT_EQ(render_query(estimated), "SELECT _a1.id, (SELECT greatest(reltuples, 0)::bigint FROM pg_class WHERE oid = 'test.file'::regclass) as total_count"
+                                       " FROM test.file as _a1 ORDER BY _a1.id ASC");
+    EXPECT_EQ(estimated.shape.total_count_column, 1);
+}
+
+TEST(SqlResolver, Mutation)
+{
+    schema_t my_schema;
+    ASSERT_TRUE(load_sql_schema(my_schema));
+
+    query_plan_cache cache;
+    query_context context(&my_schema, R"(mutation m($name: String) {
+        a: add_file(file: {name: $name deleted: false}) { countObjectsModified }
+        b: add_file(file: [{deleted: true name: "x"}, {name: "y" deleted: null}]) { countObjectsModified }
+        c: update_file(file: {Id: 11 name: "n1"}) { countObjectsModified }
+        d: update_file(file: {name: "n2"} where: {Id: {eq: 12}}) { countObjectsModified }
+        e: update_file(file: {deleted: true} where: {name: {startsWith: "tmp"}}) { countObjectsModified }
+        f: delete_file(where: {Id: {eq: 13}}) { Id fileName: name }
+    })");
+    context.variables["name"] = "z";
+    EXPECT_TRUE(compile(context, cache));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    const compiled_plan *plan = context.get_plan();
+    ASSERT_NE(plan, nullptr);
+    EXPECT_TRUE(plan->sql.empty());
+    ASSERT_EQ(plan->mutations.size(), 4u);
+    EXPECT_EQ(plan->mutations[0].sql, "INSERT INTO test.file (name, deleted) VALUES ($1, $2), ($3, $4), ($5, NULL) RETURNING id");
+    EXPECT_THAT(plan->mutations[0].row_fields, testing::ElementsAre("a", "b", "b"));
+    EXPECT_THAT(plan->mutations[0].count_fields, testing::ElementsAre("countObjectsModified"));
+    EXPECT_TRUE(plan->mutations[0].shape.fields.empty());
+    EXPECT_EQ(plan->mutations[1].sql, "UPDATE test.file as _a1 SET name = _a2.column3 FROM (VALUES ($1::integer, $2::integer, $3::text), ($4, $5, $6)) as _a2"
+                                      " WHERE _a1.id = _a2.column2 RETURNING _a2.column1");
+    EXPECT_TRUE(plan->mutations[1].ordinal_column);
+    EXPECT_THAT(plan->mutations[1].row_fields, testing::ElementsAre("c", "d"));
+    EXPECT_EQ(plan->mutations[2].sql, "UPDATE test.file as _a3 SET deleted = $1 WHERE _a3.name LIKE $2 RETURNING _a3.id");
+    EXPECT_EQ(plan->mutations[3].sql, "DELETE FROM test.file as _a4 WHERE _a4.id = $1 RETURNING _a4.id, _a4.name");
+    EXPECT_EQ(plan->mutations[3].operation, "delete");
+    EXPECT_TRUE(plan->mutations[3].count_fields.empty());
+    EXPECT_TRUE(plan->mutations[3].shape.is_list);
+    EXPECT_THAT(plan->mutations[3].shape.fields, testing::ElementsAre("Id", "fileName"));
+    EXPECT_THAT(plan->mutations[3].shape.field_columns, testing::ElementsAre(0, 1));
+    EXPECT_EQ(plan->mutations[3].first_parameter, 13u);
+    EXPECT_THAT(context.parameter_values, testing::ElementsAre("z", "false", "x", "true", "y", "1", "11", "n1", "2", "12", "n2",
+                                                               "true", "tmp%", "13"));
+
+    // statements run in one transaction, failed one rolls it back
+    std::vector<std::string> log;
+    std::string failing;
+    statement_executor executor = [&](const std::string &sql, const std::vector<std::string> &parameters, std::vector<result_row> &rows)
+    {
+        log.push_back(sql.substr(0, sql.find(' ')) + (parameters.empty() ? "" : " " + parameters.back()));
+        if (sql.starts_with("INSERT"))
+            rows = {{"i1"}, {"i2"}, {"i3"}};
+        return sql != failing;
+    };
+    std::vector<std::vector<result_row>> rows;
+    EXPECT_TRUE(execute_mutation(context, executor, rows));
+    EXPECT_THAT(log, testing::ElementsAre("BEGIN", "INSERT y", "UPDATE n2", "UPDATE tmp%", "DELETE 13", "COMMIT"));
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0].size(), 3u);
+
+    log.clear();
+    failing = plan->mutations[2].sql;
+    EXPECT_FALSE(execute_mutation(context, executor, rows));
+    EXPECT_THAT(log, testing::ElementsAre("BEGIN", "INSERT y", "UPDATE n2", "UPDATE tmp%", "ROLLBACK"));
+
+    query_context unsafe(&my_schema, "mutation { delete_file(system_file: {}) { Id } }");
+    EXPECT_FALSE(resolve(unsafe));
+
+    // values of several input objects are not given to rows found by filter
+    query_context filtered(&my_schema, "mutation { update_file(file: [{name: \"a\"}, {name: \"b\"}] where: {name: {eq: \"c\"}}) { countObjectsModified } }");
+    EXPECT_FALSE(resolve(filtered));
+
+    // key of rows found by filter is not changed silently
+    query_context rekey(&my_schema, "mutation { update_file(where: {Id: {eq: 1}} file: {Id: 2 name: \"a\"}) { countObjectsModified } }");
+    EXPECT_FALSE(resolve(rekey));
+    EXPECT_THAT(rekey.error_msgs, testing::Contains(testing::HasSubstr("can't set key field 'Id'")));
+    query_context rekey_all(&my_schema, "mutation { update_file(where: {name: {eq: \"a\"}} file: {Id: 2}) { countObjectsModified } }");
+    EXPECT_FALSE(resolve(rekey_all));
+
+    query_context unknown(&my_schema, "mutation { add_file(file: {name: \"a\"}) { countObjectsModified name } }");
+    EXPECT_FALSE(resolve(unknown));
+}
+
+TEST(SqlResolver, BulkInsert)
+{
+    schema_t my_schema;
+    ASSERT_TRUE(load_sql_schema(my_schema));
+
+    query_plan_cache cache;
+    query_context context(&my_schema, "mutation m($size: Int) { add_upload(upload: [{Id: 1 name: \"a\" size: $size}, {Id: 2 name: null size: 3}]) { countObjectsModified } }");
+    context.variables["size"] = "5";
+    EXPECT_TRUE(compile(context, cache));
+    ASSERT_TRUE(context.error_msgs.empty()) << context.error_msgs[0];
+    ASSERT_NE(context.get_plan(), nullptr);
+    const mutation_statement &statement = context.get_plan()->mutations.at(0);
+    ASSERT_TRUE(statement.is_bulk());
+    EXPECT_EQ(statement.bulk.create_sql, "CREATE TEMP TABLE _bulk1 (_row serial, id integer, name text, size integer) ON COMMIT DROP");
+    EXPECT_EQ(statement.bulk.copy_sql, "COPY _bulk1 (id, name, size) FROM STDIN (FORMAT binary)");
+    EXPECT_EQ(statement.sql, "INSERT INTO test.upload (id, name, size) SELECT id, name, size FROM _bulk1 ORDER BY _row ASC"
+                             " ON CONFLICT (id) DO UPDATE SET name = excluded.name, size = excluded.size RETURNING id");
+
+    std::vector<std::string> log;
+    std::string data, inserted;
+    std::vector<std::string> inserted_parameters;
+    statement_executor executor = [&](const std::string &sql, const std::vector<std::string> &parameters, std::vector<result_row> &)
+    {
+        log.push_back(sql.substr(0, sql.find(' ')));
+        if (sql.starts_with("INSERT INTO _bulk1"))
+        {
+            inserted = sql;
+            inserted_parameters = parameters;
+        }
+        return true;
+    };
+    copy_executor copy = [&](const std::string &sql, std::string_view copy_data)
+    {
+        log.push_back(sql.substr(0, sql.find(' ')));
+        data = copy_data;
+        return true;
+    };
+    std::vector<std::vector<result_row>> rows;
+    EXPECT_TRUE(execute_mutation(context, executor, rows, copy));
+    EXPECT_THAT(log, testing::ElementsAre("BEGIN", "CREATE", "COPY", "INSERT", "COMMIT"));
+    using namespace std::string_literals;
+    EXPECT_EQ(data, "PGCOPY\n\377\r\n\0"s + "\0\0\0\0\0\0\0\0"s +
+                        "\0\3"s + "\0\0\0\4\0\0\0\1"s + "\0\0\0\1a"s + "\0\0\0\4\0\0\0\5"s +
+                        "\0\3"s + "\0\0\0\4\0\0\0\2"s + "\377\377\377\377"s + "\0\0\0\4\0\0\0\3"s + "\377\377"s);
+
+    // without copy executor rows go to temporary table by INSERT
+    log.clear();
+    EXPECT_TRUE(execute_mutation(context, executor, rows));
+    EXPECT_THAT(log, testing::ElementsAre("BEGIN", "CREATE", "INSERT", "INSERT", "COMMIT"));
+    EXPECT_EQ(inserted, "INSERT INTO _bulk1 (id, name, size) VALUES ($1, $2, $3), ($4, NULL, $5)");
+    EXPECT_THAT(inserted_parameters, testing::ElementsAre("1", "a", "5", "2", "3"));
+
+    context.variables["size"] = "big";
+    EXPECT_FALSE(execute_mutation(context, executor, rows, copy));
+
+    // rows of list variable are not in plan, they are taken from the variable at bind
+    query_context list(&my_schema, "mutation m($rows: [uploadDataInput!]) { add_upload(upload: $rows) { countObjectsModified } }");
+    list.variables["rows"] = "[{\"Id\": 1, \"name\": \"a\\\"b\", \"size\": 5}, {\"size\": null, \"Id\": 2}]";
+    EXPECT_TRUE(compile(list, cache));
+    ASSERT_TRUE(list.error_msgs.empty()) << list.error_msgs[0];
+    ASSERT_NE(list.get_plan(), nullptr);
+    const mutation_statement &list_statement = list.get_plan()->mutations.at(0);
+    EXPECT_TRUE(list_statement.bulk.values.empty());
+    EXPECT_EQ(list_statement.sql, statement.sql);
+    log.clear();
+    EXPECT_TRUE(execute_mutation(list, executor, rows));
+    EXPECT_THAT(log, testing::ElementsAre("BEGIN", "CREATE", "INSERT", "INSERT", "COMMIT"));
+    EXPECT_EQ(inserted, "INSERT INTO _bulk1 (id, name, size) VALUES ($1, $2, $3), ($4, NULL, NULL)");
+    EXPECT_THAT(inserted_parameters, testing::ElementsAre("1", "a\"b", "5", "2"));
+    list.variables["rows"] = "[{\"Id\": 1, \"owner\": 2}]";
+    EXPECT_FALSE(list.get_plan()->bind(list));
+    list.variables["rows"] = "[{\"Id\": [1]}]";
+    EXPECT_FALSE(list.get_plan()->bind(list));
+
+    // large insert without @bulk, types which are not encoded are cast from text
+    query_context tags(&my_schema, "mutation { add_tag(tag: [{name: \"x\" added: \"2024-01-01\"}, {name: \"y\" added: null}]) { countObjectsModified } }");
+    EXPECT_TRUE(compile(tags, cache, 2));
+    ASSERT_TRUE(tags.error_msgs.empty()) << tags.error_msgs[0];
+    ASSERT_NE(tags.get_plan(), nullptr);
+    EXPECT_EQ(tags.get_plan()->mutations[0].bulk.create_sql, "CREATE TEMP TABLE _bulk1 (_row serial, name text, added text) ON COMMIT DROP");
+    EXPECT_EQ(tags.get_plan()->mutations[0].sql, "INSERT INTO test.tag (name, added) SELECT name, added::timestamptz FROM _bulk1 ORDER BY _row ASC"
+                                                   " ON CONFLICT DO NOTHING RETURNING TRUE");
+
+    // bulk load is opt-in, large insert renders VALUES by default
+    query_context values(&my_schema, "mutation { add_tag(tag: [{name: \"x\" added: null}, {name: \"y\" added: null}]) { countObjectsModified } }");
+    EXPECT_TRUE(compile(values, cache));
+    ASSERT_NE(values.get_plan(), nullptr);
+    EXPECT_FALSE(values.get_plan()->mutations[0].is_bulk());
 }
\ No newline at end of file
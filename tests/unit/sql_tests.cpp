@@ -3,6 +3,7 @@
 #include <gmock/gmock.h>
 #include "data/sql/sql_expr.hpp"
 #include "data/sql/postgresql_renderer.hpp"
+#include "data/sql/sql_optimizer.hpp"
 
 using namespace blitz_query_cpp::sql;
 
@@ -54,6 +55,15 @@ TEST(Sql, SelectWhere)
 
     auto query2 = select({"id", "name"}) | from(table("users")) | where(binary_operation("name", binary_op::Like, "M%"));
     EXPECT_EQ(render(query2), "SELECT id, name FROM users WHERE name LIKE 'M%'");
+
+    // operands are grouped by operator precedence
+    auto col = [](std::string_view name) { return sql_expr_t{sql_expr_type::Column, name}; };
+    sql_expr_t is_null{sql_expr_type::IsNull, {}, col("note")};
+    sql_expr_t difference = binary_operation(col("a"), binary_op::Minus, binary_operation(col("b"), binary_op::Minus, col("c")));
+    auto query3 = select({"id"}) | from(table("users")) |
+                  where(binary_operation(is_null, binary_op::Or, binary_operation(difference, binary_op::Gt, binary_operation(col("d"), binary_op::Multiply, col("e"))))) |
+                  where(binary_operation("age", binary_op::Gt, 18));
+    EXPECT_EQ(render(query3), "SELECT id FROM users WHERE (note IS NULL OR a - (b - c) > d * e) AND age > 18");
 }
 
 TEST(Sql, SelectOffsetLimit)
@@ -81,4 +91,110 @@ TEST(Sql, SimpleJoin)
 {
     auto query1 = select() | column("user", "id") | column("user", "name") | from(table("user")) | join(table("order"), join_kind::InnerJoin, column("user", "id"), column("oder", "user_id"));
     EXPECT_EQ(render(query1), "SELECT user.id, user.name FROM user INNER JOIN order ON user.id = oder.user_id");
+}
+
+TEST(Sql, ArenaScope)
+{
+    blitz_query_cpp::arena_t arena;
+    std::string query_text;
+    {
+        arena_scope scope{arena};
+        std::string name = "users";
+        auto query = select() | limit(5) | from(table(name)) | column("users", "id");
+        name = "changed";
+        EXPECT_EQ(query.children().size(), 0u);
+        EXPECT_EQ(query.node->clause(select_clause::Where), nullptr);
+        query_text = render(query);
+    }
+    EXPECT_EQ(query_text, "SELECT users.id FROM users LIMIT 5");
+    EXPECT_GT(arena.allocated_bytes(), 0u);
+
+    // identifiers owned by schema are not copied
+    std::string_view identifier = "\"Users\"";
+    arena_scope scope{arena};
+    auto node = table(static_str{identifier});
+    EXPECT_EQ(node.value().data(), identifier.data());
+}
+
+TEST(Sql, DefaultArenaReset)
+{
+    // nodes outside of scope go to default arena until it is reset
+    render(select() | from(table("users")));
+    EXPECT_GT(current_arena().allocated_bytes(), 0u);
+    reset_default_arena();
+    EXPECT_EQ(current_arena().allocated_bytes(), 0u);
+    EXPECT_EQ(render(select() | column("users", "id") | from(table("users"))), "SELECT users.id FROM users");
+
+    // arena of scope is not touched
+    blitz_query_cpp::arena_t arena;
+    arena_scope scope{arena};
+    auto query = select() | from(table("users"));
+    reset_default_arena();
+    EXPECT_GT(arena.allocated_bytes(), 0u);
+    EXPECT_EQ(render(query | column("users", "id")), "SELECT users.id FROM users");
+}
+
+TEST(Sql, ParameterizedLiterals)
+{
+    auto query1 = select({"id", "name"}) | from(table("users")) | where(binary_operation("age", binary_op::Gt, 18)) | or_else(binary_operation("name", binary_op::Like, "M%")) | offset(10) | limit(20);
+    auto query2 = select({"id", "name"}) | from(table("users")) | where(binary_operation("age", binary_op::Gt, 42)) | or_else(binary_operation("name", binary_op::Like, "it's")) | offset(0) | limit(5);
+
+    postgresql_renderer renderer{true};
+    ASSERT_TRUE(renderer.render(query1));
+    std::string sql = renderer.get_string();
+    EXPECT_EQ(sql, "SELECT id, name FROM users WHERE (age > $1 OR name LIKE $2) OFFSET $3 LIMIT $4");
+    ASSERT_EQ(renderer.get_parameters().size(), 4u);
+    EXPECT_EQ(renderer.get_parameters()[0].type, parameter_type::Integer);
+    EXPECT_EQ(renderer.get_parameters()[0].value, "18");
+    EXPECT_EQ(renderer.get_parameters()[1].type, parameter_type::Text);
+    EXPECT_EQ(renderer.get_parameters()[1].value, "M%");
+
+    ASSERT_TRUE(renderer.render(query2));
+    EXPECT_EQ(renderer.get_string(), sql);
+    EXPECT_EQ(renderer.get_parameters()[1].value, "it's");
+
+    // inline literals are escaped
+    EXPECT_EQ(render(query2), "SELECT id, name FROM users WHERE (age > 42 OR name LIKE 'it''s') OFFSET 0 LIMIT 5");
+}
+
+TEST(Sql, Optimizer)
+{
+    auto number = [](const char *value)
+    { return sql_expr_t{sql_expr_type::NumberLiteral, value}; };
+    auto age = [] { return column("u", "age"); };
+
+    auto query1 = select() | column("u", "id") | alias(column("u", "name"), "name") | column("u", "id") |
+                  from(alias(table("users"), "u")) |
+                  join(alias(table("accounts"), "a"), join_kind::LeftJoin, column("u", "account_id"), column("a", "id"), true) |
+                  join(alias(table("roles"), "r"), join_kind::LeftJoin, column("u", "role_id"), column("r", "id"), true) |
+                  where(binary_operation(binary_operation(column("r", "name"), binary_op::Eq, sql_expr_t{sql_expr_type::StringLiteral, "admin"}), binary_op::And, binary_operation(number("1"), binary_op::Eq, number("1")))) |
+                  where(binary_operation(age(), binary_op::Gt, number("18"))) | or_else(binary_operation(age(), binary_op::Le, number("10"))) | or_else(binary_operation(age(), binary_op::Eq, number("15")));
+    optimize(query1);
+    EXPECT_EQ(render(query1), "SELECT u.id, u.name, u.id FROM users as u LEFT JOIN roles as r ON u.role_id = r.id WHERE ((r.name = 'admin' AND u.age > 18) OR u.age < 10 OR u.age = 15)");
+
+    auto query2 = select({"id"}) | from(table("users")) | where(binary_operation(number("2"), binary_op::Lq, number("1")));
+    optimize(query2);
+    EXPECT_EQ(render(query2), "SELECT id FROM users WHERE FALSE");
+
+    auto subquery = select() | alias(column("u", "id"), "user_id") | column("u", "age") | from(alias(table("users"), "u"));
+    auto query3 = select({"user_id"}) | from(alias(subquery, "s")) |
+                  where(binary_operation(column("s", "age"), binary_op::Gt, number("18"))) |
+                  where(binary_operation(number("2"), binary_op::Gt, number("1")));
+    optimize(query3);
+    EXPECT_EQ(render(query3), "SELECT user_id FROM (SELECT u.id as user_id, u.age FROM users as u WHERE u.age > 18) as s");
+    // shared subquery is not changed
+    EXPECT_EQ(render(subquery), "SELECT u.id as user_id, u.age FROM users as u");
+
+    // window function counts rows before outer WHERE, so it is not pushed down
+    auto counted = select() | column("u", "age") | column_t{alias(window(count_all()), "total_count")} | from(alias(table("users"), "u"));
+    auto query4 = select({"age"}) | from(alias(counted, "s")) | where(binary_operation(column("s", "age"), binary_op::Gt, number("18")));
+    optimize(query4);
+    EXPECT_EQ(render(query4), "SELECT age FROM (SELECT u.age, count(*) OVER () as total_count FROM users as u) as s WHERE s.age > 18");
+
+    // unused lateral join to one row is removed
+    auto query5 = select() | column("u", "id") | from(alias(table("users"), "u")) |
+                  lateral_join(alias(select() | column("a", "name") | from(alias(table("accounts"), "a")), "a"), true) |
+                  lateral_join(alias(select() | column("r", "name") | from(alias(table("roles"), "r")), "r"));
+    optimize(query5);
+    EXPECT_EQ(render(query5), "SELECT u.id FROM users as u LEFT JOIN LATERAL (SELECT r.name FROM roles as r) as r ON TRUE");
 }
\ No newline at end of file